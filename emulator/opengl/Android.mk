@@ -71,11 +71,19 @@ include $(EMUGL_PATH)/host/libs/libOpenglRender/Android.mk
 
 # Host executables
 include $(EMUGL_PATH)/host/renderer/Android.mk
+include $(EMUGL_PATH)/host/tools/renderer_replay/Android.mk
 
 # Host unit-test for the renderer.
 
 include $(EMUGL_PATH)/tests/translator_tests/MacCommon/Android.mk
 include $(EMUGL_PATH)/tests/translator_tests/GLES_CM/Android.mk
 include $(EMUGL_PATH)/tests/translator_tests/GLES_V2/Android.mk
+include $(EMUGL_PATH)/tests/decoder_bench/Android.mk
+include $(EMUGL_PATH)/tests/tcp_compress_bench/Android.mk
+include $(EMUGL_PATH)/tests/framebuffer_tests/Android.mk
+include $(EMUGL_PATH)/tests/readback_bench/Android.mk
+include $(EMUGL_PATH)/tests/handle_stress_bench/Android.mk
+include $(EMUGL_PATH)/tests/vbo_bench/Android.mk
+include $(EMUGL_PATH)/tests/vertex_conversion_bench/Android.mk
 
 endif # BUILD_EMULATOR_OPENGL == true
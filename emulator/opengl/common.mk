@@ -189,11 +189,14 @@ emugl-dump-module = \
 # be automatically added to your LOCAL_C_INCLUDES.
 #
 # Usage:
-#    $(call emugl-gen-decoder,<input-dir>,<basename>)
+#    $(call emugl-gen-decoder,<input-dir>,<basename>[,<backend>])
+#
+# <backend> is the emugen decoder backend, 'table' by default or 'switch'
+# (see host/tools/emugen/README).
 #
 emugl-gen-decoder = \
     $(eval _emugl_out := $(call local-intermediates-dir))\
-    $(call emugl-gen-decoder-generic,$(_emugl_out),$1,$2)\
+    $(call emugl-gen-decoder-generic,$(_emugl_out),$1,$2,$(if $3,$3,table))\
     $(call emugl-export,C_INCLUDES,$(_emugl_out))
 
 # DO NOT CALL DIRECTLY, USE emugl-gen-decoder instead.
@@ -201,11 +204,15 @@ emugl-gen-decoder = \
 # The following function can be called to generate wire protocol decoder
 # source files, Usage is:
 #
-#  $(call emugl-gen-decoder-generic,<dst-dir>,<src-dir>,<basename>)
+#  $(call emugl-gen-decoder-generic,<dst-dir>,<src-dir>,<basename>,<backend>)
 #
 #  <dst-dir> is the destination directory where the generated sources are stored
 #  <src-dir> is the source directory where to find <basename>.attrib, etc..
 #  <basename> is the emugen basename (see host/tools/emugen/README)
+#  <backend> is the emugen decoder backend
+#
+#  The decoders are generated with -F, i.e. they do not flush their
+#  replies, the decode loop flushes the stream once it runs out of input.
 #
 emugl-gen-decoder-generic = $(eval $(emugl-gen-decoder-generic-ev))
 
@@ -219,7 +226,7 @@ GEN := $$(_emugl_dec)_dec.cpp \
        $$(_emugl_dec)_server_context.cpp
 
 $$(GEN): PRIVATE_PATH := $$(LOCAL_PATH)
-$$(GEN): PRIVATE_CUSTOM_TOOL := $$(EMUGL_EMUGEN) -D $$1 -i $$2 $$3
+$$(GEN): PRIVATE_CUSTOM_TOOL := $$(EMUGL_EMUGEN) -F -B $$4 -D $$1 -i $$2 $$3
 $$(GEN): $$(EMUGL_EMUGEN) $$(_emugl_src).attrib $$(_emugl_src).in $$(_emugl_src).types
 	$$(transform-generated-source)
 
@@ -228,6 +235,79 @@ LOCAL_GENERATED_SOURCES += $$(GEN)
 LOCAL_C_INCLUDES += $$1
 endef
 
+# This function can be called to generate the encoder source files.
+# LOCAL_MODULE and LOCAL_MODULE_CLASS must be defined or the build will abort.
+# Source files will be stored in the local intermediates directory that will
+# be automatically added to your LOCAL_C_INCLUDES.
+#
+# Usage:
+#    $(call emugl-gen-encoder,<input-dir>,<basename>[,<flags>])
+#
+# <flags> are extra emugen options. Pass -R only when the encoder writes to
+# a stream implementing IOStream::allocRef(), i.e. the host one, the guest
+# IOStream does not have it (see host/tools/emugen/README).
+#
+emugl-gen-encoder = \
+    $(eval _emugl_out := $(call local-intermediates-dir))\
+    $(call emugl-gen-encoder-generic,$(_emugl_out),$1,$2,$3)\
+    $(call emugl-export,C_INCLUDES,$(_emugl_out))
+
+# DO NOT CALL DIRECTLY, USE emugl-gen-encoder instead.
+emugl-gen-encoder-generic = $(eval $(emugl-gen-encoder-generic-ev))
+
+define emugl-gen-encoder-generic-ev
+_emugl_enc := $$1/$$3
+_emugl_src := $$2/$$3
+GEN := $$(_emugl_enc)_entry.cpp \
+       $$(_emugl_enc)_client_context.cpp \
+       $$(_emugl_enc)_enc.cpp \
+       $$(_emugl_enc)_enc.h \
+       $$(_emugl_enc)_opcodes.h \
+       $$(_emugl_enc)_client_context.h \
+       $$(_emugl_enc)_client_proc.h \
+       $$(_emugl_enc)_ftable.h
+
+$$(GEN): PRIVATE_PATH := $$(LOCAL_PATH)
+$$(GEN): PRIVATE_CUSTOM_TOOL := $$(EMUGL_EMUGEN) $$4 -E $$1 -i $$2 $$3
+$$(GEN): $$(EMUGL_EMUGEN) $$(_emugl_src).attrib $$(_emugl_src).in $$(_emugl_src).types
+	$$(transform-generated-source)
+
+$$(call emugl-export,ADDITIONAL_DEPENDENCIES,$$(GEN))
+LOCAL_GENERATED_SOURCES += $$(GEN)
+LOCAL_C_INCLUDES += $$1
+endef
+
+# This function can be called to generate a dispatcher which routes each
+# packet of a stream to one of several decoders according to the opcode
+# range of their .attrib 'base_opcode'. The module must import the decoders.
+# Source files will be stored in the local intermediates directory that will
+# be automatically added to your LOCAL_C_INCLUDES.
+#
+# Usage:
+#    $(call emugl-gen-dispatcher,<name>,<input-dir>/<basename> ...)
+#
+# This generates <name>_dispatch.h and <name>_dispatch.cpp
+#
+emugl-gen-dispatcher = \
+    $(eval _emugl_out := $(call local-intermediates-dir))\
+    $(call emugl-gen-dispatcher-generic,$(_emugl_out),$1,$2)
+
+# DO NOT CALL DIRECTLY, USE emugl-gen-dispatcher instead.
+emugl-gen-dispatcher-generic = $(eval $(emugl-gen-dispatcher-generic-ev))
+
+define emugl-gen-dispatcher-generic-ev
+GEN := $$1/$$2_dispatch.cpp \
+       $$1/$$2_dispatch.h
+
+$$(GEN): PRIVATE_PATH := $$(LOCAL_PATH)
+$$(GEN): PRIVATE_CUSTOM_TOOL := $$(EMUGL_EMUGEN) -M $$1 $$2 $$3
+$$(GEN): $$(EMUGL_EMUGEN) $$(foreach _spec,$$3,$$(_spec).attrib $$(_spec).in $$(_spec).types)
+	$$(transform-generated-source)
+
+LOCAL_GENERATED_SOURCES += $$(GEN)
+LOCAL_C_INCLUDES += $$1
+endef
+
 # Call this function when your shared library must be placed in a non-standard
 # library path (i.e. not under /system/lib
 # $1: library sub-path,relative to /system/lib
@@ -18,16 +18,33 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "ErrorLog.h"
 
+//
+// A piece of outgoing data for IOStream::writeV().
+//
+struct IOStreamSegment {
+    const void *base;
+    size_t      len;
+};
+
+// maximum number of segments queued before a flush is forced
+#define IOSTREAM_MAX_SEGMENTS   16
+// payloads smaller than this are copied by allocRef() rather than queued
+#define IOSTREAM_MIN_REF_SIZE   4096
+
 class IOStream {
 public:
 
     IOStream(size_t bufSize) {
         m_buf = NULL;
         m_bufsize = bufSize;
+        m_baseSize = bufSize;
         m_free = 0;
+        m_segStart = 0;
+        m_nsegs = 0;
     }
 
     virtual void *allocBuffer(size_t minSize) = 0;
@@ -36,6 +53,35 @@ public:
     virtual const unsigned char *read( void *buf, size_t *inout_len) = 0;
     virtual int writeFully(const void* buf, size_t len) = 0;
 
+    //
+    // Optional zero-copy receive interface, implemented by streams whose
+    // incoming data is directly addressable (e.g. a shared-memory ring).
+    // peekIn() blocks until at least 'minSize' contiguous bytes are
+    // available, or until the stream cannot buffer any more, and returns
+    // a pointer to them with the available amount in 'out_avail'.
+    // Returns NULL when the stream is closed. The bytes stay valid until
+    // they are released with consumeIn().
+    //
+    virtual bool canPeek() const { return false; }
+    virtual const unsigned char *peekIn(size_t minSize, size_t *out_avail) { return NULL; }
+    virtual void consumeIn(size_t len) { }
+
+    //
+    // Optional gather-write interface, implemented by streams which can
+    // send several discontiguous buffers in one operation. writeV() must
+    // send the segments in order and return 0 on success.
+    //
+    virtual bool canWriteV() const { return false; }
+    virtual int writeV(const IOStreamSegment *segs, int count) {
+        for (int i = 0; i < count; i++) {
+            int stat = writeFully(segs[i].base, segs[i].len);
+            if (stat < 0) {
+                return stat;
+            }
+        }
+        return 0;
+    }
+
     virtual ~IOStream() {
 
         // NOTE: m_buf is 'owned' by the child class thus we expect it to be released by it
@@ -68,16 +114,71 @@ public:
         return ptr;
     }
 
-    int flush() {
+    //
+    // allocRef - queue 'len' bytes of caller-owned memory to be sent after
+    // everything alloc()'d so far, without copying them into the stream
+    // buffer. The memory must stay valid until the next flush(). Small
+    // payloads are copied. Streams without writeV() support send large
+    // ones right away: what was alloc()'d is flushed, then the payload
+    // is written from the caller's memory.
+    //
+    int allocRef(const void *buf, size_t len) {
 
-        if (!m_buf || m_free == m_bufsize) return 0;
+        if (len == 0) return 0;
+
+        if (!canWriteV() && len >= IOSTREAM_MIN_REF_SIZE) {
+            if (flush() < 0) {
+                ERR("Failed to flush in allocRef\n");
+                return -1;
+            }
+            return writeFully(buf, len);
+        }
 
-        int stat = commitBuffer(m_bufsize - m_free);
+        if (len < IOSTREAM_MIN_REF_SIZE) {
+            unsigned char *ptr = alloc(len);
+            if (!ptr) {
+                return -1;
+            }
+            memcpy(ptr, buf, len);
+            return 0;
+        }
+
+        if (m_nsegs + 3 > IOSTREAM_MAX_SEGMENTS && flush() < 0) {
+            ERR("Failed to flush in allocRef\n");
+            return -1;
+        }
+
+        closeSegment();
+        m_segs[m_nsegs].base = buf;
+        m_segs[m_nsegs].len = len;
+        m_nsegs++;
+        return 0;
+    }
+
+    int flush() {
+
+        int stat;
+        if (m_nsegs > 0) {
+            closeSegment();
+            stat = writeV(m_segs, m_nsegs);
+            m_nsegs = 0;
+            m_segStart = 0;
+        }
+        else {
+            if (!m_buf || m_free == m_bufsize) return 0;
+            stat = commitBuffer(m_bufsize - m_free);
+        }
         m_buf = NULL;
         m_free = 0;
+        m_bufsize = m_baseSize;
         return stat;
     }
 
+    // number of bytes alloc()'d since the last flush()
+    size_t pending() const {
+        return m_buf ? m_bufsize - m_free : 0;
+    }
+
     const unsigned char *readback(void *buf, size_t len) {
         flush();
         return readFully(buf, len);
@@ -85,18 +186,39 @@ public:
 
 
 private:
+    // queue the data alloc()'d since the last queued segment
+    void closeSegment() {
+        size_t used = m_buf ? m_bufsize - m_free : 0;
+        if (used > m_segStart) {
+            m_segs[m_nsegs].base = m_buf + m_segStart;
+            m_segs[m_nsegs].len = used - m_segStart;
+            m_nsegs++;
+            m_segStart = used;
+        }
+    }
+
     unsigned char *m_buf;
     size_t m_bufsize;
+    size_t m_baseSize;
     size_t m_free;
+    size_t m_segStart;
+    IOStreamSegment m_segs[IOSTREAM_MAX_SEGMENTS];
+    int m_nsegs;
 };
 
 //
 // When a client opens a connection to the renderer, it should
 // send unsigned int value indicating the "clientFlags".
 // The following are the bitmask of the clientFlags.
-// currently only one bit is used which flags the server
-// it should exit.
+// IOSTREAM_CLIENT_EXIT_SERVER flags the server it should exit.
+//
+// IOSTREAM_CLIENT_COMPRESS asks for compressed data. The server then
+// answers with an unsigned int holding IOSTREAM_CLIENT_COMPRESS if the
+// stream supports it, or 0, and when it does both ends enable the
+// compression right after that answer. Only ask servers which know
+// about this flag, older ones do not answer.
 //
 #define IOSTREAM_CLIENT_EXIT_SERVER      1
+#define IOSTREAM_CLIENT_COMPRESS         2
 
 #endif
@@ -55,10 +55,26 @@ DECL(int, initLibrary, (void));
 #define STREAM_MODE_TCP       1
 #define STREAM_MODE_UNIX      2
 #define STREAM_MODE_PIPE      3
+#define STREAM_MODE_SHM       4
 
-/* Change the stream mode. This must be called before initOpenGLRenderer */
+/* Change the stream mode. This must be called before initOpenGLRenderer.
+ * In TCP mode, the connections opened by the renderer library ask for LZ4
+ * compression of their stream when RENDERER_STREAM_COMPRESS is set in
+ * the environment, see IOSTREAM_CLIENT_COMPRESS in IOStream.h.
+ */
 DECL(int, setStreamMode, (int mode));
 
+/* setHeadlessMode - when headless is not 0, the frames are never shown in
+ *     a window: createOpenGLSubwindow() fails and the posted frames only go
+ *     to the post callback, see setPostRate(). Headless mode is also
+ *     enabled by setting RENDERER_HEADLESS in the environment. This must be
+ *     called before initOpenGLRenderer.
+ *
+ *     The GLES translator still opens its default display to create its
+ *     contexts, a virtual X server is enough for it.
+ */
+DECL(int, setHeadlessMode, (int headless));
+
 /* initOpenGLRenderer - initialize the OpenGL renderer process.
  *
  * width and height are the framebuffer dimensions that will be reported to the
@@ -70,6 +86,8 @@ DECL(int, setStreamMode, (int mode));
  *     listening only on the loopback address.
  *   - Win32 and UNIX named pipes: The buffer contains the full path clients
  *     should connect to.
+ *   - SHM (Linux only): The buffer contains the path of the UNIX socket used
+ *     to set up the shared-memory rings; see ShmStream.h.
  *
  * This function is *NOT* thread safe and should be called first
  * to initialize the renderer after initLibrary().
@@ -93,6 +111,18 @@ DECL(void, getHardwareStrings, (const char** vendor, const char** renderer,
  * pixels buffer may be overwritten as soon as the callback returns; if it
  * needs the pixels afterwards it must copy them.
  *
+ * When the RENDERER_ASYNC_READBACK environment variable is set, the frames
+ * are read back on a thread of their own instead of blocking the posting
+ * thread: the callback is then called one or two frames after the frame is
+ * displayed, and frames may be dropped if the callback falls behind.
+ *
+ * Frames posted by the guest are shown by a presenter thread, which keeps
+ * only the latest frame waiting and paces them by the guest's swap interval
+ * on a 60Hz display. RENDERER_PRESENT_PACING may instead be set to
+ * "unthrottled" or to a fixed number of frames per second, and setting
+ * RENDERER_SYNC_POST shows each frame from the posting thread as before.
+ * Frames replaced before being shown are counted in the renderer metrics.
+ *
  * The pixels buffer is intentionally not const: the callback may modify the
  * data without copying to another buffer if it wants, e.g. in-place RGBA to
  * RGB conversion, or in-place y-inversion.
@@ -117,6 +147,66 @@ typedef void (*OnPostFn)(void* context, int width, int height, int ydir,
                          int format, int type, unsigned char* pixels);
 DECL(void, setPostCallback, (OnPostFn onPost, void* onPostContext));
 
+/* setPostRegionCallback() registers a per-frame callback like
+ * setPostCallback(), and replaces any callback registered with either
+ * function. Besides the image, it gets the rectangles of it which changed
+ * since its previous call; only those are read back from the GPU.
+ *
+ * The pixels buffer always holds the whole frame, the parts outside the
+ * rectangles being left from the previous frames, so unlike with
+ * setPostCallback() it must not be modified. The first frame has a single
+ * rectangle covering the whole image, and so does the first post of each
+ * color buffer. The damage of up to four color buffers swapped by the
+ * guest is tracked, each one being reported with what changed in it since
+ * it was last read back plus what the other ones changed meanwhile. A
+ * frame which did not change has no rectangle.
+ *
+ * Rectangles are in pixels, with rows counted in the same order as the
+ * rows of the pixels buffer (ydir), and do not overlap the image edges.
+ * Rendering by the guest through GL marks the whole color buffer as
+ * changed; only rcUpdateColorBuffer uploads have a finer granularity.
+ */
+typedef struct {
+    int x;
+    int y;
+    int width;
+    int height;
+} RenderRect;
+
+typedef void (*OnPostRegionFn)(void* context, int width, int height, int ydir,
+                               int format, int type,
+                               int numRects, const RenderRect* rects,
+                               const unsigned char* pixels);
+DECL(void, setPostRegionCallback, (OnPostRegionFn onPost, void* onPostContext));
+
+/* setPostRate - limit the frames delivered to the post callback: at most
+ *     framesPerSecond of them, every posted frame with POST_RATE_UNLIMITED
+ *     (the default), or only those asked for with requestPostFrame() with
+ *     POST_RATE_ON_DEMAND. Frames which are not delivered are not read
+ *     back; with a region callback, their rectangles go with the next
+ *     frame delivered.
+ */
+#define POST_RATE_UNLIMITED   0
+#define POST_RATE_ON_DEMAND   (-1)
+DECL(void, setPostRate, (int framesPerSecond));
+
+/* requestPostFrame - deliver the latest frame to the post callback, or the
+ *     next one if none was posted yet, whatever the post rate.
+ */
+DECL(void, requestPostFrame, (void));
+
+/* setFrameExport - export the posted frames to the POSIX shared memory
+ *     object 'name' (e.g. "/emulator-5554-frames"), for other processes
+ *     to read without a copy and without holding up the renderer. A frame
+ *     is only read back once the readers consumed the previous one. The
+ *     layout is described in render_frame_export.h. The object is created
+ *     or resized as needed and unlinked when the export stops, which a
+ *     NULL name does. Setting RENDERER_FRAME_EXPORT in the environment to
+ *     the name starts the export with the renderer. Not supported on
+ *     Windows.
+ */
+DECL(int, setFrameExport, (const char* name));
+
 /* createOpenGLSubwindow -
  *     Create a native subwindow which is a child of 'window'
  *     to be used for framebuffer display.
@@ -147,6 +237,73 @@ DECL(void, setOpenGLDisplayRotation, (float zRot));
  */
 DECL(void, repaintOpenGLDisplay, (void));
 
+/* Renderer metrics.
+ *
+ * When enabled, each connection to the renderer records how many packets it
+ * sent for every opcode, their size, the size of the replies and the time
+ * taken to decode and execute them. FrameBuffer posts are timed as well.
+ * Collection has a small per-packet cost and is disabled by default; it is
+ * also enabled by setting RENDERER_METRICS in the environment to the dump
+ * period in milliseconds (0 for no dump).
+ *
+ * Times are in microseconds. Bucket i of a histogram counts the samples
+ * which took from 2^(i-1) up to 2^i microseconds, bucket 0 those under one
+ * microsecond and the last bucket everything longer.
+ */
+#define RENDER_METRICS_HIST_BUCKETS   16
+#define RENDER_METRICS_MAX_STREAMS    32
+#define RENDER_METRICS_MAX_OPCODES    256
+
+typedef struct {
+    unsigned int       streamId;
+    unsigned int       opcode;
+    unsigned long long calls;
+    unsigned long long bytes;        /* packet bytes, including headers */
+    unsigned long long replyBytes;
+    unsigned long long timeUs;       /* decode and execute time */
+    unsigned int       timeHist[RENDER_METRICS_HIST_BUCKETS];
+} RenderOpcodeMetrics;
+
+typedef struct {
+    unsigned int       streamId;     /* increases with each connection */
+    int                active;       /* 0 once the connection is closed */
+    unsigned long long ageMs;        /* time from first seen to now or close */
+    unsigned long long bytesReceived;
+    unsigned long long bytesReplied;
+    unsigned long long packets;
+    unsigned long long timeUs;       /* time spent decoding and executing */
+} RenderStreamMetrics;
+
+typedef struct {
+    unsigned long long  timeMs;      /* monotonic time of the snapshot */
+    /* open connections in connection order, then the most recently
+     * closed ones, up to RENDER_METRICS_MAX_STREAMS of them are kept */
+    unsigned int        numStreams;
+    RenderStreamMetrics streams[RENDER_METRICS_MAX_STREAMS];
+    /* per connection and opcode, the most time consuming first */
+    unsigned int        numOpcodes;
+    RenderOpcodeMetrics opcodes[RENDER_METRICS_MAX_OPCODES];
+    /* FrameBuffer posts, over the renderer's lifetime */
+    unsigned long long  posts;
+    unsigned long long  postTimeUs;
+    unsigned int        postHist[RENDER_METRICS_HIST_BUCKETS];
+    /* posts replaced by a later one before they could be presented */
+    unsigned long long  droppedPosts;
+} RenderMetricsSnapshot;
+
+/* setRenderMetrics - enable or disable metrics collection. While enabled
+ *     and if dumpPeriodMs is not 0, a summary is printed to stdout at most
+ *     once every dumpPeriodMs milliseconds. Disabling discards the metrics
+ *     collected so far.
+ */
+DECL(void, setRenderMetrics, (int enable, int dumpPeriodMs));
+
+/* getRenderMetrics - fill 'snapshot' with the current metrics.
+ *     Fails if metrics collection is not enabled. Connections and opcodes
+ *     beyond the capacity of the snapshot arrays are left out.
+ */
+DECL(int, getRenderMetrics, (RenderMetricsSnapshot* snapshot));
+
 /* stopOpenGLRenderer - stops the OpenGL renderer process.
  *     This functions is *NOT* thread safe and should be called
  *     only if previous initOpenGLRenderer has returned true.
@@ -0,0 +1,79 @@
+/*
+* Copyright 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _RENDER_FRAME_EXPORT_H
+#define _RENDER_FRAME_EXPORT_H
+
+/* Layout of the shared memory the posted frames are exported to, see
+ * setFrameExport() in render_api.h. This header is usable from C code and
+ * by programs which do not link with the renderer.
+ *
+ * The memory starts with a RenderFrameExportHeader, followed by the
+ * pixels of RENDER_FRAME_EXPORT_SLOTS frames. The renderer writes each
+ * frame to the slot after 'latest', so a reader is never waited for, and
+ * publishes it by updating 'latest'. The sequence number of a slot is odd
+ * while the slot is written.
+ *
+ * To read the newest frame in place:
+ *
+ *   1. check that 'magic' is RENDER_FRAME_EXPORT_MAGIC, then read
+ *      'latest'; ~0 means no frame was exported yet,
+ *   2. read the slot's 'seq', start over if it is odd,
+ *   3. after a read barrier, use the slot's pixels and fields,
+ *   4. after a read barrier, read 'seq' again: if it changed, the renderer
+ *      overwrote the slot meanwhile, anything taken from it is garbage.
+ *
+ * A reader taking longer than two frames to do so will see the second
+ * check fail, it can then copy the pixels out before using them.
+ *
+ * Once done, the reader stores the frame's 'frameNumber' to 'consumed',
+ * so the memory must be mapped writable. A frame is read back from the
+ * GPU only if the newest one exported was consumed: the frames posted
+ * meanwhile are not exported, and the one posted last is exported by the
+ * next post, or by repaintOpenGLDisplay() when the display is idle.
+ */
+
+#include <stdint.h>
+
+#define RENDER_FRAME_EXPORT_MAGIC    0x58464752   /* 'RGFX' */
+#define RENDER_FRAME_EXPORT_VERSION  2
+#define RENDER_FRAME_EXPORT_SLOTS    3
+#define RENDER_FRAME_EXPORT_NONE     0xffffffffU
+
+typedef struct {
+    volatile uint32_t  seq;
+    uint32_t           reserved;
+    uint64_t           frameNumber;  /* 1 for the first frame exported */
+    uint64_t           timestampUs;  /* monotonic time of the post */
+    uint64_t           offset;       /* of the pixels, from the header */
+} RenderFrameExportSlot;
+
+typedef struct {
+    volatile uint32_t  magic;        /* set once the rest is valid */
+    uint32_t           version;
+    uint32_t           width;
+    uint32_t           height;
+    uint32_t           format;       /* GL_RGBA */
+    uint32_t           type;         /* GL_UNSIGNED_BYTE */
+    int32_t            ydir;         /* 1, the top row first */
+    uint32_t           stride;       /* bytes from one row to the next */
+    volatile uint32_t  latest;       /* slot of the newest frame */
+    uint32_t           reserved;
+    volatile uint64_t  consumed;     /* written by the readers, 0 at first */
+    RenderFrameExportSlot slots[RENDER_FRAME_EXPORT_SLOTS];
+} RenderFrameExportHeader;
+
+#endif
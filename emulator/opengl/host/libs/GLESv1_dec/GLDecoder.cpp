@@ -78,6 +78,13 @@ int GLDecoder::initGL(get_proc_func_t getProcFunc, void *getProcFuncData)
     return 0;
 }
 
+void GLDecoder::initGLFrom(const GLDecoder &proto)
+{
+    // the table already holds the overrides installed by initGL(). When
+    // it was loaded from m_glesDso, the prototype must outlive this copy.
+    gl_server_context_t::operator=(proto);
+}
+
 int GLDecoder::s_glFinishRoundTrip(void *self)
 {
     GLDecoder *ctx = (GLDecoder *)self;
@@ -32,6 +32,9 @@ public:
     GLDecoder();
     ~GLDecoder();
     int initGL(get_proc_func_t getProcFunc = NULL, void *getProcFuncData = NULL);
+    // copy the dispatch table of a decoder initialized with initGL(),
+    // instead of resolving every entry point again
+    void initGLFrom(const GLDecoder &proto);
     void setContextData(GLDecoderContextData *contextData) { m_contextData = contextData; }
 
 private:
@@ -79,6 +79,13 @@ int GL2Decoder::initGL(get_proc_func_t getProcFunc, void *getProcFuncData)
 
 }
 
+void GL2Decoder::initGLFrom(const GL2Decoder &proto)
+{
+    // the table already holds the overrides installed by initGL(). When
+    // it was loaded from m_GL2library, the prototype must outlive this copy.
+    gl2_server_context_t::operator=(proto);
+}
+
 int GL2Decoder::s_glFinishRoundTrip(void *self)
 {
     GL2Decoder *ctx = (GL2Decoder *)self;
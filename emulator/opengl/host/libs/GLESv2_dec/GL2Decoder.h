@@ -32,6 +32,9 @@ public:
     GL2Decoder();
     ~GL2Decoder();
     int initGL(get_proc_func_t getProcFunc = NULL, void *getProcFuncData = NULL);
+    // copy the dispatch table of a decoder initialized with initGL(),
+    // instead of resolving every entry point again
+    void initGLFrom(const GL2Decoder &proto);
     void setContextData(GLDecoderContextData *contextData) { m_contextData = contextData; }
 private:
     GLDecoderContextData *m_contextData;
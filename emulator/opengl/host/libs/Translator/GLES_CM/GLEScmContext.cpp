@@ -68,7 +68,6 @@ GLEScmContext::~GLEScmContext(){
 
 //setting client side arr
 void GLEScmContext::setupArr(const GLvoid* arr,GLenum arrayType,GLenum dataType,GLint size,GLsizei stride,GLboolean normalized, int index){
-    if( arr == NULL) return;
     switch(arrayType) {
         case GL_VERTEX_ARRAY:
             s_glDispatch.glVertexPointer(size,dataType,stride,arr);
@@ -96,16 +95,17 @@ void GLEScmContext::setupArrayPointerHelper(GLESConversionArrays& cArrs,GLint fi
         if(needConvert(cArrs,first,count,type,indices,direct,p,array_id)){
             //conversion has occured
             ArrayData currentArr = cArrs.getCurrentArray();
-            setupArr(currentArr.data,array_id,currentArr.type,size,currentArr.stride,GL_FALSE, cArrs.getCurrentIndex());
+            setupArr(bindArrayData(p,&currentArr),array_id,currentArr.type,size,currentArr.stride,GL_FALSE, cArrs.getCurrentIndex());
             ++cArrs;
-        } else {
-            setupArr(p->getData(),array_id,dataType,size,p->getStride(), GL_FALSE);
+        } else if(p->getData()) {
+            setupArr(bindArrayData(p,NULL),array_id,dataType,size,p->getStride(), GL_FALSE);
         }
 }
 
 void GLEScmContext::setupArraysPointers(GLESConversionArrays& cArrs,GLint first,GLsizei count,GLenum type,const GLvoid* indices,bool direct) {
     ArraysMap::iterator it;
     m_pointsIndex = -1;
+    startDraw();
 
     //going over all clients arrays Pointers
     for ( it=m_map.begin() ; it != m_map.end(); it++ ) {
@@ -138,6 +138,7 @@ void GLEScmContext::setupArraysPointers(GLESConversionArrays& cArrs,GLint first,
 
     setClientActiveTexture(activeTexture);
     s_glDispatch.glClientActiveTexture(activeTexture);
+    bindHostArrayBuffer(0);
 }
 
 void  GLEScmContext::drawPointsData(GLESConversionArrays& cArrs,GLint first,GLsizei count,GLenum type,const GLvoid* indices_in,bool isElemsDraw) {
@@ -270,21 +270,21 @@ GL_API void GL_APIENTRY  glActiveTexture( GLenum texture) {
 }
 
 GL_API void GL_APIENTRY  glAlphaFunc( GLenum func, GLclampf ref) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::alphaFunc(func),GL_INVALID_ENUM);
     ctx->dispatcher().glAlphaFunc(func,ref);
 }
 
 
 GL_API void GL_APIENTRY  glAlphaFuncx( GLenum func, GLclampx ref) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::alphaFunc(func),GL_INVALID_ENUM);
     ctx->dispatcher().glAlphaFunc(func,X2F(ref));
 }
 
 
 GL_API void GL_APIENTRY  glBindBuffer( GLenum target, GLuint buffer) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::bufferTarget(target),GL_INVALID_ENUM);
 
     //if buffer wasn't generated before,generate one
@@ -301,7 +301,7 @@ GL_API void GL_APIENTRY  glBindBuffer( GLenum target, GLuint buffer) {
 
 
 GL_API void GL_APIENTRY  glBindTexture( GLenum target, GLuint texture) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::textureTarget(target),GL_INVALID_ENUM)
 
     //for handling default texture (0)
@@ -329,55 +329,55 @@ GL_API void GL_APIENTRY  glBindTexture( GLenum target, GLuint texture) {
 }
 
 GL_API void GL_APIENTRY  glBlendFunc( GLenum sfactor, GLenum dfactor) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::blendSrc(sfactor) || !GLEScmValidate::blendDst(dfactor),GL_INVALID_ENUM)
     ctx->dispatcher().glBlendFunc(sfactor,dfactor);
 }
 
 GL_API void GL_APIENTRY  glBufferData( GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::bufferTarget(target),GL_INVALID_ENUM);
     SET_ERROR_IF(!ctx->isBindedBuffer(target),GL_INVALID_OPERATION);
     ctx->setBufferData(target,size,data,usage);
 }
 
 GL_API void GL_APIENTRY  glBufferSubData( GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid *data) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!ctx->isBindedBuffer(target),GL_INVALID_OPERATION);
     SET_ERROR_IF(!GLEScmValidate::bufferTarget(target),GL_INVALID_ENUM);
     SET_ERROR_IF(!ctx->setBufferSubData(target,offset,size,data),GL_INVALID_VALUE);
 }
 
 GL_API void GL_APIENTRY  glClear( GLbitfield mask) {
-    GET_CTX()
+    GET_CTX();
     ctx->drawValidate();
 
     ctx->dispatcher().glClear(mask);
 }
 
 GL_API void GL_APIENTRY  glClearColor( GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glClearColor(red,green,blue,alpha);
 }
 
 GL_API void GL_APIENTRY  glClearColorx( GLclampx red, GLclampx green, GLclampx blue, GLclampx alpha) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glClearColor(X2F(red),X2F(green),X2F(blue),X2F(alpha));
 }
 
 
 GL_API void GL_APIENTRY  glClearDepthf( GLclampf depth) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glClearDepth(depth);
 }
 
 GL_API void GL_APIENTRY  glClearDepthx( GLclampx depth) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glClearDepth(X2F(depth));
 }
 
 GL_API void GL_APIENTRY  glClearStencil( GLint s) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glClearStencil(s);
 }
 
@@ -390,7 +390,7 @@ GL_API void GL_APIENTRY  glClientActiveTexture( GLenum texture) {
 }
 
 GL_API void GL_APIENTRY  glClipPlanef( GLenum plane, const GLfloat *equation) {
-    GET_CTX()
+    GET_CTX();
     GLdouble tmpEquation[4];
 
     for(int i = 0; i < 4; i++) {
@@ -400,7 +400,7 @@ GL_API void GL_APIENTRY  glClipPlanef( GLenum plane, const GLfloat *equation) {
 }
 
 GL_API void GL_APIENTRY  glClipPlanex( GLenum plane, const GLfixed *equation) {
-    GET_CTX()
+    GET_CTX();
     GLdouble tmpEquation[4];
     for(int i = 0; i < 4; i++) {
         tmpEquation[i] = X2D(equation[i]);
@@ -409,27 +409,27 @@ GL_API void GL_APIENTRY  glClipPlanex( GLenum plane, const GLfixed *equation) {
 }
 
 GL_API void GL_APIENTRY  glColor4f( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glColor4f(red,green,blue,alpha);
 }
 
 GL_API void GL_APIENTRY  glColor4ub( GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glColor4ub(red,green,blue,alpha);
 }
 
 GL_API void GL_APIENTRY  glColor4x( GLfixed red, GLfixed green, GLfixed blue, GLfixed alpha) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glColor4f(X2F(red),X2F(green),X2F(blue),X2F(alpha));
 }
 
 GL_API void GL_APIENTRY  glColorMask( GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glColorMask(red,green,blue,alpha);
 }
 
 GL_API void GL_APIENTRY  glColorPointer( GLint size, GLenum type, GLsizei stride, const GLvoid *pointer) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::colorPointerParams(size,stride),GL_INVALID_VALUE);
     SET_ERROR_IF(!GLEScmValidate::colorPointerType(type),GL_INVALID_ENUM);
     ctx->setPointer(GL_COLOR_ARRAY,size,type,stride,pointer);
@@ -456,36 +456,38 @@ GL_API void GL_APIENTRY  glCompressedTexSubImage2D( GLenum target, GLint level,
 }
 
 GL_API void GL_APIENTRY  glCopyTexImage2D( GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!(GLEScmValidate::pixelFrmt(ctx,internalformat) && GLEScmValidate::textureTargetEx(target)),GL_INVALID_ENUM);
     SET_ERROR_IF(border != 0,GL_INVALID_VALUE);
     ctx->dispatcher().glCopyTexImage2D(target,level,internalformat,x,y,width,height,border);
 }
 
 GL_API void GL_APIENTRY  glCopyTexSubImage2D( GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::textureTargetEx(target),GL_INVALID_ENUM);
     ctx->dispatcher().glCopyTexSubImage2D(target,level,xoffset,yoffset,x,y,width,height);
 }
 
 GL_API void GL_APIENTRY  glCullFace( GLenum mode) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glCullFace(mode);
 }
 
 GL_API void GL_APIENTRY  glDeleteBuffers( GLsizei n, const GLuint *buffers) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(n<0,GL_INVALID_VALUE);
     if(ctx->shareGroup().Ptr()) {
         for(int i=0; i < n; i++){
+           const GLuint globalBufferName = ctx->shareGroup()->getGlobalName(VERTEXBUFFER,buffers[i]);
            ctx->shareGroup()->deleteName(VERTEXBUFFER,buffers[i]);
            ctx->unbindBuffer(buffers[i]);
+           if(globalBufferName) ctx->dispatcher().glDeleteBuffers(1,&globalBufferName);
         }
     }
 }
 
 GL_API void GL_APIENTRY  glDeleteTextures( GLsizei n, const GLuint *textures) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(n<0,GL_INVALID_VALUE);
     if(ctx->shareGroup().Ptr()) {
         for(int i=0; i < n; i++){
@@ -510,27 +512,27 @@ GL_API void GL_APIENTRY  glDeleteTextures( GLsizei n, const GLuint *textures) {
 }
 
 GL_API void GL_APIENTRY  glDepthFunc( GLenum func) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glDepthFunc(func);
 }
 
 GL_API void GL_APIENTRY  glDepthMask( GLboolean flag) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glDepthMask(flag);
 }
 
 GL_API void GL_APIENTRY  glDepthRangef( GLclampf zNear, GLclampf zFar) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glDepthRange(zNear,zFar);
 }
 
 GL_API void GL_APIENTRY  glDepthRangex( GLclampx zNear, GLclampx zFar) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glDepthRange(X2F(zNear),X2F(zFar));
 }
 
 GL_API void GL_APIENTRY  glDisable( GLenum cap) {
-    GET_CTX()
+    GET_CTX();
     if (cap==GL_TEXTURE_GEN_STR_OES) {
         ctx->dispatcher().glDisable(GL_TEXTURE_GEN_S);
         ctx->dispatcher().glDisable(GL_TEXTURE_GEN_T);
@@ -542,7 +544,7 @@ GL_API void GL_APIENTRY  glDisable( GLenum cap) {
 }
 
 GL_API void GL_APIENTRY  glDisableClientState( GLenum array) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::supportedArrays(array),GL_INVALID_ENUM)
 
     ctx->enableArr(array,false);
@@ -589,13 +591,18 @@ GL_API void GL_APIENTRY  glDrawElements( GLenum mode, GLsizei count, GLenum type
     if(mode == GL_POINTS && ctx->isArrEnabled(GL_POINT_SIZE_ARRAY_OES)){
         ctx->drawPointsElems(tmpArrs,count,type,indices);
     }
+    else if(ctx->isBindedBuffer(GL_ELEMENT_ARRAY_BUFFER)){
+        ctx->dispatcher().glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,ctx->getBindedBufferHostName(GL_ELEMENT_ARRAY_BUFFER));
+        ctx->dispatcher().glDrawElements(mode,count,type,elementsIndices);
+        ctx->dispatcher().glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
+    }
     else{
         ctx->dispatcher().glDrawElements(mode,count,type,indices);
     }
 }
 
 GL_API void GL_APIENTRY  glEnable( GLenum cap) {
-    GET_CTX()
+    GET_CTX();
     if (cap==GL_TEXTURE_GEN_STR_OES) {
         ctx->dispatcher().glEnable(GL_TEXTURE_GEN_S);
         ctx->dispatcher().glEnable(GL_TEXTURE_GEN_T);
@@ -608,7 +615,7 @@ GL_API void GL_APIENTRY  glEnable( GLenum cap) {
 }
 
 GL_API void GL_APIENTRY  glEnableClientState( GLenum array) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::supportedArrays(array),GL_INVALID_ENUM)
 
     ctx->enableArr(array,true);
@@ -616,32 +623,32 @@ GL_API void GL_APIENTRY  glEnableClientState( GLenum array) {
 }
 
 GL_API void GL_APIENTRY  glFinish( void) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glFinish();
 }
 
 GL_API void GL_APIENTRY  glFlush( void) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glFlush();
 }
 
 GL_API void GL_APIENTRY  glFogf( GLenum pname, GLfloat param) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glFogf(pname,param);
 }
 
 GL_API void GL_APIENTRY  glFogfv( GLenum pname, const GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glFogfv(pname,params);
 }
 
 GL_API void GL_APIENTRY  glFogx( GLenum pname, GLfixed param) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glFogf(pname,(pname == GL_FOG_MODE)? static_cast<GLfloat>(param):X2F(param));
 }
 
 GL_API void GL_APIENTRY  glFogxv( GLenum pname, const GLfixed *params) {
-    GET_CTX()
+    GET_CTX();
     if(pname == GL_FOG_MODE) {
         GLfloat tmpParam = static_cast<GLfloat>(params[0]);
         ctx->dispatcher().glFogfv(pname,&tmpParam);
@@ -656,22 +663,22 @@ GL_API void GL_APIENTRY  glFogxv( GLenum pname, const GLfixed *params) {
 }
 
 GL_API void GL_APIENTRY  glFrontFace( GLenum mode) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glFrontFace(mode);
 }
 
 GL_API void GL_APIENTRY  glFrustumf( GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat zNear, GLfloat zFar) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glFrustum(left,right,bottom,top,zNear,zFar);
 }
 
 GL_API void GL_APIENTRY  glFrustumx( GLfixed left, GLfixed right, GLfixed bottom, GLfixed top, GLfixed zNear, GLfixed zFar) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glFrustum(X2F(left),X2F(right),X2F(bottom),X2F(top),X2F(zNear),X2F(zFar));
 }
 
 GL_API void GL_APIENTRY  glGenBuffers( GLsizei n, GLuint *buffers) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(n<0,GL_INVALID_VALUE);
     if(ctx->shareGroup().Ptr()) {
         for(int i=0; i<n ;i++) {
@@ -692,7 +699,7 @@ GL_API void GL_APIENTRY  glGenTextures( GLsizei n, GLuint *textures) {
 }
 
 GL_API void GL_APIENTRY  glGetBooleanv( GLenum pname, GLboolean *params) {
-    GET_CTX()
+    GET_CTX();
 
     if(ctx->glGetBooleanv(pname, params))
     {
@@ -742,7 +749,7 @@ GL_API void GL_APIENTRY  glGetBooleanv( GLenum pname, GLboolean *params) {
 }
 
 GL_API void GL_APIENTRY  glGetBufferParameteriv( GLenum target, GLenum pname, GLint *params) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!(GLEScmValidate::bufferTarget(target) && GLEScmValidate::bufferParam(pname)),GL_INVALID_ENUM);
     SET_ERROR_IF(!ctx->isBindedBuffer(target),GL_INVALID_OPERATION);
     bool ret = true;
@@ -758,7 +765,7 @@ GL_API void GL_APIENTRY  glGetBufferParameteriv( GLenum target, GLenum pname, GL
 }
 
 GL_API void GL_APIENTRY  glGetClipPlanef( GLenum pname, GLfloat eqn[4]) {
-    GET_CTX()
+    GET_CTX();
     GLdouble tmpEqn[4];
 
     ctx->dispatcher().glGetClipPlane(pname,tmpEqn);
@@ -768,7 +775,7 @@ GL_API void GL_APIENTRY  glGetClipPlanef( GLenum pname, GLfloat eqn[4]) {
 }
 
 GL_API void GL_APIENTRY  glGetClipPlanex( GLenum pname, GLfixed eqn[4]) {
-    GET_CTX()
+    GET_CTX();
     GLdouble tmpEqn[4];
 
     ctx->dispatcher().glGetClipPlane(pname,tmpEqn);
@@ -778,7 +785,7 @@ GL_API void GL_APIENTRY  glGetClipPlanex( GLenum pname, GLfixed eqn[4]) {
 }
 
 GL_API void GL_APIENTRY  glGetFixedv( GLenum pname, GLfixed *params) {
-    GET_CTX()
+    GET_CTX();
 
     if(ctx->glGetFixedv(pname, params))
     {
@@ -825,7 +832,7 @@ GL_API void GL_APIENTRY  glGetFixedv( GLenum pname, GLfixed *params) {
 }
 
 GL_API void GL_APIENTRY  glGetFloatv( GLenum pname, GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
 
     if(ctx->glGetFloatv(pname, params))
     {
@@ -861,7 +868,7 @@ GL_API void GL_APIENTRY  glGetFloatv( GLenum pname, GLfloat *params) {
 }
 
 GL_API void GL_APIENTRY  glGetIntegerv( GLenum pname, GLint *params) {
-    GET_CTX()
+    GET_CTX();
 
     if(ctx->glGetIntegerv(pname, params))
     {
@@ -927,12 +934,12 @@ GL_API void GL_APIENTRY  glGetIntegerv( GLenum pname, GLint *params) {
 }
 
 GL_API void GL_APIENTRY  glGetLightfv( GLenum light, GLenum pname, GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glGetLightfv(light,pname,params);
 }
 
 GL_API void GL_APIENTRY  glGetLightxv( GLenum light, GLenum pname, GLfixed *params) {
-    GET_CTX()
+    GET_CTX();
     GLfloat tmpParams[4];
 
     ctx->dispatcher().glGetLightfv(light,pname,tmpParams);
@@ -961,12 +968,12 @@ GL_API void GL_APIENTRY  glGetLightxv( GLenum light, GLenum pname, GLfixed *para
 }
 
 GL_API void GL_APIENTRY  glGetMaterialfv( GLenum face, GLenum pname, GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glGetMaterialfv(face,pname,params);
 }
 
 GL_API void GL_APIENTRY  glGetMaterialxv( GLenum face, GLenum pname, GLfixed *params) {
-    GET_CTX()
+    GET_CTX();
     GLfloat tmpParams[4];
     ctx->dispatcher().glGetMaterialfv(face,pname,tmpParams);
     switch(pname){
@@ -989,7 +996,7 @@ GL_API void GL_APIENTRY  glGetMaterialxv( GLenum face, GLenum pname, GLfixed *pa
 }
 
 GL_API void GL_APIENTRY  glGetPointerv( GLenum pname, void **params) {
-    GET_CTX()
+    GET_CTX();
     const GLESpointer* p = ctx->getPointer(pname);
     if(p) {
         if(p->isVBO())
@@ -1005,17 +1012,17 @@ GL_API void GL_APIENTRY  glGetPointerv( GLenum pname, void **params) {
 }
 
 GL_API void GL_APIENTRY  glGetTexEnvfv( GLenum env, GLenum pname, GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glGetTexEnvfv(env,pname,params);
 }
 
 GL_API void GL_APIENTRY  glGetTexEnviv( GLenum env, GLenum pname, GLint *params) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glGetTexEnviv(env,pname,params);
 }
 
 GL_API void GL_APIENTRY  glGetTexEnvxv( GLenum env, GLenum pname, GLfixed *params) {
-    GET_CTX()
+    GET_CTX();
     GLfloat tmpParams[4];
 
     ctx->dispatcher().glGetTexEnvfv(env,pname,tmpParams);
@@ -1028,7 +1035,7 @@ GL_API void GL_APIENTRY  glGetTexEnvxv( GLenum env, GLenum pname, GLfixed *param
 }
 
 GL_API void GL_APIENTRY  glGetTexParameterfv( GLenum target, GLenum pname, GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
    if (pname==GL_TEXTURE_CROP_RECT_OES) {
       TextureData *texData = getTextureTargetData(target);
       SET_ERROR_IF(texData==NULL,GL_INVALID_OPERATION);
@@ -1041,7 +1048,7 @@ GL_API void GL_APIENTRY  glGetTexParameterfv( GLenum target, GLenum pname, GLflo
 }
 
 GL_API void GL_APIENTRY  glGetTexParameteriv( GLenum target, GLenum pname, GLint *params) {
-    GET_CTX()
+    GET_CTX();
     if (pname==GL_TEXTURE_CROP_RECT_OES) {
       TextureData *texData = getTextureTargetData(target);
       SET_ERROR_IF(texData==NULL,GL_INVALID_OPERATION);
@@ -1054,7 +1061,7 @@ GL_API void GL_APIENTRY  glGetTexParameteriv( GLenum target, GLenum pname, GLint
 }
 
 GL_API void GL_APIENTRY  glGetTexParameterxv( GLenum target, GLenum pname, GLfixed *params) {
-    GET_CTX()
+    GET_CTX();
     if (pname==GL_TEXTURE_CROP_RECT_OES) {
       TextureData *texData = getTextureTargetData(target);
       SET_ERROR_IF(texData==NULL,GL_INVALID_OPERATION);
@@ -1069,29 +1076,29 @@ GL_API void GL_APIENTRY  glGetTexParameterxv( GLenum target, GLenum pname, GLfix
 }
 
 GL_API void GL_APIENTRY  glHint( GLenum target, GLenum mode) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::hintTargetMode(target,mode),GL_INVALID_ENUM);
     ctx->dispatcher().glHint(target,mode);
 }
 
 GL_API void GL_APIENTRY  glLightModelf( GLenum pname, GLfloat param) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glLightModelf(pname,param);
 }
 
 GL_API void GL_APIENTRY  glLightModelfv( GLenum pname, const GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glLightModelfv(pname,params);
 }
 
 GL_API void GL_APIENTRY  glLightModelx( GLenum pname, GLfixed param) {
-    GET_CTX()
+    GET_CTX();
     GLfloat tmpParam = static_cast<GLfloat>(param);
     ctx->dispatcher().glLightModelf(pname,tmpParam);
 }
 
 GL_API void GL_APIENTRY  glLightModelxv( GLenum pname, const GLfixed *params) {
-    GET_CTX()
+    GET_CTX();
     GLfloat tmpParams[4];
     if(pname == GL_LIGHT_MODEL_TWO_SIDE) {
         tmpParams[0] = X2F(params[0]);
@@ -1105,22 +1112,22 @@ GL_API void GL_APIENTRY  glLightModelxv( GLenum pname, const GLfixed *params) {
 }
 
 GL_API void GL_APIENTRY  glLightf( GLenum light, GLenum pname, GLfloat param) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glLightf(light,pname,param);
 }
 
 GL_API void GL_APIENTRY  glLightfv( GLenum light, GLenum pname, const GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glLightfv(light,pname,params);
 }
 
 GL_API void GL_APIENTRY  glLightx( GLenum light, GLenum pname, GLfixed param) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glLightf(light,pname,X2F(param));
 }
 
 GL_API void GL_APIENTRY  glLightxv( GLenum light, GLenum pname, const GLfixed *params) {
-    GET_CTX()
+    GET_CTX();
     GLfloat tmpParams[4];
 
     switch (pname) {
@@ -1149,27 +1156,27 @@ GL_API void GL_APIENTRY  glLightxv( GLenum light, GLenum pname, const GLfixed *p
 }
 
 GL_API void GL_APIENTRY  glLineWidth( GLfloat width) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glLineWidth(width);
 }
 
 GL_API void GL_APIENTRY  glLineWidthx( GLfixed width) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glLineWidth(X2F(width));
 }
 
 GL_API void GL_APIENTRY  glLoadIdentity( void) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glLoadIdentity();
 }
 
 GL_API void GL_APIENTRY  glLoadMatrixf( const GLfloat *m) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glLoadMatrixf(m);
 }
 
 GL_API void GL_APIENTRY  glLoadMatrixx( const GLfixed *m) {
-    GET_CTX()
+    GET_CTX();
     GLfloat mat[16];
     for(int i=0; i< 16 ; i++) {
         mat[i] = X2F(m[i]);
@@ -1178,27 +1185,27 @@ GL_API void GL_APIENTRY  glLoadMatrixx( const GLfixed *m) {
 }
 
 GL_API void GL_APIENTRY  glLogicOp( GLenum opcode) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glLogicOp(opcode);
 }
 
 GL_API void GL_APIENTRY  glMaterialf( GLenum face, GLenum pname, GLfloat param) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glMaterialf(face,pname,param);
 }
 
 GL_API void GL_APIENTRY  glMaterialfv( GLenum face, GLenum pname, const GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glMaterialfv(face,pname,params);
 }
 
 GL_API void GL_APIENTRY  glMaterialx( GLenum face, GLenum pname, GLfixed param) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glMaterialf(face,pname,X2F(param));
 }
 
 GL_API void GL_APIENTRY  glMaterialxv( GLenum face, GLenum pname, const GLfixed *params) {
-    GET_CTX()
+    GET_CTX();
     GLfloat tmpParams[4];
 
     for(int i=0; i< 4; i++) {
@@ -1208,17 +1215,17 @@ GL_API void GL_APIENTRY  glMaterialxv( GLenum face, GLenum pname, const GLfixed
 }
 
 GL_API void GL_APIENTRY  glMatrixMode( GLenum mode) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glMatrixMode(mode);
 }
 
 GL_API void GL_APIENTRY  glMultMatrixf( const GLfloat *m) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glMultMatrixf(m);
 }
 
 GL_API void GL_APIENTRY  glMultMatrixx( const GLfixed *m) {
-    GET_CTX()
+    GET_CTX();
     GLfloat mat[16];
     for(int i=0; i< 16 ; i++) {
         mat[i] = X2F(m[i]);
@@ -1239,34 +1246,34 @@ GL_API void GL_APIENTRY  glMultiTexCoord4x( GLenum target, GLfixed s, GLfixed t,
 }
 
 GL_API void GL_APIENTRY  glNormal3f( GLfloat nx, GLfloat ny, GLfloat nz) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glNormal3f(nx,ny,nz);
 }
 
 GL_API void GL_APIENTRY  glNormal3x( GLfixed nx, GLfixed ny, GLfixed nz) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glNormal3f(X2F(nx),X2F(ny),X2F(nz));
 }
 
 GL_API void GL_APIENTRY  glNormalPointer( GLenum type, GLsizei stride, const GLvoid *pointer) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(stride < 0,GL_INVALID_VALUE);
     SET_ERROR_IF(!GLEScmValidate::normalPointerType(type),GL_INVALID_ENUM);
     ctx->setPointer(GL_NORMAL_ARRAY,3,type,stride,pointer);//3 normal verctor
 }
 
 GL_API void GL_APIENTRY  glOrthof( GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat zNear, GLfloat zFar) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glOrtho(left,right,bottom,top,zNear,zFar);
 }
 
 GL_API void GL_APIENTRY  glOrthox( GLfixed left, GLfixed right, GLfixed bottom, GLfixed top, GLfixed zNear, GLfixed zFar) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glOrtho(X2F(left),X2F(right),X2F(bottom),X2F(top),X2F(zNear),X2F(zFar));
 }
 
 GL_API void GL_APIENTRY  glPixelStorei( GLenum pname, GLint param) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!(pname == GL_PACK_ALIGNMENT || pname == GL_UNPACK_ALIGNMENT),GL_INVALID_ENUM);
     SET_ERROR_IF(!((param==1)||(param==2)||(param==4)||(param==8)), GL_INVALID_VALUE);
     ctx->setUnpackAlignment(param);
@@ -1274,67 +1281,67 @@ GL_API void GL_APIENTRY  glPixelStorei( GLenum pname, GLint param) {
 }
 
 GL_API void GL_APIENTRY  glPointParameterf( GLenum pname, GLfloat param) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glPointParameterf(pname,param);
 }
 
 GL_API void GL_APIENTRY  glPointParameterfv( GLenum pname, const GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glPointParameterfv(pname,params);
 }
 
 GL_API void GL_APIENTRY  glPointParameterx( GLenum pname, GLfixed param)
 {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glPointParameterf(pname,X2F(param));
 }
 
 GL_API void GL_APIENTRY  glPointParameterxv( GLenum pname, const GLfixed *params) {
-    GET_CTX()
+    GET_CTX();
 
     GLfloat tmpParam = X2F(*params) ;
     ctx->dispatcher().glPointParameterfv(pname,&tmpParam);
 }
 
 GL_API void GL_APIENTRY  glPointSize( GLfloat size) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glPointSize(size);
 }
 
 GL_API void GL_APIENTRY  glPointSizePointerOES( GLenum type, GLsizei stride, const GLvoid *pointer) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(stride < 0,GL_INVALID_VALUE);
     SET_ERROR_IF(!GLEScmValidate::pointPointerType(type),GL_INVALID_ENUM);
     ctx->setPointer(GL_POINT_SIZE_ARRAY_OES,1,type,stride,pointer);
 }
 
 GL_API void GL_APIENTRY  glPointSizex( GLfixed size) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glPointSize(X2F(size));
 }
 
 GL_API void GL_APIENTRY  glPolygonOffset( GLfloat factor, GLfloat units) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glPolygonOffset(factor,units);
 }
 
 GL_API void GL_APIENTRY  glPolygonOffsetx( GLfixed factor, GLfixed units) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glPolygonOffset(X2F(factor),X2F(units));
 }
 
 GL_API void GL_APIENTRY  glPopMatrix(void) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glPopMatrix();
 }
 
 GL_API void GL_APIENTRY  glPushMatrix(void) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glPushMatrix();
 }
 
 GL_API void GL_APIENTRY  glReadPixels( GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!(GLEScmValidate::pixelFrmt(ctx,format) && GLEScmValidate::pixelType(ctx,type)),GL_INVALID_ENUM);
     SET_ERROR_IF(!(GLEScmValidate::pixelOp(format,type)),GL_INVALID_OPERATION);
 
@@ -1342,101 +1349,101 @@ GL_API void GL_APIENTRY  glReadPixels( GLint x, GLint y, GLsizei width, GLsizei
 }
 
 GL_API void GL_APIENTRY  glRotatef( GLfloat angle, GLfloat x, GLfloat y, GLfloat z) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glRotatef(angle,x,y,z);
 }
 
 GL_API void GL_APIENTRY  glRotatex( GLfixed angle, GLfixed x, GLfixed y, GLfixed z) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glRotatef(angle,X2F(x),X2F(y),X2F(z));
 }
 
 GL_API void GL_APIENTRY  glSampleCoverage( GLclampf value, GLboolean invert) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glSampleCoverage(value,invert);
 }
 
 GL_API void GL_APIENTRY  glSampleCoveragex( GLclampx value, GLboolean invert) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glSampleCoverage(X2F(value),invert);
 }
 
 GL_API void GL_APIENTRY  glScalef( GLfloat x, GLfloat y, GLfloat z) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glScalef(x,y,z);
 }
 
 GL_API void GL_APIENTRY  glScalex( GLfixed x, GLfixed y, GLfixed z) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glScalef(X2F(x),X2F(y),X2F(z));
 }
 
 GL_API void GL_APIENTRY  glScissor( GLint x, GLint y, GLsizei width, GLsizei height) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glScissor(x,y,width,height);
 }
 
 GL_API void GL_APIENTRY  glShadeModel( GLenum mode) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glShadeModel(mode);
 }
 
 GL_API void GL_APIENTRY  glStencilFunc( GLenum func, GLint ref, GLuint mask) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glStencilFunc(func,ref,mask);
 }
 
 GL_API void GL_APIENTRY  glStencilMask( GLuint mask) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glStencilMask(mask);
 }
 
 GL_API void GL_APIENTRY  glStencilOp( GLenum fail, GLenum zfail, GLenum zpass) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!(GLEScmValidate::stencilOp(fail) && GLEScmValidate::stencilOp(zfail) && GLEScmValidate::stencilOp(zpass)),GL_INVALID_ENUM);
     ctx->dispatcher().glStencilOp(fail,zfail,zpass);
 }
 
 GL_API void GL_APIENTRY  glTexCoordPointer( GLint size, GLenum type, GLsizei stride, const GLvoid *pointer) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texCoordPointerParams(size,stride),GL_INVALID_VALUE);
     SET_ERROR_IF(!GLEScmValidate::texCoordPointerType(type),GL_INVALID_ENUM);
     ctx->setPointer(GL_TEXTURE_COORD_ARRAY,size,type,stride,pointer);
 }
 
 GL_API void GL_APIENTRY  glTexEnvf( GLenum target, GLenum pname, GLfloat param) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texEnv(target,pname),GL_INVALID_ENUM);
     ctx->dispatcher().glTexEnvf(target,pname,param);
 }
 
 GL_API void GL_APIENTRY  glTexEnvfv( GLenum target, GLenum pname, const GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texEnv(target,pname),GL_INVALID_ENUM);
     ctx->dispatcher().glTexEnvfv(target,pname,params);
 }
 
 GL_API void GL_APIENTRY  glTexEnvi( GLenum target, GLenum pname, GLint param) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texEnv(target,pname),GL_INVALID_ENUM);
     ctx->dispatcher().glTexEnvi(target,pname,param);
 }
 
 GL_API void GL_APIENTRY  glTexEnviv( GLenum target, GLenum pname, const GLint *params) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texEnv(target,pname),GL_INVALID_ENUM);
     ctx->dispatcher().glTexEnviv(target,pname,params);
 }
 
 GL_API void GL_APIENTRY  glTexEnvx( GLenum target, GLenum pname, GLfixed param) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texEnv(target,pname),GL_INVALID_ENUM);
     GLfloat tmpParam = static_cast<GLfloat>(param);
     ctx->dispatcher().glTexEnvf(target,pname,tmpParam);
 }
 
 GL_API void GL_APIENTRY  glTexEnvxv( GLenum target, GLenum pname, const GLfixed *params) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texEnv(target,pname),GL_INVALID_ENUM);
 
     GLfloat tmpParams[4];
@@ -1451,7 +1458,7 @@ GL_API void GL_APIENTRY  glTexEnvxv( GLenum target, GLenum pname, const GLfixed
 }
 
 GL_API void GL_APIENTRY  glTexImage2D( GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *pixels) {
-    GET_CTX()
+    GET_CTX();
 
     SET_ERROR_IF(!(GLEScmValidate::textureTargetEx(target) &&
                      GLEScmValidate::pixelFrmt(ctx,internalformat) &&
@@ -1523,7 +1530,7 @@ static bool handleMipmapGeneration(GLenum target, GLenum pname, bool param)
 }
 
 GL_API void GL_APIENTRY  glTexParameterf( GLenum target, GLenum pname, GLfloat param) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texParams(target,pname),GL_INVALID_ENUM);
 
     if(handleMipmapGeneration(target, pname, (bool)param))
@@ -1533,7 +1540,7 @@ GL_API void GL_APIENTRY  glTexParameterf( GLenum target, GLenum pname, GLfloat p
 }
 
 GL_API void GL_APIENTRY  glTexParameterfv( GLenum target, GLenum pname, const GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texParams(target,pname),GL_INVALID_ENUM);
 
     if(handleMipmapGeneration(target, pname, (bool)(*params)))
@@ -1551,7 +1558,7 @@ GL_API void GL_APIENTRY  glTexParameterfv( GLenum target, GLenum pname, const GL
 }
 
 GL_API void GL_APIENTRY  glTexParameteri( GLenum target, GLenum pname, GLint param) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texParams(target,pname),GL_INVALID_ENUM);
 
     if(handleMipmapGeneration(target, pname, (bool)param))
@@ -1561,7 +1568,7 @@ GL_API void GL_APIENTRY  glTexParameteri( GLenum target, GLenum pname, GLint par
 }
 
 GL_API void GL_APIENTRY  glTexParameteriv( GLenum target, GLenum pname, const GLint *params) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texParams(target,pname),GL_INVALID_ENUM);
 
     if(handleMipmapGeneration(target, pname, (bool)(*params)))
@@ -1579,7 +1586,7 @@ GL_API void GL_APIENTRY  glTexParameteriv( GLenum target, GLenum pname, const GL
 }
 
 GL_API void GL_APIENTRY  glTexParameterx( GLenum target, GLenum pname, GLfixed param) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texParams(target,pname),GL_INVALID_ENUM);
 
     if(handleMipmapGeneration(target, pname, (bool)param))
@@ -1589,7 +1596,7 @@ GL_API void GL_APIENTRY  glTexParameterx( GLenum target, GLenum pname, GLfixed p
 }
 
 GL_API void GL_APIENTRY  glTexParameterxv( GLenum target, GLenum pname, const GLfixed *params) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texParams(target,pname),GL_INVALID_ENUM);
 
     if(handleMipmapGeneration(target, pname, (bool)(*params)))
@@ -1608,7 +1615,7 @@ GL_API void GL_APIENTRY  glTexParameterxv( GLenum target, GLenum pname, const GL
 }
 
 GL_API void GL_APIENTRY  glTexSubImage2D( GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *pixels) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!(GLEScmValidate::textureTargetEx(target) &&
                    GLEScmValidate::pixelFrmt(ctx,format)&&
                    GLEScmValidate::pixelType(ctx,type)),GL_INVALID_ENUM);
@@ -1627,24 +1634,24 @@ GL_API void GL_APIENTRY  glTexSubImage2D( GLenum target, GLint level, GLint xoff
 }
 
 GL_API void GL_APIENTRY  glTranslatef( GLfloat x, GLfloat y, GLfloat z) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glTranslatef(x,y,z);
 }
 
 GL_API void GL_APIENTRY  glTranslatex( GLfixed x, GLfixed y, GLfixed z) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glTranslatef(X2F(x),X2F(y),X2F(z));
 }
 
 GL_API void GL_APIENTRY  glVertexPointer( GLint size, GLenum type, GLsizei stride, const GLvoid *pointer) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::vertexPointerParams(size,stride),GL_INVALID_VALUE);
     SET_ERROR_IF(!GLEScmValidate::vertexPointerType(type),GL_INVALID_ENUM);
     ctx->setPointer(GL_VERTEX_ARRAY,size,type,stride,pointer);
 }
 
 GL_API void GL_APIENTRY  glViewport( GLint x, GLint y, GLsizei width, GLsizei height) {
-    GET_CTX()
+    GET_CTX();
     ctx->dispatcher().glViewport(x,y,width,height);
 }
 
@@ -1734,21 +1741,21 @@ GL_API void GL_APIENTRY glEGLImageTargetRenderbufferStorageOES(GLenum target, GL
 
 /* GL_OES_blend_subtract*/
 GL_API void GL_APIENTRY glBlendEquationOES(GLenum mode) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!(GLEScmValidate::blendEquationMode(mode)), GL_INVALID_ENUM);
     ctx->dispatcher().glBlendEquation(mode);
 }
 
 /* GL_OES_blend_equation_separate */
 GL_API void GL_APIENTRY glBlendEquationSeparateOES (GLenum modeRGB, GLenum modeAlpha) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!(GLEScmValidate::blendEquationMode(modeRGB) && GLEScmValidate::blendEquationMode(modeAlpha)), GL_INVALID_ENUM);
     ctx->dispatcher().glBlendEquationSeparate(modeRGB,modeAlpha);
 }
 
 /* GL_OES_blend_func_separate */
 GL_API void GL_APIENTRY glBlendFuncSeparateOES(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::blendSrc(srcRGB) || !GLEScmValidate::blendDst(dstRGB) ||
                  !GLEScmValidate::blendSrc(srcAlpha) || ! GLEScmValidate::blendDst(dstAlpha) ,GL_INVALID_ENUM);
     ctx->dispatcher().glBlendFuncSeparate(srcRGB,dstRGB,srcAlpha,dstAlpha);
@@ -1765,7 +1772,7 @@ GL_API GLboolean GL_APIENTRY glIsRenderbufferOES(GLuint renderbuffer) {
 }
 
 GL_API void GLAPIENTRY glBindRenderbufferOES(GLenum target, GLuint renderbuffer) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!ctx->getCaps()->GL_EXT_FRAMEBUFFER_OBJECT,GL_INVALID_OPERATION);
     SET_ERROR_IF(!GLEScmValidate::renderbufferTarget(target),GL_INVALID_ENUM);
 
@@ -1785,7 +1792,7 @@ GL_API void GLAPIENTRY glBindRenderbufferOES(GLenum target, GLuint renderbuffer)
 }
 
 GL_API void GLAPIENTRY glDeleteRenderbuffersOES(GLsizei n, const GLuint *renderbuffers) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!ctx->getCaps()->GL_EXT_FRAMEBUFFER_OBJECT,GL_INVALID_OPERATION);
     for (int i=0;i<n;++i) {
         GLuint globalBufferName = ctx->shareGroup()->getGlobalName(RENDERBUFFER,renderbuffers[i]);
@@ -1794,7 +1801,7 @@ GL_API void GLAPIENTRY glDeleteRenderbuffersOES(GLsizei n, const GLuint *renderb
 }
 
 GL_API void GLAPIENTRY glGenRenderbuffersOES(GLsizei n, GLuint *renderbuffers) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!ctx->getCaps()->GL_EXT_FRAMEBUFFER_OBJECT,GL_INVALID_OPERATION);
     SET_ERROR_IF(n<0,GL_INVALID_VALUE);
     if(ctx->shareGroup().Ptr()) {
@@ -1808,7 +1815,7 @@ GL_API void GLAPIENTRY glGenRenderbuffersOES(GLsizei n, GLuint *renderbuffers) {
 }
 
 GL_API void GLAPIENTRY glRenderbufferStorageOES(GLenum target, GLenum internalformat, GLsizei width, GLsizei height){
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!ctx->getCaps()->GL_EXT_FRAMEBUFFER_OBJECT,GL_INVALID_OPERATION);
     SET_ERROR_IF(!GLEScmValidate::renderbufferTarget(target) || !GLEScmValidate::renderbufferInternalFrmt(ctx,internalformat) ,GL_INVALID_ENUM);
     if (internalformat==GL_RGB565_OES) //RGB565 not supported by GL
@@ -1838,7 +1845,7 @@ GL_API void GLAPIENTRY glRenderbufferStorageOES(GLenum target, GLenum internalfo
 }
 
 GL_API void GLAPIENTRY glGetRenderbufferParameterivOES(GLenum target, GLenum pname, GLint* params) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!ctx->getCaps()->GL_EXT_FRAMEBUFFER_OBJECT,GL_INVALID_OPERATION);
     SET_ERROR_IF(!GLEScmValidate::renderbufferTarget(target) || !GLEScmValidate::renderbufferParams(pname) ,GL_INVALID_ENUM);
 
@@ -1909,7 +1916,7 @@ GL_API GLboolean GLAPIENTRY glIsFramebufferOES(GLuint framebuffer) {
 }
 
 GL_API void GLAPIENTRY glBindFramebufferOES(GLenum target, GLuint framebuffer) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!ctx->getCaps()->GL_EXT_FRAMEBUFFER_OBJECT,GL_INVALID_OPERATION);
     SET_ERROR_IF(!GLEScmValidate::framebufferTarget(target) ,GL_INVALID_ENUM);
     if (framebuffer && ctx->shareGroup().Ptr() && !ctx->shareGroup()->isObject(FRAMEBUFFER,framebuffer)) {
@@ -1925,7 +1932,7 @@ GL_API void GLAPIENTRY glBindFramebufferOES(GLenum target, GLuint framebuffer) {
 }
 
 GL_API void GLAPIENTRY glDeleteFramebuffersOES(GLsizei n, const GLuint *framebuffers) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!ctx->getCaps()->GL_EXT_FRAMEBUFFER_OBJECT,GL_INVALID_OPERATION);
     for (int i=0;i<n;++i) {
         GLuint globalBufferName = ctx->shareGroup()->getGlobalName(FRAMEBUFFER,framebuffers[i]);
@@ -1934,7 +1941,7 @@ GL_API void GLAPIENTRY glDeleteFramebuffersOES(GLsizei n, const GLuint *framebuf
 }
 
 GL_API void GLAPIENTRY glGenFramebuffersOES(GLsizei n, GLuint *framebuffers) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!ctx->getCaps()->GL_EXT_FRAMEBUFFER_OBJECT,GL_INVALID_OPERATION);
     SET_ERROR_IF(n<0,GL_INVALID_VALUE);
     if (ctx->shareGroup().Ptr()) {
@@ -1954,7 +1961,7 @@ GL_API GLenum GLAPIENTRY glCheckFramebufferStatusOES(GLenum target) {
 }
 
 GL_API void GLAPIENTRY glFramebufferTexture2DOES(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!ctx->getCaps()->GL_EXT_FRAMEBUFFER_OBJECT,GL_INVALID_OPERATION);
     SET_ERROR_IF(!GLEScmValidate::framebufferTarget(target) || !GLEScmValidate::framebufferAttachment(attachment) ||
                  !GLEScmValidate::textureTargetEx(textarget),GL_INVALID_ENUM);
@@ -1982,7 +1989,7 @@ GL_API void GLAPIENTRY glFramebufferTexture2DOES(GLenum target, GLenum attachmen
 }
 
 GL_API void GLAPIENTRY glFramebufferRenderbufferOES(GLenum target, GLenum attachment,GLenum renderbuffertarget, GLuint renderbuffer) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!ctx->getCaps()->GL_EXT_FRAMEBUFFER_OBJECT,GL_INVALID_OPERATION);
     SET_ERROR_IF(!GLEScmValidate::framebufferTarget(target) || 
                  !GLEScmValidate::framebufferAttachment(attachment) ||
@@ -2035,7 +2042,7 @@ GL_API void GLAPIENTRY glFramebufferRenderbufferOES(GLenum target, GLenum attach
 }
 
 GL_API void GLAPIENTRY glGetFramebufferAttachmentParameterivOES(GLenum target, GLenum attachment, GLenum pname, GLint *params) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!ctx->getCaps()->GL_EXT_FRAMEBUFFER_OBJECT,GL_INVALID_OPERATION);
     SET_ERROR_IF(!GLEScmValidate::framebufferTarget(target) || !GLEScmValidate::framebufferAttachment(attachment) ||
                  !GLEScmValidate::framebufferAttachmentParams(pname), GL_INVALID_ENUM);
@@ -2065,20 +2072,20 @@ GL_API void GLAPIENTRY glGetFramebufferAttachmentParameterivOES(GLenum target, G
 }
 
 GL_API void GL_APIENTRY glGenerateMipmapOES(GLenum target) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!ctx->getCaps()->GL_EXT_FRAMEBUFFER_OBJECT,GL_INVALID_OPERATION);
     SET_ERROR_IF(!GLEScmValidate::textureTargetLimited(target),GL_INVALID_ENUM);
     ctx->dispatcher().glGenerateMipmapEXT(target);
 }
 
 GL_API void GL_APIENTRY glCurrentPaletteMatrixOES(GLuint index) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!(ctx->getCaps()->GL_ARB_MATRIX_PALETTE && ctx->getCaps()->GL_ARB_VERTEX_BLEND),GL_INVALID_OPERATION);
     ctx->dispatcher().glCurrentPaletteMatrixARB(index);
 }
 
 GL_API void GL_APIENTRY glLoadPaletteFromModelViewMatrixOES() {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!(ctx->getCaps()->GL_ARB_MATRIX_PALETTE && ctx->getCaps()->GL_ARB_VERTEX_BLEND),GL_INVALID_OPERATION);
     GLint matrix[16];
     ctx->dispatcher().glGetIntegerv(GL_MODELVIEW_MATRIX,matrix);
@@ -2087,20 +2094,20 @@ GL_API void GL_APIENTRY glLoadPaletteFromModelViewMatrixOES() {
 }
 
 GL_API void GL_APIENTRY glMatrixIndexPointerOES(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!(ctx->getCaps()->GL_ARB_MATRIX_PALETTE && ctx->getCaps()->GL_ARB_VERTEX_BLEND),GL_INVALID_OPERATION);
     ctx->dispatcher().glMatrixIndexPointerARB(size,type,stride,pointer);
 }
 
 GL_API void GL_APIENTRY glWeightPointerOES(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!(ctx->getCaps()->GL_ARB_MATRIX_PALETTE && ctx->getCaps()->GL_ARB_VERTEX_BLEND),GL_INVALID_OPERATION);
     ctx->dispatcher().glWeightPointerARB(size,type,stride,pointer);
 
 }
 
 GL_API void GL_APIENTRY glTexGenfOES (GLenum coord, GLenum pname, GLfloat param) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texGen(coord,pname),GL_INVALID_ENUM);
     if (coord == GL_TEXTURE_GEN_STR_OES) {
         ctx->dispatcher().glTexGenf(GL_S,pname,param);
@@ -2112,7 +2119,7 @@ GL_API void GL_APIENTRY glTexGenfOES (GLenum coord, GLenum pname, GLfloat param)
 }
 
 GL_API void GL_APIENTRY glTexGenfvOES (GLenum coord, GLenum pname, const GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texGen(coord,pname),GL_INVALID_ENUM);
     if (coord == GL_TEXTURE_GEN_STR_OES) {
         ctx->dispatcher().glTexGenfv(GL_S,pname,params);
@@ -2123,7 +2130,7 @@ GL_API void GL_APIENTRY glTexGenfvOES (GLenum coord, GLenum pname, const GLfloat
         ctx->dispatcher().glTexGenfv(coord,pname,params);
 }
 GL_API void GL_APIENTRY glTexGeniOES (GLenum coord, GLenum pname, GLint param) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texGen(coord,pname),GL_INVALID_ENUM);
     if (coord == GL_TEXTURE_GEN_STR_OES) {
         ctx->dispatcher().glTexGeni(GL_S,pname,param);
@@ -2134,7 +2141,7 @@ GL_API void GL_APIENTRY glTexGeniOES (GLenum coord, GLenum pname, GLint param) {
         ctx->dispatcher().glTexGeni(coord,pname,param);
 }
 GL_API void GL_APIENTRY glTexGenivOES (GLenum coord, GLenum pname, const GLint *params) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texGen(coord,pname),GL_INVALID_ENUM);
     if (coord == GL_TEXTURE_GEN_STR_OES) {
         ctx->dispatcher().glTexGeniv(GL_S,pname,params);
@@ -2145,7 +2152,7 @@ GL_API void GL_APIENTRY glTexGenivOES (GLenum coord, GLenum pname, const GLint *
         ctx->dispatcher().glTexGeniv(coord,pname,params);
 }
 GL_API void GL_APIENTRY glTexGenxOES (GLenum coord, GLenum pname, GLfixed param) {
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texGen(coord,pname),GL_INVALID_ENUM);
     if (coord == GL_TEXTURE_GEN_STR_OES) {
         ctx->dispatcher().glTexGenf(GL_S,pname,X2F(param));
@@ -2157,7 +2164,7 @@ GL_API void GL_APIENTRY glTexGenxOES (GLenum coord, GLenum pname, GLfixed param)
 }
 GL_API void GL_APIENTRY glTexGenxvOES (GLenum coord, GLenum pname, const GLfixed *params) {
     GLfloat tmpParams[1];
-    GET_CTX()
+    GET_CTX();
     SET_ERROR_IF(!GLEScmValidate::texGen(coord,pname),GL_INVALID_ENUM);
     tmpParams[0] = X2F(params[0]);
     if (coord == GL_TEXTURE_GEN_STR_OES) {
@@ -2170,7 +2177,7 @@ GL_API void GL_APIENTRY glTexGenxvOES (GLenum coord, GLenum pname, const GLfixed
 }
 
 GL_API void GL_APIENTRY glGetTexGenfvOES (GLenum coord, GLenum pname, GLfloat *params) {
-    GET_CTX()
+    GET_CTX();
     if (coord == GL_TEXTURE_GEN_STR_OES)
     {
         GLfloat state_s = GL_FALSE;
@@ -2186,7 +2193,7 @@ GL_API void GL_APIENTRY glGetTexGenfvOES (GLenum coord, GLenum pname, GLfloat *p
 
 }
 GL_API void GL_APIENTRY glGetTexGenivOES (GLenum coord, GLenum pname, GLint *params) {
-    GET_CTX()
+    GET_CTX();
     if (coord == GL_TEXTURE_GEN_STR_OES)
     {
         GLint state_s = GL_FALSE;
@@ -2202,7 +2209,7 @@ GL_API void GL_APIENTRY glGetTexGenivOES (GLenum coord, GLenum pname, GLint *par
 }
 
 GL_API void GL_APIENTRY glGetTexGenxvOES (GLenum coord, GLenum pname, GLfixed *params) {
-    GET_CTX()
+    GET_CTX();
     GLfloat tmpParams[1];
 
     if (coord == GL_TEXTURE_GEN_STR_OES)
@@ -2223,7 +2230,7 @@ GL_API void GL_APIENTRY glGetTexGenxvOES (GLenum coord, GLenum pname, GLfixed *p
 
 template <class T, GLenum TypeName>
 void glDrawTexOES (T x, T y, T z, T width, T height) {
-    GET_CTX()
+    GET_CTX();
 
     SET_ERROR_IF((width<=0 || height<=0),GL_INVALID_VALUE);
 
@@ -2258,12 +2265,8 @@ void glDrawTexOES (T x, T y, T z, T width, T height) {
     ctx->dispatcher().glMatrixMode(GL_MODELVIEW);
     ctx->dispatcher().glPushMatrix();
     ctx->dispatcher().glLoadIdentity();
-    //backup vbo's
-    int array_buffer,element_array_buffer;
-    glGetIntegerv(GL_ARRAY_BUFFER_BINDING,&array_buffer);
-    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING,&element_array_buffer);
-    ctx->dispatcher().glBindBuffer(GL_ARRAY_BUFFER,0);
-    ctx->dispatcher().glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
+    //no host buffer is bound outside of the draws, so the arrays below
+    //are client pointers
 
     //disable clip planes
     ctx->dispatcher().glGetIntegerv(GL_MAX_CLIP_PLANES,&numClipPlanes);
@@ -2307,10 +2310,6 @@ void glDrawTexOES (T x, T y, T z, T width, T height) {
         ctx->dispatcher().glDrawArrays(GL_TRIANGLE_FAN,0,4);
     }
 
-    //restore vbo's
-    ctx->dispatcher().glBindBuffer(GL_ARRAY_BUFFER,array_buffer);
-    ctx->dispatcher().glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,element_array_buffer);
-
     //restore matrix state
 
     ctx->dispatcher().glMatrixMode(GL_MODELVIEW);
@@ -2355,3 +2354,38 @@ GL_API void GL_APIENTRY glDrawTexfvOES (const GLfloat * coords) {
 GL_API void GL_APIENTRY glDrawTexxvOES (const GLfixed * coords) {
     glDrawTexOES<GLfloat,GL_FLOAT>(X2F(coords[0]),X2F(coords[1]),X2F(coords[2]),X2F(coords[3]),X2F(coords[4]));
 }
+
+//
+// host only entry points, looked up by the renderer and not advertised
+// to the guest, see GLEScontext::blitFramebuffer
+//
+extern "C" GL_API GLboolean GL_APIENTRY glBlitFramebufferEMU(GLeglImageOES image,
+        GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+        GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1) {
+    GET_CTX_RET(GL_FALSE)
+    unsigned int imagehndl = ToTargetCompatibleHandle((uintptr_t)image);
+    EglImage *img = s_eglIface->eglAttachEGLImage(imagehndl);
+    if (!img) {
+        return GL_FALSE;
+    }
+    return ctx->blitFramebuffer(imagehndl, img->globalTexName,
+                                srcX0, srcY0, srcX1, srcY1,
+                                dstX0, dstY0, dstX1, dstY1) ? GL_TRUE : GL_FALSE;
+}
+
+extern "C" GL_API GLboolean GL_APIENTRY glCopyToImageEMU(GLeglImageOES image,
+        GLint x, GLint y, GLsizei width, GLsizei height) {
+    GET_CTX_RET(GL_FALSE)
+    unsigned int imagehndl = ToTargetCompatibleHandle((uintptr_t)image);
+    EglImage *img = s_eglIface->eglAttachEGLImage(imagehndl);
+    if (!img) {
+        return GL_FALSE;
+    }
+    return ctx->copyTexSubImage(img->globalTexName, x, y, width, height) ?
+           GL_TRUE : GL_FALSE;
+}
+
+extern "C" GL_API void GL_APIENTRY glReleaseBlitTargetsEMU(void) {
+    GET_CTX_CM();
+    ctx->releaseBlitTargets();
+}
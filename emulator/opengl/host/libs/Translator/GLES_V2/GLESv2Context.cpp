@@ -89,6 +89,7 @@ void GLESv2Context::validateAtt0PostDraw(void)
 
 void GLESv2Context::setupArraysPointers(GLESConversionArrays& cArrs,GLint first,GLsizei count,GLenum type,const GLvoid* indices,bool direct) {
     ArraysMap::iterator it;
+    startDraw();
 
     //going over all clients arrays Pointers
     for ( it=m_map.begin() ; it != m_map.end(); it++ ) {
@@ -101,18 +102,18 @@ void GLESv2Context::setupArraysPointers(GLESConversionArrays& cArrs,GLint first,
         if(needConvert(cArrs,first,count,type,indices,direct,p,array_id)){
             //conversion has occured
             ArrayData currentArr = cArrs.getCurrentArray();
-            setupArr(currentArr.data,array_id,currentArr.type,size,currentArr.stride, p->getNormalized());
+            setupArr(bindArrayData(p,&currentArr),array_id,currentArr.type,size,currentArr.stride, p->getNormalized());
             ++cArrs;
-        } else {
-            setupArr(p->getData(),array_id,p->getType(),
+        } else if(p->getData()) {
+            setupArr(bindArrayData(p,NULL),array_id,p->getType(),
                      size,p->getStride(), p->getNormalized());
         }
     }
+    bindHostArrayBuffer(0);
 }
 
 //setting client side arr
 void GLESv2Context::setupArr(const GLvoid* arr,GLenum arrayType,GLenum dataType,GLint size,GLsizei stride,GLboolean normalized, int index){
-     if(arr == NULL) return;
      s_glDispatch.glVertexAttribPointer(arrayType,size,dataType,normalized,stride,arr);
 }
 
@@ -435,7 +435,10 @@ GL_APICALL void  GL_APIENTRY glDeleteBuffers(GLsizei n, const GLuint* buffers){
     SET_ERROR_IF(n<0,GL_INVALID_VALUE);
     if(ctx->shareGroup().Ptr()) {
         for(int i=0; i < n; i++){
+           const GLuint globalBufferName = ctx->shareGroup()->getGlobalName(VERTEXBUFFER,buffers[i]);
            ctx->shareGroup()->deleteName(VERTEXBUFFER,buffers[i]);
+           ctx->unbindBuffer(buffers[i]);
+           if(globalBufferName) ctx->dispatcher().glDeleteBuffers(1,&globalBufferName);
         }
     }
 }
@@ -608,7 +611,13 @@ GL_APICALL void  GL_APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum t
         ctx->dispatcher().glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
     }
 
-    ctx->dispatcher().glDrawElements(mode,count,type,indices);
+    if(ctx->isBindedBuffer(GL_ELEMENT_ARRAY_BUFFER)) {
+        ctx->dispatcher().glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,ctx->getBindedBufferHostName(GL_ELEMENT_ARRAY_BUFFER));
+        ctx->dispatcher().glDrawElements(mode,count,type,elementsIndices);
+        ctx->dispatcher().glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
+    } else {
+        ctx->dispatcher().glDrawElements(mode,count,type,indices);
+    }
 
     if (mode==GL_POINTS) {
         ctx->dispatcher().glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
@@ -2085,3 +2094,38 @@ GL_APICALL void GL_APIENTRY glEGLImageTargetRenderbufferStorageOES(GLenum target
         }
     }
 }
+
+//
+// host only entry points, looked up by the renderer and not advertised
+// to the guest, see GLEScontext::blitFramebuffer
+//
+extern "C" GL_API GLboolean GL_APIENTRY glBlitFramebufferEMU(GLeglImageOES image,
+        GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+        GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1) {
+    GET_CTX_RET(GL_FALSE)
+    unsigned int imagehndl = ToTargetCompatibleHandle((uintptr_t)image);
+    EglImage *img = s_eglIface->eglAttachEGLImage(imagehndl);
+    if (!img) {
+        return GL_FALSE;
+    }
+    return ctx->blitFramebuffer(imagehndl, img->globalTexName,
+                                srcX0, srcY0, srcX1, srcY1,
+                                dstX0, dstY0, dstX1, dstY1) ? GL_TRUE : GL_FALSE;
+}
+
+extern "C" GL_API GLboolean GL_APIENTRY glCopyToImageEMU(GLeglImageOES image,
+        GLint x, GLint y, GLsizei width, GLsizei height) {
+    GET_CTX_RET(GL_FALSE)
+    unsigned int imagehndl = ToTargetCompatibleHandle((uintptr_t)image);
+    EglImage *img = s_eglIface->eglAttachEGLImage(imagehndl);
+    if (!img) {
+        return GL_FALSE;
+    }
+    return ctx->copyTexSubImage(img->globalTexName, x, y, width, height) ?
+           GL_TRUE : GL_FALSE;
+}
+
+extern "C" GL_API void GL_APIENTRY glReleaseBlitTargetsEMU(void) {
+    GET_CTX_V2();
+    ctx->releaseBlitTargets();
+}
@@ -13,7 +13,8 @@ host_common_SRC_FILES :=     \
      PaletteTexture.cpp      \
      etc1.cpp                \
      objectNameManager.cpp   \
-     FramebufferData.cpp
+     FramebufferData.cpp     \
+     VertexConversion.cpp
 
 host_GL_COMMON_LINKER_FLAGS :=
 host_common_LDLIBS :=
@@ -216,6 +216,7 @@ void (GLAPIENTRY *GLDispatch::glFramebufferTexture3DEXT) (GLenum target, GLenum
 void (GLAPIENTRY *GLDispatch::glFramebufferRenderbufferEXT) (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer) = NULL;
 void (GLAPIENTRY *GLDispatch::glGetFramebufferAttachmentParameterivEXT) (GLenum target, GLenum attachment, GLenum pname, GLint *params) = NULL;
 void (GLAPIENTRY *GLDispatch::glGenerateMipmapEXT) (GLenum target) = NULL;
+void (GLAPIENTRY *GLDispatch::glBlitFramebufferEXT) (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) = NULL;
 void (GLAPIENTRY *GLDispatch::glCurrentPaletteMatrixARB) (GLint index) = NULL;
 void (GLAPIENTRY *GLDispatch::glMatrixIndexuivARB) (GLint size, GLuint * indices) = NULL;
 void (GLAPIENTRY *GLDispatch::glMatrixIndexPointerARB) (GLint size, GLenum type, GLsizei stride, const GLvoid* pointer) = NULL;
@@ -386,6 +387,7 @@ void GLDispatch::dispatchFuncs(GLESVersion version){
     LOAD_GLEXT_FUNC(glFramebufferRenderbufferEXT);
     LOAD_GLEXT_FUNC(glGetFramebufferAttachmentParameterivEXT);
     LOAD_GLEXT_FUNC(glGenerateMipmapEXT);
+    LOAD_GLEXT_FUNC(glBlitFramebufferEXT);
 
     /* Loading OpenGL functions which are needed ONLY for implementing GLES 1.1*/
     if(version == GLES_1_1){
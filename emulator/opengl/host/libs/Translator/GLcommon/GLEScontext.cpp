@@ -22,13 +22,14 @@
 #include <GLcommon/GLESvalidate.h>
 #include <GLcommon/TextureUtils.h>
 #include <GLcommon/FramebufferData.h>
+#include <GLcommon/VertexConversion.h>
 #include <strings.h>
+#include <string.h>
+#include <stdint.h>
 
-//decleration
-static void convertFixedDirectLoop(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int nBytes,unsigned int strideOut,int attribSize);
-static void convertFixedIndirectLoop(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut,int attribSize);
-static void convertByteDirectLoop(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int nBytes,unsigned int strideOut,int attribSize);
-static void convertByteIndirectLoop(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut,int attribSize);
+//the converted client arrays kept by a context
+#define MAX_CONVERTED_ARRAYS        64
+#define MAX_CONVERTED_ARRAYS_BYTES  (8*1024*1024)
 
 GLESConversionArrays::~GLESConversionArrays() {
     for(std::map<GLenum,ArrayData>::iterator it = m_arrays.begin(); it != m_arrays.end();it++) {
@@ -56,10 +57,11 @@ void GLESConversionArrays::allocArr(unsigned int size,GLenum type){
     m_arrays[m_current].allocated = true;
 }
 
-void GLESConversionArrays::setArr(void* data,unsigned int stride,GLenum type){
+void GLESConversionArrays::setArr(void* data,unsigned int stride,GLenum type,GLuint buffer){
    m_arrays[m_current].type = type;
    m_arrays[m_current].data = data;
    m_arrays[m_current].stride = stride;
+   m_arrays[m_current].buffer = buffer;
    m_arrays[m_current].allocated = false;
 }
 
@@ -90,6 +92,7 @@ std::string    GLEScontext::s_glVendor;
 std::string    GLEScontext::s_glRenderer;
 std::string    GLEScontext::s_glVersion;
 GLSupport      GLEScontext::s_glSupport;
+std::vector<GLuint> GLEScontext::s_releasedBuffers;
 
 Version::Version():m_major(0),
                    m_minor(0),
@@ -160,9 +163,16 @@ GLEScontext::GLEScontext():
                            m_texState(0)          ,
                            m_arrayBuffer(0)        ,
                            m_elementBuffer(0),
+                           m_hostArrayBuffer(0),
                            m_renderbuffer(0),
-                           m_framebuffer(0)
+                           m_framebuffer(0),
+                           m_convertedBytes(0),
+                           m_nextCandidate(0),
+                           m_draw(0),
+                           m_blitUse(0)
 {
+    memset(m_conversionCandidates,0,sizeof(m_conversionCandidates));
+    memset(m_blitTargets,0,sizeof(m_blitTargets));
 };
 
 GLenum GLEScontext::getGLerror() {
@@ -186,6 +196,17 @@ GLEScontext::~GLEScontext() {
     }
     delete[] m_texState;
     m_texState = NULL;
+
+    //the host context is gone, the buffers are deleted by the next draw
+    //of another context, they all share the host objects
+    s_lock.lock();
+    for(unsigned int i=0;i<m_convertedArrays.size();i++) {
+        ConvertedArray& arr = m_convertedArrays[i];
+        if(arr.buffer) s_releasedBuffers.push_back(arr.buffer);
+        arr.buffer = 0;
+        releaseConvertedArray(arr);
+    }
+    s_lock.unlock();
 }
 
 const GLvoid* GLEScontext::setPointer(GLenum arrType,GLint size,GLenum type,GLsizei stride,const GLvoid* data,bool normalize) {
@@ -213,60 +234,11 @@ const GLESpointer* GLEScontext::getPointer(GLenum arrType) {
     return NULL;
 }
 
-static void convertFixedDirectLoop(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int nBytes,unsigned int strideOut,int attribSize) {
-
-    for(unsigned int i = 0; i < nBytes;i+=strideOut) {
-        const GLfixed* fixed_data = (const GLfixed *)dataIn;
-        //filling attrib
-        for(int j=0;j<attribSize;j++) {
-            reinterpret_cast<GLfloat*>(&static_cast<unsigned char*>(dataOut)[i])[j] = X2F(fixed_data[j]);
-        }
-        dataIn += strideIn;
-    }
-}
-
-static void convertFixedIndirectLoop(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut,int attribSize) {
-    for(int i = 0 ;i < count ;i++) {
-        unsigned short index = indices_type == GL_UNSIGNED_BYTE? ((GLubyte *)indices)[i]:
-                                                             ((GLushort *)indices)[i];
-        const GLfixed* fixed_data = (GLfixed *)(dataIn  + index*strideIn);
-        GLfloat* float_data = reinterpret_cast<GLfloat*>(static_cast<unsigned char*>(dataOut) + index*strideOut);
-
-        for(int j=0;j<attribSize;j++) {
-            float_data[j] = X2F(fixed_data[j]);
-         }
-    }
-}
-
-static void convertByteDirectLoop(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int nBytes,unsigned int strideOut,int attribSize) {
-
-    for(unsigned int i = 0; i < nBytes;i+=strideOut) {
-        const GLbyte* byte_data = (const GLbyte *)dataIn;
-        //filling attrib
-        for(int j=0;j<attribSize;j++) {
-            reinterpret_cast<GLshort*>(&static_cast<unsigned char*>(dataOut)[i])[j] = B2S(byte_data[j]);
-        }
-        dataIn += strideIn;
-    }
-}
-
-static void convertByteIndirectLoop(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut,int attribSize) {
-    for(int i = 0 ;i < count ;i++) {
-        unsigned short index = indices_type == GL_UNSIGNED_BYTE? ((GLubyte *)indices)[i]:
-                                                             ((GLushort *)indices)[i];
-        const GLbyte* bytes_data = (GLbyte *)(dataIn  + index*strideIn);
-        GLshort* short_data = reinterpret_cast<GLshort*>(static_cast<unsigned char*>(dataOut) + index*strideOut);
-
-        for(int j=0;j<attribSize;j++) {
-            short_data[j] = B2S(bytes_data[j]);
-         }
-    }
-}
 static void directToBytesRanges(GLint first,GLsizei count,GLESpointer* p,RangeList& list) {
 
     int attribSize = p->getSize()*4; //4 is the sizeof GLfixed or GLfloat in bytes
     int stride = p->getStride()?p->getStride():attribSize;
-    int start  = p->getBufferOffset()+first*attribSize;
+    int start  = p->getBufferOffset()+first*stride;
     if(!p->getStride()) {
         list.addRange(Range(start,count*attribSize));
     } else {
@@ -309,18 +281,21 @@ int bytesRangesToIndices(RangeList& ranges,GLESpointer* p,GLushort* indices) {
 
 void GLEScontext::convertDirect(GLESConversionArrays& cArrs,GLint first,GLsizei count,GLenum array_id,GLESpointer* p) {
 
+    if(convertCached(cArrs,first,count,p)) return;
+
     GLenum type    = p->getType();
     int attribSize = p->getSize();
-    unsigned int size = attribSize*count + first;
+    unsigned int size = attribSize*(first + count);
     unsigned int bytes = type == GL_FIXED ? sizeof(GLfixed):sizeof(GLbyte);
     cArrs.allocArr(size,type);
     int stride = p->getStride()?p->getStride():bytes*attribSize;
     const char* data = (const char*)p->getArrayData() + (first*stride);
 
+    //the draw reads the vertices from 'first' on
     if(type == GL_FIXED) {
-        convertFixedDirectLoop(data,stride,cArrs.getCurrentData(),size*sizeof(GLfloat),attribSize*sizeof(GLfloat),attribSize);
+        getVertexConversion().fixedDirect(data,stride,static_cast<GLfloat*>(cArrs.getCurrentData()) + first*attribSize,count,attribSize);
     } else if(type == GL_BYTE) {
-        convertByteDirectLoop(data,stride,cArrs.getCurrentData(),size*sizeof(GLshort),attribSize*sizeof(GLshort),attribSize);
+        getVertexConversion().byteDirect(data,stride,static_cast<GLshort*>(cArrs.getCurrentData()) + first*attribSize,count,attribSize);
     }
 }
 
@@ -332,8 +307,7 @@ void GLEScontext::convertDirectVBO(GLESConversionArrays& cArrs,GLint first,GLsiz
     GLenum type    = p->getType();
     int attribSize = p->getSize();
     int stride = p->getStride()?p->getStride():sizeof(GLfixed)*attribSize;
-    unsigned int size = p->getStride()?p->getStride()*count:attribSize*count*sizeof(GLfixed);
-    char* data = (char*)p->getBufferData() + (first*stride);
+    char* data = (char*)p->getBufferData();
 
     if(p->bufferNeedConversion()) {
         directToBytesRanges(first,count,p,ranges); //converting indices range to buffer bytes ranges by offset
@@ -342,11 +316,12 @@ void GLEScontext::convertDirectVBO(GLESConversionArrays& cArrs,GLint first,GLsiz
         if(conversions.size()) { // there are some elements to convert
            indices = new GLushort[count];
            int nIndices = bytesRangesToIndices(conversions,p,indices); //converting bytes ranges by offset to indices in this array
-           convertFixedIndirectLoop(data,stride,data,nIndices,GL_UNSIGNED_SHORT,indices,stride,attribSize);
+           getVertexConversion().fixedIndirect(data,stride,data,nIndices,GL_UNSIGNED_SHORT,indices,stride,attribSize);
+           uploadConversions(conversions,p);
         }
     }
     if(indices) delete[] indices;
-    cArrs.setArr(data,p->getStride(),GL_FLOAT);
+    cArrs.setArr(data,p->getStride(),GL_FLOAT,p->getBufferHostName());
 }
 
 int GLEScontext::findMaxIndex(GLsizei count,GLenum type,const GLvoid* indices) {
@@ -368,7 +343,10 @@ int GLEScontext::findMaxIndex(GLsizei count,GLenum type,const GLvoid* indices) {
 
 void GLEScontext::convertIndirect(GLESConversionArrays& cArrs,GLsizei count,GLenum indices_type,const GLvoid* indices,GLenum array_id,GLESpointer* p) {
     GLenum type    = p->getType();
-    int maxElements = findMaxIndex(count,type,indices) + 1;
+    int maxElements = findMaxIndex(count,indices_type,indices) + 1;
+
+    //cached whole, so other indices into the same vertices hit it
+    if(convertCached(cArrs,0,maxElements,p)) return;
 
     int attribSize = p->getSize();
     int size = attribSize * maxElements;
@@ -378,9 +356,9 @@ void GLEScontext::convertIndirect(GLESConversionArrays& cArrs,GLsizei count,GLen
 
     const char* data = (const char*)p->getArrayData();
     if(type == GL_FIXED) {
-        convertFixedIndirectLoop(data,stride,cArrs.getCurrentData(),count,indices_type,indices,attribSize*sizeof(GLfloat),attribSize);
+        getVertexConversion().fixedIndirect(data,stride,cArrs.getCurrentData(),count,indices_type,indices,attribSize*sizeof(GLfloat),attribSize);
     } else if(type == GL_BYTE){
-        convertByteIndirectLoop(data,stride,cArrs.getCurrentData(),count,indices_type,indices,attribSize*sizeof(GLshort),attribSize);
+        getVertexConversion().byteIndirect(data,stride,cArrs.getCurrentData(),count,indices_type,indices,attribSize*sizeof(GLshort),attribSize);
     }
 }
 
@@ -398,11 +376,268 @@ void GLEScontext::convertIndirectVBO(GLESConversionArrays& cArrs,GLsizei count,G
         if(conversions.size()) { // there are some elements to convert
             conversionIndices = new GLushort[count];
             int nIndices = bytesRangesToIndices(conversions,p,conversionIndices); //converting bytes ranges by offset to indices in this array
-            convertFixedIndirectLoop(data,stride,data,nIndices,GL_UNSIGNED_SHORT,conversionIndices,stride,attribSize);
+            getVertexConversion().fixedIndirect(data,stride,data,nIndices,GL_UNSIGNED_SHORT,conversionIndices,stride,attribSize);
+            uploadConversions(conversions,p);
         }
     }
     if(conversionIndices) delete[] conversionIndices;
-    cArrs.setArr(data,p->getStride(),GL_FLOAT);
+    cArrs.setArr(data,p->getStride(),GL_FLOAT,p->getBufferHostName());
+}
+
+//writes the ranges converted in the CPU copy of the buffer to its host buffer
+void GLEScontext::uploadConversions(RangeList& conversions,GLESpointer* p) {
+    const unsigned char* data = static_cast<const unsigned char*>(p->getBufferData()) - p->getBufferOffset();
+    bindHostArrayBuffer(p->getBufferHostName());
+    for(int i=0;i<conversions.size();i++) {
+        Range& r = conversions[i];
+        s_glDispatch.glBufferSubData(GL_ARRAY_BUFFER,r.getStart(),r.getSize(),data+r.getStart());
+    }
+}
+
+//returns what to give the host as the pointer of an enabled array, with
+//the host buffer it reads from bound, or NULL when there is nothing to
+//draw from. VBO arrays, as is or converted in place, are read from their
+//host buffer by offset, and so are the cached conversions of client
+//arrays; the other arrays from client memory.
+const GLvoid* GLEScontext::bindArrayData(GLESpointer* p,const ArrayData* converted) {
+    if(converted && !converted->buffer) {
+        bindHostArrayBuffer(0);
+        return converted->data;
+    }
+    if(converted && converted->buffer != p->getBufferHostName()) {
+        //a client array converted by an earlier draw
+        bindHostArrayBuffer(converted->buffer);
+        return NULL;
+    }
+    if(!p->isVBO()) {
+        bindHostArrayBuffer(0);
+        return p->getArrayData();
+    }
+    if(!p->getBufferData() || !p->getBufferHostName()) return NULL;
+    bindHostArrayBuffer(p->getBufferHostName());
+    return reinterpret_cast<const GLvoid*>(static_cast<uintptr_t>(p->getBufferOffset()));
+}
+
+void GLEScontext::bindHostArrayBuffer(GLuint buffer) {
+    if(m_hostArrayBuffer != buffer) {
+        s_glDispatch.glBindBuffer(GL_ARRAY_BUFFER,buffer);
+        m_hostArrayBuffer = buffer;
+    }
+}
+
+//
+// the conversions of client arrays are kept from draw to draw, as GLES 1
+// apps draw the same static geometry from client arrays every frame.
+// The decoder hands every array from the same place, so a conversion is
+// found by the hash of the source vertices rather than by their pointer,
+// and a copy of them is kept to tell a collision from a hit.
+// Arrays are only kept once seen twice: the ones rewritten before each
+// draw are converted per draw as before and cost a hash.
+//
+
+//the rounds of xxHash64, 4 lanes wide to read the vertices at memory speed
+#define HASH_PRIME1 0x9E3779B185EBCA87ULL
+#define HASH_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define HASH_PRIME3 0x165667B19E3779F9ULL
+#define HASH_PRIME4 0x85EBCA77C2B2AE63ULL
+#define HASH_PRIME5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t rotl64(uint64_t x,int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const char* p) {
+    uint64_t v;
+    memcpy(&v,p,sizeof(v));
+    return v;
+}
+
+static inline uint64_t hashRound(uint64_t acc,uint64_t input) {
+    acc += input * HASH_PRIME2;
+    acc = rotl64(acc,31);
+    return acc * HASH_PRIME1;
+}
+
+static inline uint64_t hashMerge(uint64_t h,uint64_t acc) {
+    h ^= hashRound(0,acc);
+    return h * HASH_PRIME1 + HASH_PRIME4;
+}
+
+static uint64_t hashBytes(const char* p,unsigned int len,uint64_t seed) {
+    const char* end = p + len;
+    uint64_t h;
+    if(len >= 32) {
+        uint64_t v1 = seed + HASH_PRIME1 + HASH_PRIME2;
+        uint64_t v2 = seed + HASH_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - HASH_PRIME1;
+        for(; p + 32 <= end; p += 32) {
+            v1 = hashRound(v1,read64(p));
+            v2 = hashRound(v2,read64(p+8));
+            v3 = hashRound(v3,read64(p+16));
+            v4 = hashRound(v4,read64(p+24));
+        }
+        h = rotl64(v1,1) + rotl64(v2,7) + rotl64(v3,12) + rotl64(v4,18);
+        h = hashMerge(h,v1);
+        h = hashMerge(h,v2);
+        h = hashMerge(h,v3);
+        h = hashMerge(h,v4);
+    } else {
+        h = seed + HASH_PRIME5;
+    }
+    h += len;
+    for(; p + 8 <= end; p += 8) {
+        h ^= hashRound(0,read64(p));
+        h = rotl64(h,27) * HASH_PRIME1 + HASH_PRIME4;
+    }
+    for(; p < end; p++) {
+        h ^= (unsigned char)(*p) * HASH_PRIME5;
+        h = rotl64(h,11) * HASH_PRIME1;
+    }
+    h ^= h >> 33;
+    h *= HASH_PRIME2;
+    h ^= h >> 29;
+    h *= HASH_PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+void GLEScontext::releaseHostBuffers(const std::vector<GLuint>& buffers) {
+    s_lock.lock();
+    s_releasedBuffers.insert(s_releasedBuffers.end(),buffers.begin(),buffers.end());
+    s_lock.unlock();
+}
+
+//called by setupArraysPointers before the arrays of a draw are converted
+void GLEScontext::startDraw() {
+    m_draw++;
+    s_lock.lock();
+    if(!s_releasedBuffers.empty()) {
+        s_glDispatch.glDeleteBuffers(s_releasedBuffers.size(),&s_releasedBuffers[0]);
+        s_releasedBuffers.clear();
+    }
+    s_lock.unlock();
+}
+
+//sets the conversion of the vertices first to first+count-1 of the
+//client array p, kept by an earlier draw or made and kept now. Returns
+//false when the array is to be converted for this draw only.
+bool GLEScontext::convertCached(GLESConversionArrays& cArrs,GLint first,GLsizei count,GLESpointer* p) {
+    GLenum type    = p->getType();
+    int attribSize = p->getSize();
+    unsigned int bytes = type == GL_FIXED ? sizeof(GLfixed):sizeof(GLbyte);
+    unsigned int stride = p->getStride()?p->getStride():bytes*attribSize;
+    const char* data = (const char*)p->getArrayData();
+    if(!data || count <= 0) return false;
+    data += first*stride;
+
+    //the entries hold the vertices drawn, whatever their index in the array
+    unsigned int sourceBytes = (count-1)*stride + bytes*attribSize;
+    uint64_t seed = ((uint64_t)type << 48) ^ ((uint64_t)attribSize << 40) ^ ((uint64_t)stride << 24) ^
+                    (unsigned int)count;
+    uint64_t hash = hashBytes(data,sourceBytes,seed);
+    GLenum convertedType = type == GL_FIXED ? GL_FLOAT:GL_SHORT;
+    unsigned int vertexBytes = attribSize*(type == GL_FIXED ? sizeof(GLfloat):sizeof(GLshort));
+
+    for(unsigned int i=0;i<m_convertedArrays.size();i++) {
+        ConvertedArray& arr = m_convertedArrays[i];
+        if(arr.hash == hash && arr.type == type && arr.size == attribSize &&
+           arr.stride == stride && arr.count == count &&
+           !memcmp(arr.source,data,sourceBytes)) {
+            arr.lastDraw = m_draw;
+            setConvertedArray(cArrs,arr,first,convertedType,vertexBytes);
+            return true;
+        }
+    }
+
+    bool seen = false;
+    for(int i=0;i<CONVERSION_CANDIDATES;i++) {
+        if(m_conversionCandidates[i] == hash) {
+            seen = true;
+            break;
+        }
+    }
+    if(!seen) {
+        m_conversionCandidates[m_nextCandidate] = hash;
+        m_nextCandidate = (m_nextCandidate + 1) % CONVERSION_CANDIDATES;
+        return false;
+    }
+
+    unsigned int size = vertexBytes*count + sourceBytes;
+    if(size > MAX_CONVERTED_ARRAYS_BYTES) return false;
+
+    //making room from the least recently drawn, leaving this draw's arrays
+    while(m_convertedArrays.size() >= MAX_CONVERTED_ARRAYS ||
+          m_convertedBytes + size > MAX_CONVERTED_ARRAYS_BYTES) {
+        int lru = -1;
+        for(unsigned int i=0;i<m_convertedArrays.size();i++) {
+            if(m_convertedArrays[i].lastDraw == m_draw) continue;
+            if(lru < 0 || m_convertedArrays[i].lastDraw < m_convertedArrays[lru].lastDraw) lru = i;
+        }
+        if(lru < 0) return false;
+        releaseConvertedArray(m_convertedArrays[lru]);
+        m_convertedArrays.erase(m_convertedArrays.begin() + lru);
+    }
+
+    ConvertedArray arr;
+    arr.hash     = hash;
+    arr.type     = type;
+    arr.size     = attribSize;
+    arr.stride   = stride;
+    arr.count    = count;
+    arr.bytes    = size;
+    arr.buffer   = 0;
+    arr.lastDraw = m_draw;
+    arr.source   = new char[sourceBytes];
+    memcpy(arr.source,data,sourceBytes);
+    if(type == GL_FIXED) {
+        GLfloat* out = new GLfloat[attribSize*count];
+        getVertexConversion().fixedDirect(data,stride,out,count,attribSize);
+        arr.data = out;
+    } else {
+        GLshort* out = new GLshort[attribSize*count];
+        getVertexConversion().byteDirect(data,stride,out,count,attribSize);
+        arr.data = out;
+    }
+
+    s_glDispatch.glGenBuffers(1,&arr.buffer);
+    if(arr.buffer) {
+        bindHostArrayBuffer(arr.buffer);
+        s_glDispatch.glBufferData(GL_ARRAY_BUFFER,count*vertexBytes,arr.data,GL_STATIC_DRAW);
+    }
+
+    m_convertedArrays.push_back(arr);
+    m_convertedBytes += size;
+    setConvertedArray(cArrs,arr,first,convertedType,vertexBytes);
+    return true;
+}
+
+//the draw reads the entry from vertex 'first' on. The host buffer is read
+//by offset from 0, so it only serves the draws from vertex 0, which all
+//the indexed ones are; the others read the CPU copy from client memory.
+void GLEScontext::setConvertedArray(GLESConversionArrays& cArrs,const ConvertedArray& arr,GLint first,GLenum convertedType,unsigned int vertexBytes) {
+    if(first == 0) {
+        cArrs.setArr(arr.data,0,convertedType,arr.buffer);
+    } else {
+        cArrs.setArr(static_cast<char*>(arr.data) - first*vertexBytes,0,convertedType);
+    }
+}
+
+void GLEScontext::releaseConvertedArray(ConvertedArray& arr) {
+    if(arr.buffer) {
+        if(m_hostArrayBuffer == arr.buffer) m_hostArrayBuffer = 0;
+        s_glDispatch.glDeleteBuffers(1,&arr.buffer);
+        arr.buffer = 0;
+    }
+    if(arr.type == GL_FIXED) {
+        delete[] static_cast<GLfloat*>(arr.data);
+    } else {
+        delete[] static_cast<GLshort*>(arr.data);
+    }
+    arr.data = NULL;
+    delete[] arr.source;
+    arr.source = NULL;
+    m_convertedBytes -= arr.bytes;
 }
 
 
@@ -447,6 +682,14 @@ GLvoid* GLEScontext::getBindedBuffer(GLenum target) {
     return vbo->getData();
 }
 
+GLuint GLEScontext::getBindedBufferHostName(GLenum target) {
+    GLuint bufferName = getBuffer(target);
+    if(!bufferName) return 0;
+
+    GLESbuffer* vbo = static_cast<GLESbuffer*>(m_shareGroup->getObjectData(VERTEXBUFFER,bufferName).Ptr());
+    return vbo->getHostName();
+}
+
 void GLEScontext::getBufferSize(GLenum target,GLint* param) {
     GLuint bufferName = getBuffer(target);
     GLESbuffer* vbo = static_cast<GLESbuffer*>(m_shareGroup->getObjectData(VERTEXBUFFER,bufferName).Ptr());
@@ -463,7 +706,16 @@ bool GLEScontext::setBufferData(GLenum target,GLsizeiptr size,const GLvoid* data
     GLuint bufferName = getBuffer(target);
     if(!bufferName) return false;
     GLESbuffer* vbo = static_cast<GLESbuffer*>(m_shareGroup->getObjectData(VERTEXBUFFER,bufferName).Ptr());
-    return vbo->setBuffer(size,usage,data);
+    if(!vbo->setBuffer(size,usage,data)) return false;
+
+    //the host buffers are left unbound between the calls, so that the
+    //client arrays set up by the translator stay pointers
+    GLuint hostName = m_shareGroup->getGlobalName(VERTEXBUFFER,bufferName);
+    vbo->setHostName(hostName);
+    s_glDispatch.glBindBuffer(target,hostName);
+    s_glDispatch.glBufferData(target,size,data,usage);
+    s_glDispatch.glBindBuffer(target,0);
+    return true;
 }
 
 bool GLEScontext::setBufferSubData(GLenum target,GLintptr offset,GLsizeiptr size,const GLvoid* data) {
@@ -471,7 +723,12 @@ bool GLEScontext::setBufferSubData(GLenum target,GLintptr offset,GLsizeiptr size
     GLuint bufferName = getBuffer(target);
     if(!bufferName) return false;
     GLESbuffer* vbo = static_cast<GLESbuffer*>(m_shareGroup->getObjectData(VERTEXBUFFER,bufferName).Ptr());
-    return vbo->setSubBuffer(offset,size,data);
+    if(!vbo->setSubBuffer(offset,size,data)) return false;
+
+    s_glDispatch.glBindBuffer(target,vbo->getHostName());
+    s_glDispatch.glBufferSubData(target,offset,size,data);
+    s_glDispatch.glBindBuffer(target,0);
+    return true;
 }
 
 const char * GLEScontext::getExtensionString() {
@@ -555,6 +812,9 @@ void GLEScontext::initCapsLocked(const GLubyte * extensionString)
     if (strstr(cstring,"GL_OES_standard_derivatives ")!=NULL)
         s_glSupport.GL_OES_STANDARD_DERIVATIVES = true;
 
+    if (strstr(cstring,"GL_EXT_framebuffer_blit ")!=NULL)
+        s_glSupport.GL_EXT_FRAMEBUFFER_BLIT = true;
+
 }
 
 void GLEScontext::buildStrings(const char* baseVendor,
@@ -756,3 +1016,135 @@ void GLEScontext::drawValidate(void)
 
     fbData->validate(this);
 }
+
+//
+// saveHostError - an error the guest's calls left in the host is kept
+// for glGetError, before a host only call checks its own
+//
+void GLEScontext::saveHostError()
+{
+    GLenum err;
+    while ((err = s_glDispatch.glGetError()) != GL_NO_ERROR) {
+        if (m_glError == GL_NO_ERROR) {
+            m_glError = err;
+        }
+    }
+}
+
+//
+// blitTarget - get the host framebuffer object rendering to the texture
+// 'texName' of the EGLImage 'imageId'. If it is not kept, one is made in
+// place of the least recently used one. 0 if it is incomplete.
+//
+GLuint GLEScontext::blitTarget(unsigned int imageId, GLuint texName)
+{
+    BlitTarget *victim = NULL;
+    for (int i = 0; i < BLIT_TARGETS; i++) {
+        BlitTarget &t = m_blitTargets[i];
+        if (t.fbo && t.imageId == imageId) {
+            t.lastUse = ++m_blitUse;
+            return t.fbo;
+        }
+        if (!victim ||
+            (victim->fbo && (!t.fbo || t.lastUse < victim->lastUse))) {
+            victim = &t;
+        }
+    }
+
+    if (victim->fbo) {
+        s_glDispatch.glDeleteFramebuffersEXT(1, &victim->fbo);
+        victim->fbo = 0;
+    }
+
+    GLuint fbo = 0;
+    s_glDispatch.glGenFramebuffersEXT(1, &fbo);
+    s_glDispatch.glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fbo);
+    s_glDispatch.glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT,
+                                           GL_COLOR_ATTACHMENT0_OES,
+                                           GL_TEXTURE_2D, texName, 0);
+    GLenum status = s_glDispatch.glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
+    GLuint cur = m_framebuffer ?
+                 m_shareGroup->getGlobalName(FRAMEBUFFER, m_framebuffer) : 0;
+    s_glDispatch.glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, cur);
+    if (status != GL_FRAMEBUFFER_COMPLETE_OES) {
+        s_glDispatch.glDeleteFramebuffersEXT(1, &fbo);
+        return 0;
+    }
+
+    victim->imageId = imageId;
+    victim->fbo = fbo;
+    victim->lastUse = ++m_blitUse;
+    return fbo;
+}
+
+//
+// blitFramebuffer - copy the color of the bound framebuffer into the
+// texture 'texName' of the EGLImage 'imageId' with glBlitFramebufferEXT,
+// which flips the copy when the destination rectangle is upside down.
+// Fails when the host raises an error on the blit. The framebuffer
+// binding and scissor test are left as they were.
+//
+bool GLEScontext::blitFramebuffer(unsigned int imageId, GLuint texName,
+                                  GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+                                  GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1)
+{
+    if (!s_glSupport.GL_EXT_FRAMEBUFFER_BLIT ||
+        !s_glDispatch.glBlitFramebufferEXT || !m_shareGroup.Ptr()) {
+        return false;
+    }
+    saveHostError();
+    GLuint dst = blitTarget(imageId, texName);
+    if (!dst) {
+        return false;
+    }
+    GLuint cur = m_framebuffer ?
+                 m_shareGroup->getGlobalName(FRAMEBUFFER, m_framebuffer) : 0;
+
+    GLboolean scissor = s_glDispatch.glIsEnabled(GL_SCISSOR_TEST);
+    if (scissor) {
+        s_glDispatch.glDisable(GL_SCISSOR_TEST);
+    }
+    s_glDispatch.glBindFramebufferEXT(GL_DRAW_FRAMEBUFFER_EXT, dst);
+    s_glDispatch.glBlitFramebufferEXT(srcX0, srcY0, srcX1, srcY1,
+                                      dstX0, dstY0, dstX1, dstY1,
+                                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    // e.g. GL_INVALID_OPERATION from a multisampled read buffer
+    bool ret = s_glDispatch.glGetError() == GL_NO_ERROR;
+    s_glDispatch.glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, cur);
+    if (scissor) {
+        s_glDispatch.glEnable(GL_SCISSOR_TEST);
+    }
+    return ret;
+}
+
+//
+// copyTexSubImage - copy a rectangle of the bound framebuffer to the
+// origin of the host texture 'texName', as it is. The texture binding
+// is left as it was.
+//
+bool GLEScontext::copyTexSubImage(GLuint texName, GLint x, GLint y,
+                                  GLsizei width, GLsizei height)
+{
+    saveHostError();
+    GLint prevTex = 0;
+    s_glDispatch.glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTex);
+    s_glDispatch.glBindTexture(GL_TEXTURE_2D, texName);
+    s_glDispatch.glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, x, y, width, height);
+    bool ret = s_glDispatch.glGetError() == GL_NO_ERROR;
+    s_glDispatch.glBindTexture(GL_TEXTURE_2D, prevTex);
+    return ret;
+}
+
+//
+// releaseBlitTargets - delete the host framebuffer objects of
+// blitFramebuffer, with the context current
+//
+void GLEScontext::releaseBlitTargets()
+{
+    for (int i = 0; i < BLIT_TARGETS; i++) {
+        if (m_blitTargets[i].fbo) {
+            s_glDispatch.glDeleteFramebuffersEXT(1, &m_blitTargets[i].fbo);
+        }
+    }
+    memset(m_blitTargets,0,sizeof(m_blitTargets));
+}
@@ -60,6 +60,10 @@ GLuint GLESpointer::getBufferName() const {
     return m_bufferName;
 }
 
+GLuint GLESpointer::getBufferHostName() const {
+    return m_buffer ? m_buffer->getHostName() : 0;
+}
+
 unsigned int GLESpointer::getBufferOffset() const {
 
     return  m_buffOffset;
@@ -0,0 +1,438 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include <GLcommon/VertexConversion.h>
+#include <GLcommon/GLconversion_macros.h>
+
+//
+// The x86 kernels are built for their instruction set whatever the
+// compiler flags, and chosen at run time. NEON is known at build time.
+//
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define VERTEX_CONVERSION_X86
+#include <immintrin.h>
+#define SSE2_FUNC __attribute__((target("sse2")))
+#define AVX2_FUNC __attribute__((target("avx2")))
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define VERTEX_CONVERSION_NEON
+#include <arm_neon.h>
+#endif
+
+#define MAX_VERTEX_CONVERSIONS 4
+
+static inline unsigned short readIndex(GLenum indices_type,const GLvoid* indices,int i) {
+    return indices_type == GL_UNSIGNED_BYTE ? static_cast<const GLubyte*>(indices)[i]:
+                                              static_cast<const GLushort*>(indices)[i];
+}
+
+//
+// the plain loops, one component at a time
+//
+
+static void fixedDirectLoop(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int count,int attribSize) {
+    GLfloat* float_data = static_cast<GLfloat*>(dataOut);
+    for(unsigned int i = 0; i < count; i++) {
+        const GLfixed* fixed_data = (const GLfixed *)dataIn;
+        for(int j=0;j<attribSize;j++) {
+            float_data[j] = X2F(fixed_data[j]);
+        }
+        float_data += attribSize;
+        dataIn += strideIn;
+    }
+}
+
+static void fixedIndirectLoop(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut,int attribSize) {
+    for(int i = 0 ;i < count ;i++) {
+        unsigned short index = readIndex(indices_type,indices,i);
+        const GLfixed* fixed_data = (const GLfixed *)(dataIn  + index*strideIn);
+        GLfloat* float_data = reinterpret_cast<GLfloat*>(static_cast<unsigned char*>(dataOut) + index*strideOut);
+
+        for(int j=0;j<attribSize;j++) {
+            float_data[j] = X2F(fixed_data[j]);
+        }
+    }
+}
+
+static void byteDirectLoop(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int count,int attribSize) {
+    GLshort* short_data = static_cast<GLshort*>(dataOut);
+    for(unsigned int i = 0; i < count; i++) {
+        const GLbyte* byte_data = (const GLbyte *)dataIn;
+        for(int j=0;j<attribSize;j++) {
+            short_data[j] = B2S(byte_data[j]);
+        }
+        short_data += attribSize;
+        dataIn += strideIn;
+    }
+}
+
+static void byteIndirectLoop(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut,int attribSize) {
+    for(int i = 0 ;i < count ;i++) {
+        unsigned short index = readIndex(indices_type,indices,i);
+        const GLbyte* bytes_data = (const GLbyte *)(dataIn  + index*strideIn);
+        GLshort* short_data = reinterpret_cast<GLshort*>(static_cast<unsigned char*>(dataOut) + index*strideOut);
+
+        for(int j=0;j<attribSize;j++) {
+            short_data[j] = B2S(bytes_data[j]);
+        }
+    }
+}
+
+//
+// the same loops with the attribute size known to the compiler, for the
+// sizes 1 to 4 of the GLES arrays. They also do the vertices the vector
+// kernels leave.
+//
+
+static inline GLfloat convertComponent(GLfixed x) { return X2F(x); }
+static inline GLshort convertComponent(GLbyte b) { return B2S(b); }
+
+template <class IN,class OUT,int N>
+static void directSized(const char* dataIn,unsigned int strideIn,OUT* out,unsigned int count) {
+    for(unsigned int i = 0; i < count; i++,dataIn += strideIn,out += N) {
+        const IN* in = (const IN*)dataIn;
+        for(int j=0;j<N;j++) {
+            out[j] = convertComponent(in[j]);
+        }
+    }
+}
+
+template <class IN,class OUT,int N>
+static void indirectSized(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut) {
+    for(int i = 0; i < count; i++) {
+        unsigned short index = readIndex(indices_type,indices,i);
+        const IN* in = (const IN*)(dataIn + index*strideIn);
+        OUT* out = reinterpret_cast<OUT*>(static_cast<unsigned char*>(dataOut) + index*strideOut);
+        for(int j=0;j<N;j++) {
+            out[j] = convertComponent(in[j]);
+        }
+    }
+}
+
+template <class IN,class OUT>
+static void directAnySize(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int count,int attribSize,directConversionFunc loop) {
+    OUT* out = static_cast<OUT*>(dataOut);
+    switch(attribSize) {
+    case 1: directSized<IN,OUT,1>(dataIn,strideIn,out,count); break;
+    case 2: directSized<IN,OUT,2>(dataIn,strideIn,out,count); break;
+    case 3: directSized<IN,OUT,3>(dataIn,strideIn,out,count); break;
+    case 4: directSized<IN,OUT,4>(dataIn,strideIn,out,count); break;
+    default: loop(dataIn,strideIn,dataOut,count,attribSize);
+    }
+}
+
+template <class IN,class OUT>
+static void indirectAnySize(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut,int attribSize,indirectConversionFunc loop) {
+    switch(attribSize) {
+    case 1: indirectSized<IN,OUT,1>(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut); break;
+    case 2: indirectSized<IN,OUT,2>(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut); break;
+    case 3: indirectSized<IN,OUT,3>(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut); break;
+    case 4: indirectSized<IN,OUT,4>(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut); break;
+    default: loop(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut,attribSize);
+    }
+}
+
+static void fixedDirectSized(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int count,int attribSize) {
+    directAnySize<GLfixed,GLfloat>(dataIn,strideIn,dataOut,count,attribSize,fixedDirectLoop);
+}
+
+static void fixedIndirectSized(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut,int attribSize) {
+    indirectAnySize<GLfixed,GLfloat>(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut,attribSize,fixedIndirectLoop);
+}
+
+static void byteDirectSized(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int count,int attribSize) {
+    directAnySize<GLbyte,GLshort>(dataIn,strideIn,dataOut,count,attribSize,byteDirectLoop);
+}
+
+static void byteIndirectSized(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut,int attribSize) {
+    indirectAnySize<GLbyte,GLshort>(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut,attribSize,byteIndirectLoop);
+}
+
+#ifdef VERTEX_CONVERSION_X86
+
+//
+// SSE2: a vertex of 2 to 4 fixed components at a time, or 4 components
+// of a tightly packed array. Bytes are only worth a vector when packed.
+//
+
+SSE2_FUNC static inline __m128 fixedToFloatSSE2(__m128i v) {
+    return _mm_mul_ps(_mm_cvtepi32_ps(v),_mm_set1_ps(1.0f/65536.0f));
+}
+
+SSE2_FUNC static void fixedPackedSSE2(const GLfixed* in,GLfloat* out,unsigned int n) {
+    unsigned int i = 0;
+    for(; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out+i,fixedToFloatSSE2(_mm_loadu_si128((const __m128i*)(in+i))));
+    }
+    for(; i < n; i++) {
+        out[i] = X2F(in[i]);
+    }
+}
+
+SSE2_FUNC static void fixedDirectSSE2(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int count,int attribSize) {
+    GLfloat* out = static_cast<GLfloat*>(dataOut);
+    if(strideIn == attribSize*sizeof(GLfixed)) {
+        fixedPackedSSE2((const GLfixed*)dataIn,out,count*attribSize);
+        return;
+    }
+
+    unsigned int i = 0;
+    if(attribSize == 4) {
+        for(; i < count; i++,dataIn += strideIn,out += 4) {
+            _mm_storeu_ps(out,fixedToFloatSSE2(_mm_loadu_si128((const __m128i*)dataIn)));
+        }
+    } else if(attribSize == 3 && strideIn >= 4*sizeof(GLfixed)) {
+        //a vector reads and writes a component of the next vertex, which
+        //is done after, so the last vertex is left to the loop below
+        for(; i + 1 < count; i++,dataIn += strideIn,out += 3) {
+            _mm_storeu_ps(out,fixedToFloatSSE2(_mm_loadu_si128((const __m128i*)dataIn)));
+        }
+    } else if(attribSize == 2) {
+        for(; i < count; i++,dataIn += strideIn,out += 2) {
+            _mm_storel_pi((__m64*)out,fixedToFloatSSE2(_mm_loadl_epi64((const __m128i*)dataIn)));
+        }
+    }
+    fixedDirectSized(dataIn,strideIn,out,count-i,attribSize);
+}
+
+template <int N>
+SSE2_FUNC static void fixedIndirectSizedSSE2(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut) {
+    //the vertices are written in the order of the indices, so a vector
+    //must not go past its vertex
+    for(int i = 0; i < count; i++) {
+        unsigned short index = readIndex(indices_type,indices,i);
+        const GLfixed* in = (const GLfixed*)(dataIn + index*strideIn);
+        GLfloat* out = reinterpret_cast<GLfloat*>(static_cast<unsigned char*>(dataOut) + index*strideOut);
+        if(N == 4) {
+            _mm_storeu_ps(out,fixedToFloatSSE2(_mm_loadu_si128((const __m128i*)in)));
+        } else {
+            _mm_storel_pi((__m64*)out,fixedToFloatSSE2(_mm_loadl_epi64((const __m128i*)in)));
+            if(N == 3) {
+                out[2] = X2F(in[2]);
+            }
+        }
+    }
+}
+
+SSE2_FUNC static void fixedIndirectSSE2(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut,int attribSize) {
+    switch(attribSize) {
+    case 2: fixedIndirectSizedSSE2<2>(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut); break;
+    case 3: fixedIndirectSizedSSE2<3>(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut); break;
+    case 4: fixedIndirectSizedSSE2<4>(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut); break;
+    default: fixedIndirectSized(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut,attribSize);
+    }
+}
+
+SSE2_FUNC static void bytePackedSSE2(const GLbyte* in,GLshort* out,unsigned int n) {
+    unsigned int i = 0;
+    for(; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(in+i));
+        //each byte next to itself, then shifted down with its sign
+        _mm_storeu_si128((__m128i*)(out+i),_mm_srai_epi16(_mm_unpacklo_epi8(v,v),8));
+        _mm_storeu_si128((__m128i*)(out+i+8),_mm_srai_epi16(_mm_unpackhi_epi8(v,v),8));
+    }
+    for(; i < n; i++) {
+        out[i] = B2S(in[i]);
+    }
+}
+
+SSE2_FUNC static void byteDirectSSE2(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int count,int attribSize) {
+    if(strideIn == (unsigned int)attribSize) {
+        bytePackedSSE2((const GLbyte*)dataIn,static_cast<GLshort*>(dataOut),count*attribSize);
+        return;
+    }
+    byteDirectSized(dataIn,strideIn,dataOut,count,attribSize);
+}
+
+//
+// AVX2: the packed arrays 8 fixed or 16 bytes at a time, the rest as SSE2
+//
+
+AVX2_FUNC static void fixedDirectAVX2(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int count,int attribSize) {
+    if(strideIn != attribSize*sizeof(GLfixed)) {
+        fixedDirectSSE2(dataIn,strideIn,dataOut,count,attribSize);
+        return;
+    }
+
+    const GLfixed* in = (const GLfixed*)dataIn;
+    GLfloat* out = static_cast<GLfloat*>(dataOut);
+    unsigned int n = count*attribSize;
+    unsigned int i = 0;
+    const __m256 scale = _mm256_set1_ps(1.0f/65536.0f);
+    for(; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(in+i));
+        _mm256_storeu_ps(out+i,_mm256_mul_ps(_mm256_cvtepi32_ps(v),scale));
+    }
+    for(; i < n; i++) {
+        out[i] = X2F(in[i]);
+    }
+}
+
+AVX2_FUNC static void byteDirectAVX2(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int count,int attribSize) {
+    if(strideIn != (unsigned int)attribSize) {
+        byteDirectSized(dataIn,strideIn,dataOut,count,attribSize);
+        return;
+    }
+
+    const GLbyte* in = (const GLbyte*)dataIn;
+    GLshort* out = static_cast<GLshort*>(dataOut);
+    unsigned int n = count*attribSize;
+    unsigned int i = 0;
+    for(; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(in+i));
+        _mm256_storeu_si256((__m256i*)(out+i),_mm256_cvtepi8_epi16(v));
+    }
+    for(; i < n; i++) {
+        out[i] = B2S(in[i]);
+    }
+}
+
+#endif // VERTEX_CONVERSION_X86
+
+#ifdef VERTEX_CONVERSION_NEON
+
+//
+// NEON: as SSE2, the fixed point conversion being a single instruction
+//
+
+static void fixedDirectNEON(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int count,int attribSize) {
+    GLfloat* out = static_cast<GLfloat*>(dataOut);
+    unsigned int i = 0;
+    if(strideIn == attribSize*sizeof(GLfixed)) {
+        const GLfixed* in = (const GLfixed*)dataIn;
+        unsigned int n = count*attribSize;
+        for(; i + 4 <= n; i += 4) {
+            vst1q_f32(out+i,vcvtq_n_f32_s32(vld1q_s32(in+i),16));
+        }
+        for(; i < n; i++) {
+            out[i] = X2F(in[i]);
+        }
+        return;
+    }
+
+    if(attribSize == 4) {
+        for(; i < count; i++,dataIn += strideIn,out += 4) {
+            vst1q_f32(out,vcvtq_n_f32_s32(vld1q_s32((const int32_t*)dataIn),16));
+        }
+    } else if(attribSize == 2) {
+        for(; i < count; i++,dataIn += strideIn,out += 2) {
+            vst1_f32(out,vcvt_n_f32_s32(vld1_s32((const int32_t*)dataIn),16));
+        }
+    }
+    fixedDirectSized(dataIn,strideIn,out,count-i,attribSize);
+}
+
+template <int N>
+static void fixedIndirectSizedNEON(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut) {
+    for(int i = 0; i < count; i++) {
+        unsigned short index = readIndex(indices_type,indices,i);
+        const int32_t* in = (const int32_t*)(dataIn + index*strideIn);
+        GLfloat* out = reinterpret_cast<GLfloat*>(static_cast<unsigned char*>(dataOut) + index*strideOut);
+        if(N == 4) {
+            vst1q_f32(out,vcvtq_n_f32_s32(vld1q_s32(in),16));
+        } else {
+            vst1_f32(out,vcvt_n_f32_s32(vld1_s32(in),16));
+        }
+    }
+}
+
+static void fixedIndirectNEON(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut,int attribSize) {
+    switch(attribSize) {
+    case 2: fixedIndirectSizedNEON<2>(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut); break;
+    case 4: fixedIndirectSizedNEON<4>(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut); break;
+    default: fixedIndirectSized(dataIn,strideIn,dataOut,count,indices_type,indices,strideOut,attribSize);
+    }
+}
+
+static void byteDirectNEON(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int count,int attribSize) {
+    if(strideIn != (unsigned int)attribSize) {
+        byteDirectSized(dataIn,strideIn,dataOut,count,attribSize);
+        return;
+    }
+
+    const GLbyte* in = (const GLbyte*)dataIn;
+    GLshort* out = static_cast<GLshort*>(dataOut);
+    unsigned int n = count*attribSize;
+    unsigned int i = 0;
+    for(; i + 16 <= n; i += 16) {
+        int8x16_t v = vld1q_s8(in+i);
+        vst1q_s16(out+i,vmovl_s8(vget_low_s8(v)));
+        vst1q_s16(out+i+8,vmovl_s8(vget_high_s8(v)));
+    }
+    for(; i < n; i++) {
+        out[i] = B2S(in[i]);
+    }
+}
+
+#endif // VERTEX_CONVERSION_NEON
+
+static const VertexConversion s_loops = {
+    "loops", fixedDirectLoop, fixedIndirectLoop, byteDirectLoop, byteIndirectLoop
+};
+
+static const VertexConversion s_sized = {
+    "sized", fixedDirectSized, fixedIndirectSized, byteDirectSized, byteIndirectSized
+};
+
+#ifdef VERTEX_CONVERSION_X86
+static const VertexConversion s_sse2 = {
+    "sse2", fixedDirectSSE2, fixedIndirectSSE2, byteDirectSSE2, byteIndirectSized
+};
+
+static const VertexConversion s_avx2 = {
+    "avx2", fixedDirectAVX2, fixedIndirectSSE2, byteDirectAVX2, byteIndirectSized
+};
+#endif
+
+#ifdef VERTEX_CONVERSION_NEON
+static const VertexConversion s_neon = {
+    "neon", fixedDirectNEON, fixedIndirectNEON, byteDirectNEON, byteIndirectSized
+};
+#endif
+
+int getVertexConversions(const VertexConversion** conversions,int max) {
+    const VertexConversion* all[MAX_VERTEX_CONVERSIONS];
+    int n = 0;
+    all[n++] = &s_loops;
+    all[n++] = &s_sized;
+#ifdef VERTEX_CONVERSION_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse2")) {
+        all[n++] = &s_sse2;
+        if(__builtin_cpu_supports("avx2")) {
+            all[n++] = &s_avx2;
+        }
+    }
+#endif
+#ifdef VERTEX_CONVERSION_NEON
+    all[n++] = &s_neon;
+#endif
+
+    if(n > max) n = max;
+    for(int i = 0; i < n; i++) {
+        conversions[i] = all[i];
+    }
+    return n;
+}
+
+static const VertexConversion* chooseVertexConversion() {
+    const VertexConversion* all[MAX_VERTEX_CONVERSIONS];
+    int n = getVertexConversions(all,MAX_VERTEX_CONVERSIONS);
+    return all[n-1];
+}
+
+const VertexConversion& getVertexConversion() {
+    static const VertexConversion* s_best = chooseVertexConversion();
+    return *s_best;
+}
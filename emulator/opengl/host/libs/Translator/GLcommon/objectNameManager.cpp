@@ -174,6 +174,16 @@ ShareGroup::ShareGroup(GlobalNameSpace *globalNameSpace)
 ShareGroup::~ShareGroup()
 {
     mutex_lock(&m_lock);
+
+    // GlobalNameSpace::deleteName does not delete the host objects, the
+    // buffers which were not deleted by the guest are released here
+    std::vector<GLuint> buffers;
+    NamesMap &bufferNames = m_nameSpace[VERTEXBUFFER]->m_localToGlobalMap;
+    for (NamesMap::iterator n = bufferNames.begin(); n != bufferNames.end(); n++) {
+        if ((*n).second) buffers.push_back((*n).second);
+    }
+    GLEScontext::releaseHostBuffers(buffers);
+
     for (int t = 0; t < NUM_OBJECT_TYPES; t++) {
         delete m_nameSpace[t];
     }
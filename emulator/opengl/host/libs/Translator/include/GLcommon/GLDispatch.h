@@ -113,6 +113,7 @@ public:
     static void (GLAPIENTRY *glFramebufferRenderbufferEXT) (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer);
     static void (GLAPIENTRY *glGetFramebufferAttachmentParameterivEXT) (GLenum target, GLenum attachment, GLenum pname, GLint *params);
     static void (GLAPIENTRY *glGenerateMipmapEXT) (GLenum target);
+    static void (GLAPIENTRY *glBlitFramebufferEXT) (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter);
 
     /* OpenGL functions which are needed ONLY for implementing GLES 1.1*/
     static void (GLAPIENTRY *glAlphaFunc) (GLenum func, GLclampf ref);
@@ -21,12 +21,20 @@
 #include <GLcommon/objectNameManager.h>
 #include <GLcommon/RangeManip.h>
 
+//
+// the contents live in a host buffer object, which the draws read from.
+// m_data is a CPU copy of them, kept for the indices read by the
+// translator and for the GL_FIXED arrays, which are converted in place
+// and written back to the host buffer.
+//
 class GLESbuffer: public ObjectData {
 public:
-   GLESbuffer():ObjectData(BUFFER_DATA),m_size(0),m_usage(GL_STATIC_DRAW),m_data(NULL),m_wasBound(false){}
+   GLESbuffer():ObjectData(BUFFER_DATA),m_size(0),m_usage(GL_STATIC_DRAW),m_data(NULL),m_hostName(0),m_wasBound(false){}
    GLuint getSize(){return m_size;};
    GLuint getUsage(){return m_usage;};
    GLvoid* getData(){ return m_data;}
+   GLuint getHostName(){ return m_hostName;}
+   void   setHostName(GLuint name){ m_hostName = name;}
    bool  setBuffer(GLuint size,GLuint usage,const GLvoid* data);
    bool  setSubBuffer(GLint offset,GLuint size,const GLvoid* data);
    void  getConversions(const RangeList& rIn,RangeList& rOut);
@@ -39,6 +47,7 @@ private:
     GLuint         m_size;
     GLuint         m_usage;
     unsigned char* m_data;
+    GLuint         m_hostName;    //0 until the first glBufferData
     RangeList      m_conversionManager;
     bool           m_wasBound;
 };
@@ -22,9 +22,16 @@
 #include "objectNameManager.h"
 #include <utils/threads.h>
 #include <string>
+#include <vector>
 
 typedef std::map<GLenum,GLESpointer*>  ArraysMap;
 
+//client arrays seen once, the ones seen again are kept converted
+#define CONVERSION_CANDIDATES 32
+
+//EGLImages the host framebuffer objects of blitFramebuffer are kept for
+#define BLIT_TARGETS 4
+
 enum TextureTarget {
 TEXTURE_2D,
 TEXTURE_CUBE_MAP,
@@ -60,7 +67,8 @@ struct GLSupport {
                 GL_EXT_PACKED_DEPTH_STENCIL(false) , GL_OES_READ_FORMAT(false), \
                 GL_ARB_HALF_FLOAT_PIXEL(false), GL_NV_HALF_FLOAT(false), \
                 GL_ARB_HALF_FLOAT_VERTEX(false),GL_SGIS_GENERATE_MIPMAP(false),
-                GL_ARB_ES2_COMPATIBILITY(false),GL_OES_STANDARD_DERIVATIVES(false) {} ;
+                GL_ARB_ES2_COMPATIBILITY(false),GL_OES_STANDARD_DERIVATIVES(false), \
+                GL_EXT_FRAMEBUFFER_BLIT(false) {} ;
     int  maxLights;
     int  maxVertexAttribs;
     int  maxClipPlane;
@@ -80,6 +88,7 @@ struct GLSupport {
     bool GL_SGIS_GENERATE_MIPMAP;
     bool GL_ARB_ES2_COMPATIBILITY;
     bool GL_OES_STANDARD_DERIVATIVES;
+    bool GL_EXT_FRAMEBUFFER_BLIT;
 
 };
 
@@ -87,19 +96,35 @@ struct ArrayData{
     ArrayData():data(NULL),
                 type(0),
                 stride(0),
+                buffer(0),
                 allocated(false){};
 
     void*        data;
     GLenum       type;
     unsigned int stride;
+    GLuint       buffer;    //host buffer converted in place, data is its CPU copy
     bool         allocated;
 };
 
+//a client array converted by an earlier draw, see GLEScontext::convertCached
+struct ConvertedArray{
+    unsigned long long hash;      //of the source vertices and of the fields below
+    GLenum             type;      //of the source, GL_FIXED or GL_BYTE
+    int                size;
+    unsigned int       stride;
+    GLsizei            count;
+    char*              source;    //copy of the source vertices, compared on a hit
+    void*              data;      //the conversion, vertex i at i*size
+    unsigned int       bytes;     //of source and data
+    GLuint             buffer;    //host buffer holding a copy of data, or 0
+    unsigned int       lastDraw;
+};
+
 class GLESConversionArrays
 {
 public:
     GLESConversionArrays():m_current(0){};
-    void setArr(void* data,unsigned int stride,GLenum type);
+    void setArr(void* data,unsigned int stride,GLenum type,GLuint buffer = 0);
     void allocArr(unsigned int size,GLenum type);
     ArrayData& operator[](int i);
     void* getCurrentData();
@@ -142,6 +167,7 @@ public:
     bool isBuffer(GLuint buffer);
     bool isBindedBuffer(GLenum target);
     GLvoid* getBindedBuffer(GLenum target);
+    GLuint getBindedBufferHostName(GLenum target);
     void getBufferSize(GLenum target,GLint* param);
     void getBufferUsage(GLenum target,GLint* param);
     bool setBufferData(GLenum target,GLsizeiptr size,const GLvoid* data,GLenum usage);
@@ -164,6 +190,20 @@ public:
 
     static GLDispatch& dispatcher(){return s_glDispatch;};
 
+    //host buffers of a share group going away, maybe with no context
+    //current: they are deleted by the next draw of any context
+    static void releaseHostBuffers(const std::vector<GLuint>& buffers);
+
+    // host only, see glBlitFramebufferEMU and glCopyToImageEMU. They
+    // draw into the texture of an EGLImage through host objects, which
+    // take no name of the share group.
+    bool blitFramebuffer(unsigned int imageId, GLuint texName,
+                         GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+                         GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1);
+    bool copyTexSubImage(GLuint texName, GLint x, GLint y,
+                         GLsizei width, GLsizei height);
+    void releaseBlitTargets();
+
     static int getMaxLights(){return s_glSupport.maxLights;}
     static int getMaxClipPlanes(){return s_glSupport.maxClipPlane;}
     static int getMaxTexSize(){return s_glSupport.maxTexSize;}
@@ -184,6 +224,10 @@ protected:
     void convertDirectVBO(GLESConversionArrays& fArrs,GLint first,GLsizei count,GLenum array_id,GLESpointer* p);
     void convertIndirect(GLESConversionArrays& fArrs,GLsizei count,GLenum type,const GLvoid* indices,GLenum array_id,GLESpointer* p);
     void convertIndirectVBO(GLESConversionArrays& fArrs,GLsizei count,GLenum indices_type,const GLvoid* indices,GLenum array_id,GLESpointer* p);
+    void uploadConversions(RangeList& conversions,GLESpointer* p);
+    const GLvoid* bindArrayData(GLESpointer* p,const ArrayData* converted);
+    void bindHostArrayBuffer(GLuint buffer);
+    void startDraw();
     void initCapsLocked(const GLubyte * extensionString);
     virtual void initExtensionString() =0;
 
@@ -200,15 +244,35 @@ private:
 
     virtual void setupArr(const GLvoid* arr,GLenum arrayType,GLenum dataType,GLint size,GLsizei stride, GLboolean normalized, int pointsIndex = -1) = 0 ;
     GLuint getBuffer(GLenum target);
+    bool convertCached(GLESConversionArrays& fArrs,GLint first,GLsizei count,GLESpointer* p);
+    void setConvertedArray(GLESConversionArrays& fArrs,const ConvertedArray& arr,GLint first,GLenum convertedType,unsigned int vertexBytes);
+    void releaseConvertedArray(ConvertedArray& arr);
+    void saveHostError();
+    GLuint blitTarget(unsigned int imageId, GLuint texName);
+
+    struct BlitTarget {
+        unsigned int imageId;
+        GLuint       fbo;      // host name
+        unsigned int lastUse;
+    };
 
     ShareGroupPtr         m_shareGroup;
     GLenum                m_glError;
     textureUnitState*     m_texState;
     unsigned int          m_arrayBuffer;
     unsigned int          m_elementBuffer;
+    GLuint                m_hostArrayBuffer;
     GLuint                m_renderbuffer;
     GLuint                m_framebuffer;
+    std::vector<ConvertedArray> m_convertedArrays;
+    unsigned int          m_convertedBytes;
+    unsigned long long    m_conversionCandidates[CONVERSION_CANDIDATES];
+    unsigned int          m_nextCandidate;
+    unsigned int          m_draw;
+    BlitTarget            m_blitTargets[BLIT_TARGETS];
+    unsigned int          m_blitUse;
 
+    static std::vector<GLuint> s_releasedBuffers;
     static std::string    s_glVendor;
     static std::string    s_glRenderer;
     static std::string    s_glVersion;
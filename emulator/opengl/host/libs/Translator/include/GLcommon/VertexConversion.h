@@ -0,0 +1,48 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _VERTEX_CONVERSION_H
+#define _VERTEX_CONVERSION_H
+
+#include <GLES/gl.h>
+
+//
+// the conversions of the GL_FIXED arrays to float and of the GL_BYTE
+// arrays to short, done by GLEScontext before the draws.
+//
+// The direct ones convert 'count' vertices of 'attribSize' components,
+// read every 'strideIn' bytes, into a tightly packed array. The indirect
+// ones convert the vertices named by the indices, and write each vertex
+// at index * 'strideOut' bytes; dataIn may be dataOut.
+//
+typedef void (*directConversionFunc)(const char* dataIn,unsigned int strideIn,void* dataOut,unsigned int count,int attribSize);
+typedef void (*indirectConversionFunc)(const char* dataIn,unsigned int strideIn,void* dataOut,GLsizei count,GLenum indices_type,const GLvoid* indices,unsigned int strideOut,int attribSize);
+
+struct VertexConversion {
+    const char*            name;
+    directConversionFunc   fixedDirect;
+    indirectConversionFunc fixedIndirect;
+    directConversionFunc   byteDirect;
+    indirectConversionFunc byteIndirect;
+};
+
+//fills 'conversions' with the kernels this CPU can run, from the plain
+//loops to the best ones, and returns their number
+int getVertexConversions(const VertexConversion** conversions,int max);
+
+//the best kernels for this CPU
+const VertexConversion& getVertexConversion();
+
+#endif
@@ -32,6 +32,8 @@ typedef double      GLdouble;   /* double precision float */
 #define GL_VERTEX_PROGRAM_POINT_SIZE 0x8642
 #define GL_POINT_SPRITE       0x8861
 #define GL_FRAMEBUFFER_EXT                0x8D40
+#define GL_READ_FRAMEBUFFER_EXT           0x8CA8
+#define GL_DRAW_FRAMEBUFFER_EXT           0x8CA9
 #define GL_TEXTURE_WIDTH			0x1000
 #define GL_TEXTURE_HEIGHT			0x1001
 #define GL_TEXTURE_RED_SIZE			0x805C
@@ -5,7 +5,7 @@ host_common_LDLIBS :=
 
 ifeq ($(HOST_OS),linux)
     host_OS_SRCS = NativeLinuxSubWindow.cpp
-    host_common_LDLIBS += -lX11
+    host_common_LDLIBS += -lX11 -lrt
 endif
 
 ifeq ($(HOST_OS),darwin)
@@ -21,14 +21,21 @@ host_common_SRC_FILES := \
     $(host_OS_SRCS) \
     render_api.cpp \
     ColorBuffer.cpp \
+    ColorBufferPool.cpp \
+    ColorBufferUploader.cpp \
+    Presenter.cpp \
+    DamageRegion.cpp \
     EGLDispatch.cpp \
     FBConfig.cpp \
     FrameBuffer.cpp \
+    FrameExport.cpp \
     GLDispatch.cpp \
     GL2Dispatch.cpp \
     RenderContext.cpp \
     WindowSurface.cpp \
     RenderControl.cpp \
+    RenderMetrics.cpp \
+    PostReadback.cpp \
     ThreadInfo.cpp \
     RenderThread.cpp \
     ReadBuffer.cpp \
@@ -36,6 +43,12 @@ host_common_SRC_FILES := \
 
 host_common_CFLAGS :=
 
+# decoders the render thread dispatches to, see emugl-gen-dispatcher
+host_dispatch_SPECS := \
+    $(EMUGL_PATH)/host/libs/GLESv1_dec/gl \
+    $(EMUGL_PATH)/host/libs/GLESv2_dec/gl2 \
+    $(EMUGL_PATH)/host/libs/renderControl_dec/renderControl
+
 #For gl debbuging
 #host_common_CFLAGS += -DCHECK_GL_ERROR
 
@@ -44,6 +57,7 @@ host_common_CFLAGS :=
 $(call emugl-begin-host-shared-library,libOpenglRender)
 
 $(call emugl-import,libGLESv1_dec libGLESv2_dec lib_renderControl_dec libOpenglCodecCommon libOpenglOsUtils)
+$(call emugl-gen-dispatcher,renderer,$(host_dispatch_SPECS))
 
 LOCAL_LDLIBS += $(host_common_LDLIBS)
 
@@ -65,6 +79,7 @@ $(call emugl-end-module)
 $(call emugl-begin-host-shared-library,lib64OpenglRender)
 
 $(call emugl-import,lib64GLESv1_dec lib64GLESv2_dec lib64_renderControl_dec lib64OpenglCodecCommon lib64OpenglOsUtils)
+$(call emugl-gen-dispatcher,renderer,$(host_dispatch_SPECS))
 
 #LOCAL_LDFLAGS += -m64  # adding -m64 here doesn't work, because it somehow appear BEFORE -m32 in command-line.
 LOCAL_LDLIBS += $(host_common_LDLIBS) -m64  # Put -m64 it in LOCAL_LDLIBS instead.
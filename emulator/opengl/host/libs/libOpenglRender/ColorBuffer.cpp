@@ -18,10 +18,16 @@
 #include "EGLDispatch.h"
 #include "GLDispatch.h"
 #include "ThreadInfo.h"
+#include "ColorBufferUploader.h"
+#include "glUtils.h"
 #ifdef WITH_GLES2
 #include "GL2Dispatch.h"
 #endif
 #include <stdio.h>
+#include <string.h>
+
+// the ids of the storage created, with the FrameBuffer lock held
+static unsigned int s_nextStorageId = 0;
 
 ColorBuffer *ColorBuffer::create(int p_width, int p_height,
                                  GLenum p_internalFormat)
@@ -52,20 +58,34 @@ ColorBuffer *ColorBuffer::create(int p_width, int p_height,
     }
 
     ColorBuffer *cb = new ColorBuffer();
+    cb->m_width = p_width;
+    cb->m_height = p_height;
+    cb->m_internalFormat = texInternalFormat;
 
+    //
+    // reuse the objects of a released color buffer if possible
+    //
+    ColorBufferStorage storage;
+    if (fb->getColorBufferPool()->take(p_width, p_height, texInternalFormat,
+                                       &storage)) {
+        cb->m_tex = storage.tex;
+        cb->m_blitTex = storage.blitTex;
+        cb->m_fbo = storage.fbo;
+        cb->m_eglImage = storage.eglImage;
+        cb->m_blitEGLImage = storage.blitEGLImage;
+        cb->m_storageId = storage.id;
+        cb->clear();
+        fb->unbind_locked();
+        return cb;
+    }
 
+    cb->m_storageId = ++s_nextStorageId;
     s_gl.glGenTextures(1, &cb->m_tex);
     s_gl.glBindTexture(GL_TEXTURE_2D, cb->m_tex);
-    int nComp = (texInternalFormat == GL_RGB ? 3 : 4);
-    char *zBuff = new char[nComp*p_width*p_height];
-    if (zBuff) {
-        memset(zBuff, 0, nComp*p_width*p_height);
-    }
     s_gl.glTexImage2D(GL_TEXTURE_2D, 0, texInternalFormat,
                       p_width, p_height, 0,
                       texInternalFormat,
-                      GL_UNSIGNED_BYTE, zBuff);
-    delete [] zBuff;
+                      GL_UNSIGNED_BYTE, NULL);
     s_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     s_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     s_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -87,9 +107,7 @@ ColorBuffer *ColorBuffer::create(int p_width, int p_height,
     s_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     s_gl.glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
 
-    cb->m_width = p_width;
-    cb->m_height = p_height;
-    cb->m_internalFormat = texInternalFormat;
+    cb->clear();
 
     if (fb->getCaps().has_eglimage_texture_2d) {
         cb->m_eglImage = s_egl.eglCreateImageKHR(fb->getDisplay(),
@@ -109,34 +127,64 @@ ColorBuffer *ColorBuffer::create(int p_width, int p_height,
     return cb;
 }
 
+//
+// clear - zero the texture, through the framebuffer object when possible
+// rather than uploading a buffer of zeros. Called with the FrameBuffer
+// context bound.
+//
+void ColorBuffer::clear()
+{
+    if (bind_fbo()) {
+        s_gl.glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        s_gl.glClear(GL_COLOR_BUFFER_BIT);
+        s_gl.glBindFramebufferOES(GL_FRAMEBUFFER_OES, 0);
+        return;
+    }
+
+    int nComp = (m_internalFormat == GL_RGB ? 3 : 4);
+    char *zBuff = new char[nComp*m_width*m_height];
+    memset(zBuff, 0, nComp*m_width*m_height);
+    s_gl.glBindTexture(GL_TEXTURE_2D, m_tex);
+    s_gl.glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    s_gl.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height,
+                         m_internalFormat, GL_UNSIGNED_BYTE, zBuff);
+    delete [] zBuff;
+}
+
 ColorBuffer::ColorBuffer() :
     m_tex(0),
     m_blitTex(0),
     m_eglImage(NULL),
     m_blitEGLImage(NULL),
+    m_width(0),
+    m_height(0),
     m_fbo(0),
-    m_internalFormat(0)
+    m_internalFormat(0),
+    m_storageId(0),
+    m_gpuWritable(false)
 {
 }
 
 ColorBuffer::~ColorBuffer()
 {
+    waitForUploads();
+
     FrameBuffer *fb = FrameBuffer::getFB();
     fb->bind_locked();
 
-    if (m_blitEGLImage) {
-        s_egl.eglDestroyImageKHR(fb->getDisplay(), m_blitEGLImage);
-    }
-    if (m_eglImage) {
-        s_egl.eglDestroyImageKHR(fb->getDisplay(), m_eglImage);
-    }
-
-    if (m_fbo) {
-        s_gl.glDeleteFramebuffersOES(1, &m_fbo);
-    }
-
-    GLuint tex[2] = {m_tex, m_blitTex};
-    s_gl.glDeleteTextures(2, tex);
+    // the pool destroys the objects it does not keep
+    ColorBufferStorage storage;
+    storage.tex = m_tex;
+    storage.blitTex = m_blitTex;
+    storage.fbo = m_fbo;
+    storage.eglImage = m_eglImage;
+    storage.blitEGLImage = m_blitEGLImage;
+    storage.width = m_width;
+    storage.height = m_height;
+    storage.internalFormat = m_internalFormat;
+    storage.id = m_storageId;
+    storage.guestBound = m_gpuWritable;
+    fb->getColorBufferPool()->put(storage);
 
     fb->unbind_locked();
 }
@@ -144,102 +192,120 @@ ColorBuffer::~ColorBuffer()
 void ColorBuffer::subUpdate(int x, int y, int width, int height, GLenum p_format, GLenum p_type, void *pixels)
 {
     FrameBuffer *fb = FrameBuffer::getFB();
+
+    //
+    // hand the pixels to the upload thread when there is one, the
+    // uploads it queued must be complete before using the texture here
+    //
+    ColorBufferUploader *uploader = fb->getUploader();
+    if (uploader && width > 0 && height > 0) {
+        size_t len = ((glUtilsPixelBitSize(p_format, p_type) * width) >> 3) * height;
+        if (uploader->queue(this, m_tex, x, y, width, height,
+                            p_format, p_type, pixels, len)) {
+            m_damage.add(x, y, width, height, m_width, m_height);
+            return;
+        }
+    }
+    waitForUploads();
+
     if (!fb->bind_locked()) return;
     s_gl.glBindTexture(GL_TEXTURE_2D, m_tex);
     s_gl.glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     s_gl.glTexSubImage2D(GL_TEXTURE_2D, 0, x, y,
                          width, height, p_format, p_type, pixels);
     fb->unbind_locked();
+    m_damage.add(x, y, width, height, m_width, m_height);
 }
 
 bool ColorBuffer::blitFromCurrentReadBuffer()
 {
     RenderThreadInfo *tInfo = RenderThreadInfo::get();
-    if (!tInfo->currContext.Ptr()) {
+    RenderContext *ctx = tInfo->currContext.Ptr();
+    if (!ctx) {
         // no Current context
         return false;
     }
 
+    waitForUploads();
+
     //
-    // Create a temporary texture inside the current context
-    // from the blit_texture EGLImage and copy the pixels
-    // from the current read buffer to that texture
+    // where the host can blit framebuffers, the current read buffer is
+    // copied upside down straight into the texture, by the current
+    // context through its EGLImage
     //
-    GLuint tmpTex;
-    GLint currTexBind;
-    if (tInfo->currContext->isGL2()) {
-        s_gl2.glGetIntegerv(GL_TEXTURE_BINDING_2D, &currTexBind);
-        s_gl2.glGenTextures(1,&tmpTex);
-        s_gl2.glBindTexture(GL_TEXTURE_2D, tmpTex);
-        s_gl2.glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, m_blitEGLImage);
-        s_gl2.glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0,
-                                  m_width, m_height);
+    if (ctx->blitToImage(m_eglImage, m_width, m_height)) {
+        m_damage.setFull(m_width, m_height);
+        return true;
     }
-    else {
-        s_gl.glGetIntegerv(GL_TEXTURE_BINDING_2D, &currTexBind);
-        s_gl.glGenTextures(1,&tmpTex);
-        s_gl.glBindTexture(GL_TEXTURE_2D, tmpTex);
-        s_gl.glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, m_blitEGLImage);
-        s_gl.glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0,
-                                 m_width, m_height);
+
+    //
+    // otherwise copy the pixels from the current read buffer into the
+    // blit texture, then bind the frame buffer context and draw it
+    // flipped into m_tex
+    //
+    if (!ctx->copyToImage(m_blitEGLImage, m_width, m_height)) {
+        return false;
     }
+    return drawBlitTexture();
+}
 
+//
+// blitFromBlitImage - draw what a window surface rendered through
+// getBlitEGLImage() into the color buffer. The surface's context must
+// have been flushed.
+//
+bool ColorBuffer::blitFromBlitImage()
+{
+    waitForUploads();
+    return drawBlitTexture();
+}
+
+//
+// drawBlitTexture - draw m_blitTex into m_tex flipped, since the color
+// buffers keep the top row first
+//
+bool ColorBuffer::drawBlitTexture()
+{
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (!fb->bind_locked()) {
+        return false;
+    }
 
     //
-    // Now bind the frame buffer context and blit from
-    // m_blitTex into m_tex
+    // bind FBO object which has this colorbuffer as render target
     //
-    FrameBuffer *fb = FrameBuffer::getFB();
-    if (fb->bind_locked()) {
+    if (bind_fbo()) {
 
         //
-        // bind FBO object which has this colorbuffer as render target
+        // save current viewport and match it to the current
+        // colorbuffer size
         //
-        if (bind_fbo()) {
+        GLint vport[4];
+        s_gl.glGetIntegerv(GL_VIEWPORT, vport);
+        s_gl.glViewport(0, 0, m_width, m_height);
 
-            //
-            // save current viewport and match it to the current
-            // colorbuffer size
-            //
-            GLint vport[4];
-            s_gl.glGetIntegerv(GL_VIEWPORT, vport);
-            s_gl.glViewport(0, 0, m_width, m_height);
-
-            // render m_blitTex
-            s_gl.glBindTexture(GL_TEXTURE_2D, m_blitTex);
-            s_gl.glEnable(GL_TEXTURE_2D);
-            s_gl.glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
-            drawTexQuad();  // this will render the texture flipped
-
-            // unbind the fbo
-            s_gl.glBindFramebufferOES(GL_FRAMEBUFFER_OES, 0);
-
-            // restrore previous viewport
-            s_gl.glViewport(vport[0], vport[1], vport[2], vport[3]);
-        }
+        // render m_blitTex
+        s_gl.glBindTexture(GL_TEXTURE_2D, m_blitTex);
+        s_gl.glEnable(GL_TEXTURE_2D);
+        s_gl.glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+        drawTexQuad();  // this will render the texture flipped
 
-        // unbind from the FrameBuffer context
-        fb->unbind_locked();
-    }
+        // unbind the fbo
+        s_gl.glBindFramebufferOES(GL_FRAMEBUFFER_OES, 0);
 
-    //
-    // delete the temporary texture and restore the texture binding
-    // inside the current context
-    //
-    if (tInfo->currContext->isGL2()) {
-        s_gl2.glDeleteTextures(1, &tmpTex);
-        s_gl2.glBindTexture(GL_TEXTURE_2D, currTexBind);
-    }
-    else {
-        s_gl.glDeleteTextures(1, &tmpTex);
-        s_gl.glBindTexture(GL_TEXTURE_2D, currTexBind);
+        // restrore previous viewport
+        s_gl.glViewport(vport[0], vport[1], vport[2], vport[3]);
     }
 
+    // unbind from the FrameBuffer context
+    fb->unbind_locked();
+    m_damage.setFull(m_width, m_height);
     return true;
 }
 
 bool ColorBuffer::bindToTexture()
 {
+    waitForUploads();
     if (m_eglImage) {
         RenderThreadInfo *tInfo = RenderThreadInfo::get();
         if (tInfo->currContext.Ptr()) {
@@ -253,6 +319,7 @@ bool ColorBuffer::bindToTexture()
 #else
             s_gl.glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, m_eglImage);
 #endif
+            m_gpuWritable = true;
             return true;
         }
     }
@@ -261,6 +328,7 @@ bool ColorBuffer::bindToTexture()
 
 bool ColorBuffer::bindToRenderbuffer()
 {
+    waitForUploads();
     if (m_eglImage) {
         RenderThreadInfo *tInfo = RenderThreadInfo::get();
         if (tInfo->currContext.Ptr()) {
@@ -274,6 +342,7 @@ bool ColorBuffer::bindToRenderbuffer()
 #else
             s_gl.glEGLImageTargetRenderbufferStorageOES(GL_RENDERBUFFER_OES, m_eglImage);
 #endif
+            m_gpuWritable = true;
             return true;
         }
     }
@@ -306,6 +375,7 @@ bool ColorBuffer::bind_fbo()
 
 bool ColorBuffer::post()
 {
+    waitForUploads();
     s_gl.glBindTexture(GL_TEXTURE_2D, m_tex);
     s_gl.glEnable(GL_TEXTURE_2D);
     s_gl.glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
@@ -314,6 +384,118 @@ bool ColorBuffer::post()
     return true;
 }
 
+//
+// compose - draw the layers bottom up through the fbo of this color
+// buffer. Its first row is the top of the display, as for the color
+// buffers the guest fills, so that post() shows it the same way.
+//
+bool ColorBuffer::compose(const rcComposeLayer *p_layers,
+                          ColorBuffer *const *p_sources, int p_numLayers)
+{
+    waitForUploads();
+    for (int i = 0; i < p_numLayers; i++) {
+        if (p_sources[i]) {
+            p_sources[i]->waitForUploads();
+        }
+    }
+
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (!fb->bind_locked()) {
+        return false;
+    }
+    if (!bind_fbo()) {
+        fb->unbind_locked();
+        return false;
+    }
+
+    GLint vport[4];
+    s_gl.glGetIntegerv(GL_VIEWPORT, vport);
+    s_gl.glViewport(0, 0, m_width, m_height);
+    s_gl.glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    s_gl.glClear(GL_COLOR_BUFFER_BIT);
+
+    s_gl.glEnable(GL_TEXTURE_2D);
+    s_gl.glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    s_gl.glClientActiveTexture(GL_TEXTURE0);
+    s_gl.glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    s_gl.glEnableClientState(GL_VERTEX_ARRAY);
+
+    for (int i = 0; i < p_numLayers; i++) {
+        const rcComposeLayer &l = p_layers[i];
+        ColorBuffer *src = p_sources[i];
+        if (!src || l.dstRight <= l.dstLeft || l.dstBottom <= l.dstTop ||
+            l.srcRight <= l.srcLeft || l.srcBottom <= l.srcTop) {
+            continue;
+        }
+
+        // corners in the order top left, bottom left, top right,
+        // bottom right of the destination
+        GLfloat x0 = 2.0f * l.dstLeft / m_width - 1.0f;
+        GLfloat x1 = 2.0f * l.dstRight / m_width - 1.0f;
+        GLfloat y0 = 2.0f * l.dstTop / m_height - 1.0f;
+        GLfloat y1 = 2.0f * l.dstBottom / m_height - 1.0f;
+        GLfloat verts[] = { x0, y0,
+                            x0, y1,
+                            x1, y0,
+                            x1, y1 };
+
+        GLfloat s0 = (GLfloat)l.srcLeft / src->m_width;
+        GLfloat s1 = (GLfloat)l.srcRight / src->m_width;
+        GLfloat t0 = (GLfloat)l.srcTop / src->m_height;
+        GLfloat t1 = (GLfloat)l.srcBottom / src->m_height;
+        if (l.transform & COMPOSE_TRANSFORM_FLIP_H) {
+            GLfloat s = s0; s0 = s1; s1 = s;
+        }
+        if (l.transform & COMPOSE_TRANSFORM_FLIP_V) {
+            GLfloat t = t0; t0 = t1; t1 = t;
+        }
+        GLfloat tcoords[8];
+        if (l.transform & COMPOSE_TRANSFORM_ROT_90) {
+            // each corner shows the source corner before it clockwise
+            GLfloat rot[] = { s0, t1,
+                              s1, t1,
+                              s0, t0,
+                              s1, t0 };
+            memcpy(tcoords, rot, sizeof(tcoords));
+        } else {
+            GLfloat id[] = { s0, t0,
+                             s0, t1,
+                             s1, t0,
+                             s1, t1 };
+            memcpy(tcoords, id, sizeof(tcoords));
+        }
+
+        GLfloat alpha = l.alpha < 0.0f ? 0.0f : (l.alpha > 1.0f ? 1.0f : l.alpha);
+        if (l.blendMode == COMPOSE_BLEND_COVERAGE) {
+            s_gl.glEnable(GL_BLEND);
+            s_gl.glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            s_gl.glColor4f(1.0f, 1.0f, 1.0f, alpha);
+        } else if (l.blendMode == COMPOSE_BLEND_PREMULTIPLIED) {
+            s_gl.glEnable(GL_BLEND);
+            s_gl.glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            s_gl.glColor4f(alpha, alpha, alpha, alpha);
+        } else {
+            s_gl.glDisable(GL_BLEND);
+            s_gl.glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+        }
+
+        s_gl.glBindTexture(GL_TEXTURE_2D, src->m_tex);
+        s_gl.glTexCoordPointer(2, GL_FLOAT, 0, tcoords);
+        s_gl.glVertexPointer(2, GL_FLOAT, 0, verts);
+        s_gl.glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+
+    s_gl.glDisable(GL_BLEND);
+    s_gl.glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    s_gl.glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    s_gl.glBindFramebufferOES(GL_FRAMEBUFFER_OES, 0);
+    s_gl.glViewport(vport[0], vport[1], vport[2], vport[3]);
+
+    fb->unbind_locked();
+    m_damage.setFull(m_width, m_height);
+    return true;
+}
+
 void ColorBuffer::drawTexQuad()
 {
     GLfloat verts[] = { -1.0f, -1.0f, 0.0f,
@@ -337,6 +519,7 @@ void ColorBuffer::drawTexQuad()
 
 void ColorBuffer::readback(unsigned char* img)
 {
+    waitForUploads();
     FrameBuffer *fb = FrameBuffer::getFB();
     if (fb->bind_locked()) {
         if (bind_fbo()) {
@@ -346,3 +529,97 @@ void ColorBuffer::readback(unsigned char* img)
         fb->unbind_locked();
     }
 }
+
+//
+// readPixels - read a part of the color buffer straight into 'pixels',
+// with tightly packed rows. The format and type are converted by GL.
+//
+bool ColorBuffer::readPixels(int x, int y, int width, int height,
+                             GLenum p_format, GLenum p_type, void *pixels)
+{
+    waitForUploads();
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (!fb->bind_locked()) {
+        return false;
+    }
+
+    bool ret = false;
+    if (bind_fbo()) {
+        GLint packAlignment;
+        s_gl.glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+        s_gl.glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        s_gl.glGetError();  // forget errors of earlier calls
+        s_gl.glReadPixels(x, y, width, height, p_format, p_type, pixels);
+        s_gl.glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+        ret = (s_gl.glGetError() == GL_NO_ERROR);
+    }
+
+    fb->unbind_locked();
+    return ret;
+}
+
+void ColorBuffer::readbackRegion(unsigned char* img, int imgWidth,
+                                 const DamageRegion &region, unsigned char* tmp)
+{
+    if (region.isEmpty()) {
+        return;
+    }
+    waitForUploads();
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (fb->bind_locked()) {
+        if (bind_fbo()) {
+            region.readPixels(img, imgWidth, tmp);
+        }
+        fb->unbind_locked();
+    }
+}
+
+//
+// getDamage - the updates through rcUpdateColorBuffer are tracked to the
+// rectangle. Rendering is only seen when it is blit from a window surface,
+// and a color buffer the guest can render to through a texture or a
+// renderbuffer is always reported whole.
+//
+void ColorBuffer::getDamage(DamageRegion *p_damage) const
+{
+    if (m_gpuWritable) {
+        p_damage->setFull(m_width, m_height);
+    } else {
+        *p_damage = m_damage;
+    }
+}
+
+//
+// copyToTexture - copy the bottom left corner of the color buffer into
+// a texture of the FrameBuffer context, then flush so that the copy can
+// be used by other contexts sharing with it.
+//
+bool ColorBuffer::copyToTexture(GLuint p_tex, int p_width, int p_height)
+{
+    waitForUploads();
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (!fb->bind_locked()) {
+        return false;
+    }
+
+    bool ret = false;
+    if (bind_fbo()) {
+        s_gl.glBindTexture(GL_TEXTURE_2D, p_tex);
+        s_gl.glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0,
+                                 p_width, p_height);
+        s_gl.glBindFramebufferOES(GL_FRAMEBUFFER_OES, 0);
+        s_gl.glFlush();
+        ret = true;
+    }
+
+    fb->unbind_locked();
+    return ret;
+}
+
+void ColorBuffer::waitForUploads()
+{
+    ColorBufferUploader *uploader = FrameBuffer::getFB()->getUploader();
+    if (uploader) {
+        uploader->waitFor(this);
+    }
+}
@@ -20,6 +20,9 @@
 #include <EGL/eglext.h>
 #include <GLES/gl.h>
 #include <SmartPtr.h>
+#include "DamageRegion.h"
+#include "ColorBufferPool.h"
+#include "renderControl_types.h"
 
 class ColorBuffer
 {
@@ -31,17 +34,39 @@ public:
     GLuint getGLTextureName() const { return m_tex; }
     GLuint getWidth() const { return m_width; }
     GLuint getHeight() const { return m_height; }
+    GLenum getInternalFormat() const { return m_internalFormat; }
+    EGLImageKHR getBlitEGLImage() const { return m_blitEGLImage; }
 
     void subUpdate(int x, int y, int width, int height, GLenum p_format, GLenum p_type, void *pixels);
     bool post();
     bool bindToTexture();
     bool bindToRenderbuffer();
     bool blitFromCurrentReadBuffer();
+    bool blitFromBlitImage();
     void readback(unsigned char* img);
+    bool readPixels(int x, int y, int width, int height,
+                    GLenum p_format, GLenum p_type, void *pixels);
+    bool copyToTexture(GLuint p_tex, int p_width, int p_height);
+
+    // draws the layers of rcCompose into this color buffer, a NULL
+    // source skips its layer. Called with the FrameBuffer lock held.
+    bool compose(const rcComposeLayer *p_layers, ColorBuffer *const *p_sources,
+                 int p_numLayers);
+
+    // the parts which changed since the buffer was last read back for a
+    // post, forgotten by clearDamage() once it is. Called with the
+    // FrameBuffer lock held, like the updates.
+    void getDamage(DamageRegion *p_damage) const;
+    void clearDamage() { m_damage.clear(); }
+    void readbackRegion(unsigned char* img, int imgWidth,
+                        const DamageRegion &region, unsigned char* tmp);
 
 private:
     ColorBuffer();
     void drawTexQuad();
+    void clear();
+    void waitForUploads();
+    bool drawBlitTexture();
     bool bind_fbo();  // binds a fbo which have this texture as render target
 
 private:
@@ -53,6 +78,10 @@ private:
     GLuint m_height;
     GLuint m_fbo;
     GLenum m_internalFormat;
+    unsigned int m_storageId;
+    DamageRegion m_damage;
+    volatile bool m_gpuWritable;  // bound to a guest texture or renderbuffer,
+                                  // set without the FrameBuffer lock
 };
 
 typedef SmartPtr<ColorBuffer> ColorBufferPtr;
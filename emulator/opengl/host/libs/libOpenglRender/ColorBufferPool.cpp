@@ -0,0 +1,111 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "ColorBufferPool.h"
+#include "FrameBuffer.h"
+#include "EGLDispatch.h"
+#include "GLDispatch.h"
+#include "ErrorLog.h"
+
+size_t ColorBufferStorage::bytes() const
+{
+    // the texture and the blit texture
+    size_t nComp = (internalFormat == GL_RGB ? 3 : 4);
+    return 2 * nComp * width * height;
+}
+
+void ColorBufferStorage::destroy() const
+{
+    FrameBuffer *fb = FrameBuffer::getFB();
+
+    if (blitEGLImage) {
+        s_egl.eglDestroyImageKHR(fb->getDisplay(), blitEGLImage);
+    }
+    if (eglImage) {
+        s_egl.eglDestroyImageKHR(fb->getDisplay(), eglImage);
+    }
+
+    if (fbo) {
+        s_gl.glDeleteFramebuffersOES(1, &fbo);
+    }
+
+    GLuint texs[2] = {tex, blitTex};
+    s_gl.glDeleteTextures(2, texs);
+}
+
+ColorBufferPool::ColorBufferPool(size_t budget) :
+    m_budget(budget),
+    m_bytes(0),
+    m_hits(0),
+    m_misses(0)
+{
+}
+
+ColorBufferPool::~ColorBufferPool()
+{
+    // the FrameBuffer context is gone by now, the storage went with it
+}
+
+bool ColorBufferPool::take(GLuint width, GLuint height, GLenum internalFormat,
+                           ColorBufferStorage *p_storage)
+{
+    android::Mutex::Autolock lock(m_lock);
+
+    for (StorageList::iterator s = m_storage.begin(); s != m_storage.end(); s++) {
+        if (s->width == width && s->height == height &&
+            s->internalFormat == internalFormat) {
+            *p_storage = *s;
+            m_bytes -= s->bytes();
+            m_storage.erase(s);
+            m_hits++;
+            return true;
+        }
+    }
+
+    m_misses++;
+    return false;
+}
+
+void ColorBufferPool::put(const ColorBufferStorage &storage)
+{
+    android::Mutex::Autolock lock(m_lock);
+
+    size_t bytes = storage.bytes();
+    if (bytes > m_budget || storage.guestBound) {
+        storage.destroy();
+        return;
+    }
+
+    trim_locked(m_budget - bytes);
+    m_storage.push_front(storage);
+    m_bytes += bytes;
+}
+
+void ColorBufferPool::clear()
+{
+    android::Mutex::Autolock lock(m_lock);
+    DBG("ColorBufferPool: %u hits, %u misses\n", m_hits, m_misses);
+    trim_locked(0);
+}
+
+void ColorBufferPool::trim_locked(size_t budget)
+{
+    while (m_bytes > budget && !m_storage.empty()) {
+        const ColorBufferStorage &s = m_storage.back();
+        m_bytes -= s.bytes();
+        s.destroy();
+        m_storage.pop_back();
+    }
+}
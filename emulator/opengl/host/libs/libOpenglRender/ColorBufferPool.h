@@ -0,0 +1,95 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _LIBRENDER_COLORBUFFER_POOL_H
+#define _LIBRENDER_COLORBUFFER_POOL_H
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES/gl.h>
+#include <utils/threads.h>
+#include <list>
+
+// bytes of GL objects kept for reuse by default
+#define COLOR_BUFFER_POOL_BUDGET (32 * 1024 * 1024)
+
+//
+// The GL objects behind a ColorBuffer
+//
+struct ColorBufferStorage
+{
+    GLuint tex;
+    GLuint blitTex;
+    GLuint fbo;
+    EGLImageKHR eglImage;
+    EGLImageKHR blitEGLImage;
+    GLuint width;
+    GLuint height;
+    GLenum internalFormat;  // GL_RGB or GL_RGBA
+    unsigned int id;        // never reused, names the storage in caches
+    bool guestBound;        // eglImage was bound to a guest texture or
+                            // renderbuffer, which may still target it
+
+    size_t bytes() const;
+    // must be called with the FrameBuffer context bound
+    void destroy() const;
+};
+
+//
+// ColorBufferPool - keeps the GL objects of released color buffers to
+// create the next ones of the same size and format without allocating
+// anything. Past the byte budget, the least recently released storage
+// is destroyed.
+//
+// Storage whose EGLImage was bound to a guest texture or renderbuffer
+// is never kept: they may still target it, and would show the contents
+// of the next color buffer, maybe of another guest process.
+//
+class ColorBufferPool
+{
+public:
+    ColorBufferPool(size_t budget = COLOR_BUFFER_POOL_BUDGET);
+    ~ColorBufferPool();
+
+    // The calls below must be made with the FrameBuffer context bound.
+
+    // get a storage of that size and format, false if there is none
+    bool take(GLuint width, GLuint height, GLenum internalFormat,
+              ColorBufferStorage *p_storage);
+
+    // keep a storage, or destroy it if it is larger than the budget or
+    // was bound by the guest
+    void put(const ColorBufferStorage &storage);
+
+    // destroy all the storage kept
+    void clear();
+
+    size_t bytes() const { return m_bytes; }
+
+private:
+    void trim_locked(size_t budget);
+
+private:
+    typedef std::list<ColorBufferStorage> StorageList;
+
+    android::Mutex m_lock;
+    StorageList m_storage;   // most recently released first
+    size_t m_budget;
+    size_t m_bytes;
+    unsigned int m_hits;
+    unsigned int m_misses;
+};
+
+#endif
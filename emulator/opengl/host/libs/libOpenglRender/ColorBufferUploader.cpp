@@ -0,0 +1,198 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "ColorBufferUploader.h"
+#include "EGLDispatch.h"
+#include "GLDispatch.h"
+#include "ErrorLog.h"
+#include <stdlib.h>
+#include <string.h>
+
+ColorBufferUploader::ColorBufferUploader() :
+    m_display(EGL_NO_DISPLAY),
+    m_context(EGL_NO_CONTEXT),
+    m_surface(EGL_NO_SURFACE),
+    m_queuedBytes(0),
+    m_exit(false),
+    m_started(false)
+{
+}
+
+ColorBufferUploader::~ColorBufferUploader()
+{
+    if (m_started) {
+        {
+            android::Mutex::Autolock lock(m_lock);
+            m_exit = true;
+            m_queueCond.signal();
+        }
+        int exitStatus;
+        wait(&exitStatus);
+    }
+
+    if (m_surface != EGL_NO_SURFACE) {
+        s_egl.eglDestroySurface(m_display, m_surface);
+    }
+    if (m_context != EGL_NO_CONTEXT) {
+        s_egl.eglDestroyContext(m_display, m_context);
+    }
+}
+
+ColorBufferUploader *ColorBufferUploader::create(EGLDisplay p_display,
+                                                 EGLConfig p_config,
+                                                 EGLContext p_shareContext)
+{
+    ColorBufferUploader *up = new ColorBufferUploader();
+    up->m_display = p_display;
+
+    GLint glContextAttribs[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 1,
+        EGL_NONE
+    };
+    up->m_context = s_egl.eglCreateContext(p_display, p_config,
+                                           p_shareContext, glContextAttribs);
+    if (up->m_context == EGL_NO_CONTEXT) {
+        ERR("ColorBufferUploader: failed to create context 0x%x\n", s_egl.eglGetError());
+        delete up;
+        return NULL;
+    }
+
+    EGLint pbufAttribs[] = {
+        EGL_WIDTH, 1,
+        EGL_HEIGHT, 1,
+        EGL_NONE
+    };
+    up->m_surface = s_egl.eglCreatePbufferSurface(p_display, p_config,
+                                                  pbufAttribs);
+    if (up->m_surface == EGL_NO_SURFACE) {
+        ERR("ColorBufferUploader: failed to create pbuffer 0x%x\n", s_egl.eglGetError());
+        delete up;
+        return NULL;
+    }
+
+    if (!up->start()) {
+        ERR("ColorBufferUploader: failed to start thread\n");
+        delete up;
+        return NULL;
+    }
+    up->m_started = true;
+
+    return up;
+}
+
+bool ColorBufferUploader::queue(ColorBuffer *p_cb, GLuint p_tex,
+                                int x, int y, int width, int height,
+                                GLenum format, GLenum type,
+                                const void *pixels, size_t len)
+{
+    Upload u;
+    u.cb = p_cb;
+    u.tex = p_tex;
+    u.x = x;
+    u.y = y;
+    u.width = width;
+    u.height = height;
+    u.format = format;
+    u.type = type;
+    u.len = len;
+    u.pixels = malloc(len ? len : 1);
+    if (!u.pixels) {
+        return false;
+    }
+    memcpy(u.pixels, pixels, len);
+
+    android::Mutex::Autolock lock(m_lock);
+    if (m_exit) {
+        free(u.pixels);
+        return false;
+    }
+
+    // a large update waits for the queue to empty rather than failing
+    while (m_queuedBytes > 0 && m_queuedBytes + len > UPLOAD_QUEUE_MAX_BYTES) {
+        m_doneCond.wait(m_lock);
+    }
+
+    m_queue.push_back(u);
+    m_pending[p_cb]++;
+    m_queuedBytes += len;
+    m_queueCond.signal();
+    return true;
+}
+
+void ColorBufferUploader::waitFor(ColorBuffer *p_cb)
+{
+    android::Mutex::Autolock lock(m_lock);
+    while (m_pending.find(p_cb) != m_pending.end()) {
+        m_doneCond.wait(m_lock);
+    }
+}
+
+int ColorBufferUploader::Main()
+{
+    bool bound = s_egl.eglMakeCurrent(m_display, m_surface, m_surface,
+                                      m_context);
+    if (!bound) {
+        ERR("ColorBufferUploader: eglMakeCurrent failed 0x%x\n", s_egl.eglGetError());
+    } else {
+        s_gl.glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    }
+
+    UploadVec batch;
+    while (1) {
+        {
+            android::Mutex::Autolock lock(m_lock);
+            while (m_queue.empty() && !m_exit) {
+                m_queueCond.wait(m_lock);
+            }
+            if (m_queue.empty()) {
+                break;
+            }
+            batch.swap(m_queue);
+        }
+
+        //
+        // without a context, the uploads are dropped rather than leaving
+        // their color buffers waiting forever
+        //
+        if (bound) {
+            for (size_t i = 0; i < batch.size(); i++) {
+                const Upload &u = batch[i];
+                s_gl.glBindTexture(GL_TEXTURE_2D, u.tex);
+                s_gl.glTexSubImage2D(GL_TEXTURE_2D, 0, u.x, u.y,
+                                     u.width, u.height, u.format, u.type,
+                                     u.pixels);
+            }
+            s_gl.glFinish();
+        }
+
+        android::Mutex::Autolock lock(m_lock);
+        for (size_t i = 0; i < batch.size(); i++) {
+            PendingMap::iterator p = m_pending.find(batch[i].cb);
+            if (--p->second == 0) {
+                m_pending.erase(p);
+            }
+            m_queuedBytes -= batch[i].len;
+            free(batch[i].pixels);
+        }
+        batch.clear();
+        m_doneCond.broadcast();
+    }
+
+    if (bound) {
+        s_egl.eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                             EGL_NO_CONTEXT);
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _LIBRENDER_COLORBUFFER_UPLOADER_H
+#define _LIBRENDER_COLORBUFFER_UPLOADER_H
+
+#include "osThread.h"
+#include <utils/threads.h>
+#include <EGL/egl.h>
+#include <GLES/gl.h>
+#include <map>
+#include <vector>
+
+class ColorBuffer;
+
+// bytes of pixels which can wait for their upload before queue() blocks
+#define UPLOAD_QUEUE_MAX_BYTES (32 * 1024 * 1024)
+
+//
+// ColorBufferUploader - uploads the pixels of rcUpdateColorBuffer from a
+// thread of its own, through a context sharing with the FrameBuffer's,
+// so that the render threads do not switch to the FrameBuffer context
+// for each update.
+//
+// The translator has no pixel unpack buffers or fences: the pixels are
+// copied when queued, everything queued is uploaded in one batch, and
+// the batch is complete for the other contexts once glFinish returns.
+// Anything using the color buffer from another context must first call
+// waitFor() for it.
+//
+class ColorBufferUploader : public osUtils::Thread
+{
+public:
+    static ColorBufferUploader *create(EGLDisplay p_display,
+                                       EGLConfig p_config,
+                                       EGLContext p_shareContext);
+
+    // uploads what is still queued, then stops the thread
+    ~ColorBufferUploader();
+
+    // copy the pixels and queue their upload to the texture of the
+    // color buffer, false if they could not be queued
+    bool queue(ColorBuffer *p_cb, GLuint p_tex,
+               int x, int y, int width, int height,
+               GLenum format, GLenum type, const void *pixels, size_t len);
+
+    // return once the uploads queued for the color buffer are complete
+    void waitFor(ColorBuffer *p_cb);
+
+private:
+    ColorBufferUploader();
+    virtual int Main();
+
+    struct Upload {
+        ColorBuffer *cb;
+        GLuint tex;
+        int x;
+        int y;
+        int width;
+        int height;
+        GLenum format;
+        GLenum type;
+        void *pixels;
+        size_t len;
+    };
+    typedef std::vector<Upload> UploadVec;
+    typedef std::map<ColorBuffer *, unsigned int> PendingMap;
+
+private:
+    EGLDisplay m_display;
+    EGLContext m_context;
+    EGLSurface m_surface;
+
+    android::Mutex m_lock;
+    android::Condition m_queueCond;  // signaled when uploads are queued
+    android::Condition m_doneCond;   // signaled when a batch is complete
+    UploadVec m_queue;
+    PendingMap m_pending;            // uploads queued or in progress
+    size_t m_queuedBytes;
+    bool m_exit;
+    bool m_started;
+};
+
+#endif
@@ -0,0 +1,155 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "DamageRegion.h"
+#include "GLDispatch.h"
+#include <string.h>
+
+static inline bool contains(const RenderRect &a, const RenderRect &b)
+{
+    return b.x >= a.x && b.y >= a.y &&
+           b.x + b.width <= a.x + a.width &&
+           b.y + b.height <= a.y + a.height;
+}
+
+static RenderRect bounds(const RenderRect &a, const RenderRect &b)
+{
+    int x0 = a.x < b.x ? a.x : b.x;
+    int y0 = a.y < b.y ? a.y : b.y;
+    int x1 = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+    int y1 = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+    RenderRect r = { x0, y0, x1 - x0, y1 - y0 };
+    return r;
+}
+
+static inline long long rectArea(const RenderRect &r)
+{
+    return (long long)r.width * r.height;
+}
+
+void DamageRegion::add(int x, int y, int width, int height,
+                       int clipWidth, int clipHeight)
+{
+    if (x < 0) {
+        width += x;
+        x = 0;
+    }
+    if (y < 0) {
+        height += y;
+        y = 0;
+    }
+    if (x + width > clipWidth) {
+        width = clipWidth - x;
+    }
+    if (y + height > clipHeight) {
+        height = clipHeight - y;
+    }
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    RenderRect r = { x, y, width, height };
+    addRect(r);
+}
+
+void DamageRegion::add(const DamageRegion &other)
+{
+    for (int i = 0; i < other.m_numRects; i++) {
+        addRect(other.m_rects[i]);
+    }
+}
+
+void DamageRegion::setFull(int width, int height)
+{
+    m_numRects = 0;
+    if (width > 0 && height > 0) {
+        RenderRect r = { 0, 0, width, height };
+        m_rects[m_numRects++] = r;
+    }
+}
+
+long long DamageRegion::area() const
+{
+    long long a = 0;
+    for (int i = 0; i < m_numRects; i++) {
+        a += rectArea(m_rects[i]);
+    }
+    return a;
+}
+
+void DamageRegion::addRect(const RenderRect &rect)
+{
+    RenderRect r = rect;
+
+    //
+    // drop the rectangles the new one covers, and the new one if it is
+    // already covered. A merge may cover more rectangles, so start over
+    // until nothing changes.
+    //
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        int n = 0;
+        for (int i = 0; i < m_numRects; i++) {
+            if (contains(m_rects[i], r)) {
+                return;
+            }
+            if (!contains(r, m_rects[i])) {
+                m_rects[n++] = m_rects[i];
+            }
+        }
+        m_numRects = n;
+
+        if (m_numRects < DAMAGE_REGION_MAX_RECTS) {
+            m_rects[m_numRects++] = r;
+            return;
+        }
+
+        // full, grow the rectangle which needs the least extra area
+        int best = 0;
+        long long bestGrowth = -1;
+        for (int i = 0; i < m_numRects; i++) {
+            RenderRect b = bounds(m_rects[i], r);
+            long long growth = rectArea(b) - rectArea(m_rects[i]);
+            if (bestGrowth < 0 || growth < bestGrowth) {
+                best = i;
+                bestGrowth = growth;
+            }
+        }
+        r = bounds(m_rects[best], r);
+        m_rects[best] = m_rects[--m_numRects];
+        merged = true;
+    }
+}
+
+void DamageRegion::readPixels(unsigned char *img, int imgWidth,
+                              unsigned char *tmp) const
+{
+    for (int i = 0; i < m_numRects; i++) {
+        const RenderRect &r = m_rects[i];
+        unsigned char *dst = img + ((size_t)r.y * imgWidth + r.x) * 4;
+        if (r.width == imgWidth) {
+            // whole rows, read in place
+            s_gl.glReadPixels(r.x, r.y, r.width, r.height,
+                              GL_RGBA, GL_UNSIGNED_BYTE, dst);
+            continue;
+        }
+        s_gl.glReadPixels(r.x, r.y, r.width, r.height,
+                          GL_RGBA, GL_UNSIGNED_BYTE, tmp);
+        for (int row = 0; row < r.height; row++) {
+            memcpy(dst + (size_t)row * imgWidth * 4,
+                   tmp + (size_t)row * r.width * 4, r.width * 4);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _LIBRENDER_DAMAGE_REGION_H
+#define _LIBRENDER_DAMAGE_REGION_H
+
+#include "libOpenglRender/render_api.h"
+
+// rectangles kept before they are merged together
+#define DAMAGE_REGION_MAX_RECTS 8
+
+//
+// DamageRegion - the parts of an image which changed, as a short list
+// of rectangles. Past DAMAGE_REGION_MAX_RECTS, a new rectangle is merged
+// with the one whose bounding box grows the least, so the region may
+// cover more than what actually changed but never less.
+//
+class DamageRegion
+{
+public:
+    DamageRegion() : m_numRects(0) {}
+
+    void clear() { m_numRects = 0; }
+    bool isEmpty() const { return m_numRects == 0; }
+    int numRects() const { return m_numRects; }
+    const RenderRect *rects() const { return m_rects; }
+
+    // add a rectangle, clipped to a width x height image
+    void add(int x, int y, int width, int height,
+             int clipWidth, int clipHeight);
+    void add(const DamageRegion &other);
+    void setFull(int width, int height);
+
+    // number of pixels covered by the rectangles, counting overlaps
+    long long area() const;
+
+    // read the rectangles from the current read framebuffer into 'img',
+    // an RGBA image 'imgWidth' pixels wide. 'tmp' must hold the largest
+    // rectangle which is not as wide as the image.
+    void readPixels(unsigned char *img, int imgWidth, unsigned char *tmp) const;
+
+private:
+    void addRect(const RenderRect &r);
+
+private:
+    RenderRect m_rects[DAMAGE_REGION_MAX_RECTS];
+    int m_numRects;
+};
+
+#endif
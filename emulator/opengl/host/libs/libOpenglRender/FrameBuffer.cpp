@@ -21,11 +21,12 @@
 #include "GLDispatch.h"
 #include "GL2Dispatch.h"
 #include "ThreadInfo.h"
+#include "RenderMetrics.h"
 #include "TimeUtils.h"
 #include <stdio.h>
+#include <vector>
 
 FrameBuffer *FrameBuffer::s_theFrameBuffer = NULL;
-HandleType FrameBuffer::s_nextHandle = 0;
 
 #ifdef WITH_GLES2
 static char* getGLES2ExtensionString(EGLDisplay p_dpy)
@@ -89,10 +90,22 @@ static char* getGLES2ExtensionString(EGLDisplay p_dpy)
 
 void FrameBuffer::finalize(){
     if(s_theFrameBuffer){
+        delete s_theFrameBuffer->m_presenter;
+        s_theFrameBuffer->m_presenter = NULL;
         s_theFrameBuffer->removeSubWindow();
+        delete s_theFrameBuffer->m_readback;
+        s_theFrameBuffer->m_readback = NULL;
+        delete s_theFrameBuffer->m_export;
+        s_theFrameBuffer->m_export = NULL;
         s_theFrameBuffer->m_colorbuffers.clear();
         s_theFrameBuffer->m_windows.clear();
         s_theFrameBuffer->m_contexts.clear();
+        delete s_theFrameBuffer->m_uploader;
+        s_theFrameBuffer->m_uploader = NULL;
+        if (s_theFrameBuffer->bind_locked()) {
+            s_theFrameBuffer->m_colorBufferPool.clear();
+            s_theFrameBuffer->unbind_locked();
+        }
         s_egl.eglMakeCurrent(s_theFrameBuffer->m_eglDisplay, NULL, NULL, NULL);
         s_egl.eglDestroyContext(s_theFrameBuffer->m_eglDisplay,s_theFrameBuffer->m_eglContext);
         s_egl.eglDestroyContext(s_theFrameBuffer->m_eglDisplay,s_theFrameBuffer->m_pbufContext);
@@ -101,7 +114,7 @@ void FrameBuffer::finalize(){
     }
 }
 
-bool FrameBuffer::initialize(int width, int height)
+bool FrameBuffer::initialize(int width, int height, bool headless)
 {
     if (s_theFrameBuffer != NULL) {
         return true;
@@ -115,6 +128,7 @@ bool FrameBuffer::initialize(int width, int height)
         ERR("Failed to create fb\n");
         return false;
     }
+    fb->m_headless = headless;
 
 #ifdef WITH_GLES2
     //
@@ -352,6 +366,45 @@ bool FrameBuffer::initialize(int width, int height)
     // release the FB context
     fb->unbind_locked();
 
+    //
+    // upload the color buffer updates from a thread of their own, unless
+    // RENDERER_SYNC_UPLOAD is set
+    //
+    if (!getenv("RENDERER_SYNC_UPLOAD")) {
+        fb->m_uploader = ColorBufferUploader::create(fb->m_eglDisplay,
+                                                     fb->m_eglConfig,
+                                                     fb->m_eglContext);
+    }
+
+    //
+    // show the posted frames from a thread of their own, unless
+    // RENDERER_SYNC_POST is set. RENDERER_PRESENT_PACING is either
+    // "unthrottled" or a number of frames per second, the default is to
+    // follow the guest's swap interval.
+    //
+    if (!getenv("RENDERER_SYNC_POST")) {
+        PresentPacing pacing = PRESENT_SWAP_INTERVAL;
+        int rate = 0;
+        const char *pacingEnv = getenv("RENDERER_PRESENT_PACING");
+        if (pacingEnv && !strcmp(pacingEnv, "unthrottled")) {
+            pacing = PRESENT_UNTHROTTLED;
+        }
+        else if (pacingEnv && atoi(pacingEnv) > 0) {
+            pacing = PRESENT_FIXED_RATE;
+            rate = atoi(pacingEnv);
+        }
+        fb->m_presenter = Presenter::create(fb, pacing, rate);
+    }
+
+    //
+    // export the posted frames to shared memory when
+    // RENDERER_FRAME_EXPORT names the object to write them to
+    //
+    const char *exportName = getenv("RENDERER_FRAME_EXPORT");
+    if (exportName) {
+        fb->setFrameExport(exportName);
+    }
+
     //
     // Keep the singleton framebuffer pointer
     //
@@ -363,6 +416,8 @@ FrameBuffer::FrameBuffer(int p_width, int p_height) :
     m_width(p_width),
     m_height(p_height),
     m_eglDisplay(EGL_NO_DISPLAY),
+    m_uploader(NULL),
+    m_presenter(NULL),
     m_eglSurface(EGL_NO_SURFACE),
     m_eglContext(EGL_NO_CONTEXT),
     m_pbufContext(EGL_NO_CONTEXT),
@@ -372,39 +427,212 @@ FrameBuffer::FrameBuffer(int p_width, int p_height) :
     m_subWin((EGLNativeWindowType)0),
     m_subWinDisplay(NULL),
     m_lastPostedColorBuffer(0),
+    m_composeColorBuffer(0),
     m_zRot(0.0f),
     m_eglContextInitialized(false),
     m_statsNumFrames(0),
     m_statsStartTime(0LL),
     m_onPost(NULL),
+    m_onPostRegion(NULL),
     m_onPostContext(NULL),
     m_fbImage(NULL),
+    m_fbRegionTmp(NULL),
+    m_numPostDamage(0),
+    m_readback(NULL),
+    m_headless(false),
+    m_postRate(POST_RATE_UNLIMITED),
+    m_postRequested(false),
+    m_lastDeliveryUS(0),
+    m_export(NULL),
     m_glVendor(NULL),
     m_glRenderer(NULL),
     m_glVersion(NULL)
 {
     m_fpsStats = getenv("SHOW_FPS_STATS") != NULL;
+    m_asyncReadback = getenv("RENDERER_ASYNC_READBACK") != NULL;
+    m_fboSurfaces = getenv("RENDERER_FBO_SURFACES") != NULL;
 }
 
 FrameBuffer::~FrameBuffer()
 {
     free(m_fbImage);
+    free(m_fbRegionTmp);
 }
 
 void FrameBuffer::setPostCallback(OnPostFn onPost, void* onPostContext)
 {
     android::Mutex::Autolock mutex(m_lock);
+    setPostCallbacks_locked(onPost, NULL, onPostContext);
+}
+
+void FrameBuffer::setPostRegionCallback(OnPostRegionFn onPost, void* onPostContext)
+{
+    android::Mutex::Autolock mutex(m_lock);
+    setPostCallbacks_locked(NULL, onPost, onPostContext);
+}
+
+void FrameBuffer::setPostRate(int framesPerSecond)
+{
+    android::Mutex::Autolock mutex(m_lock);
+    m_postRate = framesPerSecond;
+}
+
+//
+// setFrameExport - start writing each posted frame into the shared
+// memory object 'name', or stop when it is NULL
+//
+bool FrameBuffer::setFrameExport(const char *name)
+{
+    android::Mutex::Autolock mutex(m_lock);
+    delete m_export;
+    m_export = NULL;
+    if (!name) {
+        return true;
+    }
+    m_export = FrameExport::create(name, m_width, m_height);
+    return m_export != NULL;
+}
+
+//
+// requestPost - have the latest frame delivered, through the presenter
+// like any post. If there is none yet, the next one is.
+//
+void FrameBuffer::requestPost()
+{
+    HandleType last;
+    {
+        android::Mutex::Autolock mutex(m_lock);
+        m_postRequested = true;
+        last = m_lastPostedColorBuffer;
+    }
+    if (last) {
+        queuePost(last);
+    }
+}
+
+//
+// postDue_locked - whether the frame being posted goes to the callback
+//
+bool FrameBuffer::postDue_locked()
+{
+    long long now = GetCurrentTimeUS();
+    if (m_postRequested) {
+        m_postRequested = false;
+    }
+    else if (m_postRate == POST_RATE_ON_DEMAND) {
+        return false;
+    }
+    else if (m_postRate > 0 &&
+             now - m_lastDeliveryUS < 1000000LL / m_postRate) {
+        return false;
+    }
+    m_lastDeliveryUS = now;
+    return true;
+}
+
+void FrameBuffer::setPostCallbacks_locked(OnPostFn onPost,
+                                          OnPostRegionFn onPostRegion,
+                                          void* onPostContext)
+{
+    // no frame is delivered to the previous callback once this returns
+    delete m_readback;
+    m_readback = NULL;
+
     m_onPost = onPost;
+    m_onPostRegion = onPostRegion;
     m_onPostContext = onPostContext;
-    if (m_onPost && !m_fbImage) {
-        m_fbImage = (unsigned char*)malloc(4 * m_width * m_height);
-        if (!m_fbImage) {
-            ERR("out of memory, cancelling OnPost callback");
-            m_onPost = NULL;
-            m_onPostContext = NULL;
+
+    // the first frame of a region callback is read whole
+    m_numPostDamage = 0;
+
+    if (!m_onPost && !m_onPostRegion) {
+        return;
+    }
+    if (m_asyncReadback) {
+        m_readback = PostReadback::create(m_eglDisplay, m_eglConfig,
+                                          m_eglContext, m_width, m_height,
+                                          m_onPost, m_onPostRegion,
+                                          m_onPostContext);
+        if (m_readback) {
             return;
         }
+        ERR("asynchronous readback failed, reading back on post\n");
+    }
+    if (!m_fbImage) {
+        m_fbImage = (unsigned char*)malloc(4 * m_width * m_height);
+    }
+    if (m_onPostRegion && !m_fbRegionTmp) {
+        m_fbRegionTmp = (unsigned char*)malloc(4 * m_width * m_height);
+    }
+    if (!m_fbImage || (m_onPostRegion && !m_fbRegionTmp)) {
+        ERR("out of memory, cancelling OnPost callback");
+        m_onPost = NULL;
+        m_onPostRegion = NULL;
+        m_onPostContext = NULL;
+    }
+}
+
+//
+// updatePostDamage_locked - account for the post of a color buffer. Its
+// damage tells what changed since the frame posted before, as the guest
+// updates what it drew plus what it copied back from the previous buffer,
+// and renders the whole buffer through GL. So for each color buffer of the
+// swap chain, the damage of the posts since it was last read back into
+// the post image is added up. When 'p_readBack', the color buffer is then
+// read back and 'p_damage' gets the parts of the image to read, those
+// changed in it and those other buffers were posted over; a color buffer
+// not read back since the region callback was set damages everything.
+//
+void FrameBuffer::updatePostDamage_locked(HandleType p_colorbuffer,
+                                          ColorBuffer *p_cb, bool p_readBack,
+                                          DamageRegion *p_damage)
+{
+    int width = (int)p_cb->getWidth() < m_width ? p_cb->getWidth() : m_width;
+    int height = (int)p_cb->getHeight() < m_height ? p_cb->getHeight() : m_height;
+
+    DamageRegion cbDamage;
+    DamageRegion damage;
+    p_cb->getDamage(&cbDamage);
+    for (int i = 0; i < cbDamage.numRects(); i++) {
+        const RenderRect &r = cbDamage.rects()[i];
+        damage.add(r.x, r.y, r.width, r.height, width, height);
+    }
+
+    int self = -1;
+    for (int i = 0; i < m_numPostDamage; i++) {
+        if (m_postDamage[i].colorBuffer == p_colorbuffer) {
+            self = i;
+        } else {
+            m_postDamage[i].since.add(damage);
+        }
+    }
+    if (!p_readBack) {
+        // the buffer keeps its damage until it is read back
+        return;
+    }
+
+    p_damage->clear();
+    if (self < 0) {
+        p_damage->setFull(width, height);
+    } else {
+        *p_damage = damage;
+        p_damage->add(m_postDamage[self].since);
+    }
+    p_cb->clearDamage();
+
+    // the buffer read back becomes the most recent one
+    if (self < 0) {
+        if (m_numPostDamage == POST_DAMAGE_BUFFERS) {
+            self = 0;
+        } else {
+            self = m_numPostDamage++;
+        }
     }
+    for (int i = self; i < m_numPostDamage - 1; i++) {
+        m_postDamage[i] = m_postDamage[i + 1];
+    }
+    m_postDamage[m_numPostDamage - 1].colorBuffer = p_colorbuffer;
+    m_postDamage[m_numPostDamage - 1].since.clear();
 }
 
 bool FrameBuffer::setupSubWindow(FBNativeWindowType p_window,
@@ -413,6 +641,11 @@ bool FrameBuffer::setupSubWindow(FBNativeWindowType p_window,
 {
     bool success = false;
 
+    if (s_theFrameBuffer && s_theFrameBuffer->m_headless) {
+        ERR("FrameBuffer is headless, no subwindow can be set\n");
+        return false;
+    }
+
     if (s_theFrameBuffer) {
         s_theFrameBuffer->m_lock.lock();
         FrameBuffer *fb = s_theFrameBuffer;
@@ -475,117 +708,127 @@ bool FrameBuffer::removeSubWindow()
     return removed;
 }
 
-HandleType FrameBuffer::genHandle()
-{
-    HandleType id;
-    do {
-        id = ++s_nextHandle;
-    } while( id == 0 ||
-             m_contexts.find(id) != m_contexts.end() ||
-             m_windows.find(id) != m_windows.end() );
-
-    return id;
-}
-
 HandleType FrameBuffer::createColorBuffer(int p_width, int p_height,
                                           GLenum p_internalFormat)
 {
     android::Mutex::Autolock mutex(m_lock);
     HandleType ret = 0;
 
-    ColorBufferPtr cb( ColorBuffer::create(p_width, p_height, p_internalFormat) );
-    if (cb.Ptr() != NULL) {
-        ret = genHandle();
-        m_colorbuffers[ret].cb = cb;
-        m_colorbuffers[ret].refcount = 1;
+    ColorBufferRef ref;
+    ref.cb = ColorBufferPtr( ColorBuffer::create(p_width, p_height, p_internalFormat) );
+    if (ref.cb.Ptr() != NULL) {
+        ref.refcount = 1;
+        ret = m_colorbuffers.add(ref);
     }
     return ret;
 }
 
+//
+// render contexts and window surfaces are created and destroyed without
+// the FrameBuffer lock, only EGL is called for them
+//
 HandleType FrameBuffer::createRenderContext(int p_config, HandleType p_share,
                                             bool p_isGL2)
 {
-    android::Mutex::Autolock mutex(m_lock);
-    HandleType ret = 0;
-
     RenderContextPtr share(NULL);
-    if (p_share != 0) {
-        RenderContextMap::iterator s( m_contexts.find(p_share) );
-        if (s == m_contexts.end()) {
-            return 0;
-        }
-        share = (*s).second;
+    if (p_share != 0 && !m_contexts.get(p_share, &share)) {
+        return 0;
     }
 
     RenderContextPtr rctx( RenderContext::create(p_config, share, p_isGL2) );
-    if (rctx.Ptr() != NULL) {
-        ret = genHandle();
-        m_contexts[ret] = rctx;
+    if (rctx.Ptr() == NULL) {
+        return 0;
     }
-    return ret;
+    return m_contexts.add(rctx);
 }
 
 HandleType FrameBuffer::createWindowSurface(int p_config, int p_width, int p_height)
 {
-    android::Mutex::Autolock mutex(m_lock);
-
-    HandleType ret = 0;
     WindowSurfacePtr win( WindowSurface::create(p_config, p_width, p_height) );
-    if (win.Ptr() != NULL) {
-        ret = genHandle();
-        m_windows[ret] = win;
+    if (win.Ptr() == NULL) {
+        return 0;
     }
-
-    return ret;
+    return m_windows.add(win);
 }
 
 void FrameBuffer::DestroyRenderContext(HandleType p_context)
 {
-    android::Mutex::Autolock mutex(m_lock);
-    m_contexts.erase(p_context);
+    m_contexts.remove(p_context, NULL);
 }
 
 void FrameBuffer::DestroyWindowSurface(HandleType p_surface)
 {
+    WindowSurfacePtr win;
+    if (!m_windows.remove(p_surface, &win)) {
+        return;
+    }
+
+    // the surface may hold the last reference to its color buffer
     android::Mutex::Autolock mutex(m_lock);
-    m_windows.erase(p_surface);
+    win = WindowSurfacePtr();
 }
 
-void FrameBuffer::openColorBuffer(HandleType p_colorbuffer)
+bool FrameBuffer::openColorBuffer(HandleType p_colorbuffer)
 {
-    android::Mutex::Autolock mutex(m_lock);
-    ColorBufferMap::iterator c(m_colorbuffers.find(p_colorbuffer));
-    if (c == m_colorbuffers.end()) {
+    android::Mutex::Autolock lock(m_colorbuffers.lock());
+    ColorBufferRef *c = m_colorbuffers.find_locked(p_colorbuffer);
+    if (!c) {
         // bad colorbuffer handle
-        return;
+        return false;
     }
-    (*c).second.refcount++;
+    c->refcount++;
+    return true;
 }
 
-void FrameBuffer::closeColorBuffer(HandleType p_colorbuffer)
+//
+// pinColorBuffer - take a reference on the handle like openColorBuffer()
+// and return the color buffer it keeps. Binding it to a texture or a
+// renderbuffer of the current context does not need the FrameBuffer lock;
+// if the guest closes the handle meanwhile, the closeColorBuffer() done
+// once the color buffer is used frees it with the lock held.
+//
+ColorBuffer *FrameBuffer::pinColorBuffer(HandleType p_colorbuffer)
 {
-    android::Mutex::Autolock mutex(m_lock);
-    ColorBufferMap::iterator c(m_colorbuffers.find(p_colorbuffer));
-    if (c == m_colorbuffers.end()) {
-        // bad colorbuffer handle
-        return;
+    android::Mutex::Autolock lock(m_colorbuffers.lock());
+    ColorBufferRef *c = m_colorbuffers.find_locked(p_colorbuffer);
+    if (!c) {
+        return NULL;
     }
-    if (--(*c).second.refcount == 0) {
-        m_colorbuffers.erase(c);
+    c->refcount++;
+    return c->cb.Ptr();
+}
+
+void FrameBuffer::closeColorBuffer(HandleType p_colorbuffer)
+{
+    ColorBufferRef ref;
+    {
+        android::Mutex::Autolock lock(m_colorbuffers.lock());
+        ColorBufferRef *c = m_colorbuffers.find_locked(p_colorbuffer);
+        if (!c) {
+            // bad colorbuffer handle
+            return;
+        }
+        if (--c->refcount > 0) {
+            return;
+        }
+        m_colorbuffers.remove_locked(p_colorbuffer, &ref);
     }
+
+    android::Mutex::Autolock mutex(m_lock);
+    ref.cb = ColorBufferPtr();
 }
 
 bool FrameBuffer::flushWindowSurfaceColorBuffer(HandleType p_surface)
 {
     android::Mutex::Autolock mutex(m_lock);
 
-    WindowSurfaceMap::iterator w( m_windows.find(p_surface) );
-    if (w == m_windows.end()) {
+    WindowSurfacePtr win;
+    if (!m_windows.get(p_surface, &win)) {
         // bad surface handle
         return false;
     }
 
-    return (*w).second->flushColorBuffer();
+    return win->flushColorBuffer();
 }
 
 bool FrameBuffer::setWindowSurfaceColorBuffer(HandleType p_surface,
@@ -593,19 +836,19 @@ bool FrameBuffer::setWindowSurfaceColorBuffer(HandleType p_surface,
 {
     android::Mutex::Autolock mutex(m_lock);
 
-    WindowSurfaceMap::iterator w( m_windows.find(p_surface) );
-    if (w == m_windows.end()) {
+    WindowSurfacePtr win;
+    if (!m_windows.get(p_surface, &win)) {
         // bad surface handle
         return false;
     }
 
-    ColorBufferMap::iterator c( m_colorbuffers.find(p_colorbuffer) );
-    if (c == m_colorbuffers.end()) {
+    ColorBufferRef c;
+    if (!m_colorbuffers.get(p_colorbuffer, &c)) {
         // bad colorbuffer handle
         return false;
     }
 
-    (*w).second->setColorBuffer( (*c).second.cb );
+    win->setColorBuffer(c.cb);
 
     return true;
 }
@@ -616,41 +859,67 @@ bool FrameBuffer::updateColorBuffer(HandleType p_colorbuffer,
 {
     android::Mutex::Autolock mutex(m_lock);
 
-    ColorBufferMap::iterator c( m_colorbuffers.find(p_colorbuffer) );
-    if (c == m_colorbuffers.end()) {
+    ColorBufferRef c;
+    if (!m_colorbuffers.get(p_colorbuffer, &c)) {
         // bad colorbuffer handle
         return false;
     }
 
-    (*c).second.cb->subUpdate(x, y, width, height, format, type, pixels);
+    c.cb->subUpdate(x, y, width, height, format, type, pixels);
 
     return true;
 }
 
-bool FrameBuffer::bindColorBufferToTexture(HandleType p_colorbuffer)
+bool FrameBuffer::readColorBuffer(HandleType p_colorbuffer,
+                                  int x, int y, int width, int height,
+                                  GLenum format, GLenum type, void *pixels)
 {
     android::Mutex::Autolock mutex(m_lock);
 
-    ColorBufferMap::iterator c( m_colorbuffers.find(p_colorbuffer) );
-    if (c == m_colorbuffers.end()) {
+    ColorBufferRef c;
+    if (!m_colorbuffers.get(p_colorbuffer, &c)) {
         // bad colorbuffer handle
         return false;
     }
 
-    return (*c).second.cb->bindToTexture();
+    ColorBuffer *cb = c.cb.Ptr();
+    if (x < 0 || y < 0 || width < 0 || height < 0 ||
+        x + width > (int)cb->getWidth() || y + height > (int)cb->getHeight()) {
+        return false;
+    }
+
+    return cb->readPixels(x, y, width, height, format, type, pixels);
 }
 
-bool FrameBuffer::bindColorBufferToRenderbuffer(HandleType p_colorbuffer)
+bool FrameBuffer::hasColorBuffer(HandleType p_colorbuffer)
 {
-    android::Mutex::Autolock mutex(m_lock);
+    return m_colorbuffers.has(p_colorbuffer);
+}
 
-    ColorBufferMap::iterator c( m_colorbuffers.find(p_colorbuffer) );
-    if (c == m_colorbuffers.end()) {
+bool FrameBuffer::bindColorBufferToTexture(HandleType p_colorbuffer)
+{
+    ColorBuffer *cb = pinColorBuffer(p_colorbuffer);
+    if (!cb) {
         // bad colorbuffer handle
         return false;
     }
 
-    return (*c).second.cb->bindToRenderbuffer();
+    bool ret = cb->bindToTexture();
+    closeColorBuffer(p_colorbuffer);
+    return ret;
+}
+
+bool FrameBuffer::bindColorBufferToRenderbuffer(HandleType p_colorbuffer)
+{
+    ColorBuffer *cb = pinColorBuffer(p_colorbuffer);
+    if (!cb) {
+        // bad colorbuffer handle
+        return false;
+    }
+
+    bool ret = cb->bindToRenderbuffer();
+    closeColorBuffer(p_colorbuffer);
+    return ret;
 }
 
 bool FrameBuffer::bindContext(HandleType p_context,
@@ -666,27 +935,21 @@ bool FrameBuffer::bindContext(HandleType p_context,
     // if this is not an unbind operation - make sure all handles are good
     //
     if (p_context || p_drawSurface || p_readSurface) {
-        RenderContextMap::iterator r( m_contexts.find(p_context) );
-        if (r == m_contexts.end()) {
+        if (!m_contexts.get(p_context, &ctx)) {
             // bad context handle
             return false;
         }
 
-        ctx = (*r).second;
-        WindowSurfaceMap::iterator w( m_windows.find(p_drawSurface) );
-        if (w == m_windows.end()) {
+        if (!m_windows.get(p_drawSurface, &draw)) {
             // bad surface handle
             return false;
         }
-        draw = (*w).second;
 
         if (p_readSurface != p_drawSurface) {
-            WindowSurfaceMap::iterator w( m_windows.find(p_readSurface) );
-            if (w == m_windows.end()) {
+            if (!m_windows.get(p_readSurface, &read)) {
                 // bad surface handle
                 return false;
             }
-            read = (*w).second;
         }
         else {
             read = draw;
@@ -805,74 +1068,199 @@ bool FrameBuffer::unbind_locked()
 bool FrameBuffer::post(HandleType p_colorbuffer, bool needLock)
 {
     if (needLock) m_lock.lock();
+    bool ret = post_locked(p_colorbuffer);
+    if (needLock) m_lock.unlock();
+    return ret;
+}
+
+bool FrameBuffer::post_locked(HandleType p_colorbuffer)
+{
+    long long t0 = RenderMetrics::enabled() ? GetCurrentTimeUS() : 0;
     bool ret = false;
 
-    ColorBufferMap::iterator c( m_colorbuffers.find(p_colorbuffer) );
-    if (c != m_colorbuffers.end()) {
+    ColorBufferRef c;
+    if (m_colorbuffers.get(p_colorbuffer, &c)) {
 
         m_lastPostedColorBuffer = p_colorbuffer;
-        if (!m_subWin) {
+        if (!m_subWin && !m_headless) {
             // no subwindow created for the FB output
             // cannot post the colorbuffer
-            if (needLock) m_lock.unlock();
             return ret;
         }
 
+        if (m_subWin) {
+            // bind the subwindow eglSurface
+            if (!bindSubwin_locked()) {
+                ERR("FrameBuffer::post eglMakeCurrent failed\n");
+                return false;
+            }
 
-        // bind the subwindow eglSurface
-        if (!bindSubwin_locked()) {
-            ERR("FrameBuffer::post eglMakeCurrent failed\n");
-            if (needLock) m_lock.unlock();
-            return false;
-        }
-
-        //
-        // render the color buffer to the window
-        //
-        s_gl.glPushMatrix();
-        s_gl.glRotatef(m_zRot, 0.0f, 0.0f, 1.0f);
-        if (m_zRot != 0.0f) {
-            s_gl.glClear(GL_COLOR_BUFFER_BIT);
-        }
-        ret = (*c).second.cb->post();
-        s_gl.glPopMatrix();
-
-        if (ret) {
             //
-            // output FPS statistics
+            // render the color buffer to the window
             //
-            if (m_fpsStats) {
-                long long currTime = GetCurrentTimeMS();
-                m_statsNumFrames++;
-                if (currTime - m_statsStartTime >= 1000) {
-                    float dt = (float)(currTime - m_statsStartTime) / 1000.0f;
-                    printf("FPS: %5.3f\n", (float)m_statsNumFrames / dt);
-                    m_statsStartTime = currTime;
-                    m_statsNumFrames = 0;
+            s_gl.glPushMatrix();
+            s_gl.glRotatef(m_zRot, 0.0f, 0.0f, 1.0f);
+            if (m_zRot != 0.0f) {
+                s_gl.glClear(GL_COLOR_BUFFER_BIT);
+            }
+            ret = c.cb->post();
+            s_gl.glPopMatrix();
+
+            if (ret) {
+                //
+                // output FPS statistics
+                //
+                if (m_fpsStats) {
+                    long long currTime = GetCurrentTimeMS();
+                    m_statsNumFrames++;
+                    if (currTime - m_statsStartTime >= 1000) {
+                        float dt = (float)(currTime - m_statsStartTime) / 1000.0f;
+                        printf("FPS: %5.3f\n", (float)m_statsNumFrames / dt);
+                        m_statsStartTime = currTime;
+                        m_statsNumFrames = 0;
+                    }
                 }
+
+                s_egl.eglSwapBuffers(m_eglDisplay, m_eglSurface);
             }
 
-            s_egl.eglSwapBuffers(m_eglDisplay, m_eglSurface);
+            // restore previous binding
+            unbind_locked();
+        }
+        else {
+            // headless, the frame only goes to the post callback
+            ret = true;
         }
-
-        // restore previous binding
-        unbind_locked();
 
         //
         // Send framebuffer (without FPS overlay) to callback
         //
-        if (m_onPost) {
-            (*c).second.cb->readback(m_fbImage);
+        if ((m_onPost || m_onPostRegion) && !postDue_locked()) {
+            if (m_onPostRegion) {
+                DamageRegion damage;
+                updatePostDamage_locked(p_colorbuffer, c.cb.Ptr(), false,
+                                        &damage);
+            }
+        }
+        else if (m_onPostRegion) {
+            DamageRegion damage;
+            updatePostDamage_locked(p_colorbuffer, c.cb.Ptr(), true, &damage);
+            if (m_readback) {
+                m_readback->queue(c.cb.Ptr(), &damage);
+            }
+            else {
+                c.cb->readbackRegion(m_fbImage, m_width, damage,
+                                     m_fbRegionTmp);
+                m_onPostRegion(m_onPostContext, m_width, m_height, -1,
+                               GL_RGBA, GL_UNSIGNED_BYTE, damage.numRects(),
+                               damage.rects(), m_fbImage);
+            }
+        }
+        else if (m_readback) {
+            m_readback->queue(c.cb.Ptr(), NULL);
+        }
+        else if (m_onPost) {
+            c.cb->readback(m_fbImage);
             m_onPost(m_onPostContext, m_width, m_height, -1,
                     GL_RGBA, GL_UNSIGNED_BYTE, m_fbImage);
         }
 
+        //
+        // the export readers poll for frames, each one is written
+        // straight into the next slot once they consumed the previous
+        // one, whatever the post rate
+        //
+        if (m_export && m_export->frameConsumed()) {
+            unsigned char *pixels = m_export->beginFrame();
+            c.cb->readPixels(0, 0, m_width, m_height,
+                             GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            m_export->endFrame();
+        }
+
+        if (ret && t0) {
+            RenderMetrics::addPost((unsigned int)(GetCurrentTimeUS() - t0));
+        }
     }
 
-    if (needLock) m_lock.unlock();
     return ret;
 }
 
+//
+// compose - draw the layers posted by the guest into a color buffer of
+// the display size, then post it like one from the guest. It is kept
+// in the color buffer table, so that repost() and the post callbacks
+// work the same for both.
+//
+bool FrameBuffer::compose(const rcComposeLayer *p_layers, int p_numLayers)
+{
+    HandleType target;
+    if (!composeLayers(p_layers, p_numLayers, &target)) {
+        return false;
+    }
+    return queuePost(target);
+}
+
+bool FrameBuffer::composeLayers(const rcComposeLayer *p_layers, int p_numLayers,
+                                HandleType *p_target)
+{
+    android::Mutex::Autolock mutex(m_lock);
+
+    ColorBufferRef target;
+    if (!m_colorbuffers.get(m_composeColorBuffer, &target)) {
+        target.cb = ColorBufferPtr( ColorBuffer::create(m_width, m_height, GL_RGBA) );
+        if (target.cb.Ptr() == NULL) {
+            ERR("FrameBuffer::compose failed to create the target\n");
+            return false;
+        }
+        target.refcount = 1;
+        m_composeColorBuffer = m_colorbuffers.add(target);
+        if (!m_composeColorBuffer) {
+            return false;
+        }
+    }
+
+    // layers whose color buffer is gone are skipped
+    std::vector<ColorBufferRef> refs(p_numLayers);
+    std::vector<ColorBuffer *> sources(p_numLayers);
+    for (int i = 0; i < p_numLayers; i++) {
+        if (m_colorbuffers.get(p_layers[i].colorBuffer, &refs[i])) {
+            sources[i] = refs[i].cb.Ptr();
+        } else {
+            DBG("FrameBuffer::compose bad colorbuffer 0x%x\n", p_layers[i].colorBuffer);
+            sources[i] = NULL;
+        }
+    }
+
+    *p_target = m_composeColorBuffer;
+    return target.cb->compose(p_layers, p_numLayers ? &sources[0] : NULL,
+                              p_numLayers);
+}
+
+//
+// queuePost - hand the frame to the presenter thread when there is one,
+// post it from the calling thread otherwise
+//
+bool FrameBuffer::queuePost(HandleType p_colorbuffer)
+{
+    if (!m_presenter) {
+        return post(p_colorbuffer);
+    }
+    // the presenter holds the color buffer until the frame is shown or
+    // replaced, a bad handle would replace a good frame
+    if (!openColorBuffer(p_colorbuffer)) {
+        return false;
+    }
+    m_presenter->queue(p_colorbuffer);
+    return true;
+}
+
+void FrameBuffer::setSwapInterval(int p_interval)
+{
+    if (m_presenter) {
+        m_presenter->setSwapInterval(p_interval);
+    }
+}
+
 bool FrameBuffer::repost()
 {
     if (m_lastPostedColorBuffer) {
@@ -20,19 +20,33 @@
 #include "ColorBuffer.h"
 #include "RenderContext.h"
 #include "WindowSurface.h"
+#include "PostReadback.h"
+#include "ColorBufferUploader.h"
+#include "Presenter.h"
+#include "FrameExport.h"
+#include "HandleTable.h"
 #include <utils/threads.h>
-#include <map>
 #include <EGL/egl.h>
 #include <stdint.h>
 
-typedef uint32_t HandleType;
 struct ColorBufferRef {
+    ColorBufferRef() : refcount(0) {}
     ColorBufferPtr cb;
     uint32_t refcount;  // number of client-side references
 };
-typedef std::map<HandleType, RenderContextPtr> RenderContextMap;
-typedef std::map<HandleType, WindowSurfacePtr> WindowSurfaceMap;
-typedef std::map<HandleType, ColorBufferRef> ColorBufferMap;
+
+// color buffers whose damage is tracked relative to the post image, the
+// buffers of a guest swap chain
+#define POST_DAMAGE_BUFFERS 4
+
+struct PostDamage {
+    HandleType colorBuffer;
+    DamageRegion since;    // posted over the image since it was read into it
+};
+
+typedef HandleTable<RenderContextPtr> RenderContextTable;
+typedef HandleTable<WindowSurfacePtr> WindowSurfaceTable;
+typedef HandleTable<ColorBufferRef> ColorBufferTable;
 
 struct FrameBufferCaps
 {
@@ -46,7 +60,7 @@ struct FrameBufferCaps
 class FrameBuffer
 {
 public:
-    static bool initialize(int width, int height);
+    static bool initialize(int width, int height, bool headless = false);
     static bool setupSubWindow(FBNativeWindowType p_window,
                                 int x, int y,
                                 int width, int height, float zRot);
@@ -60,6 +74,15 @@ public:
     int getHeight() const { return m_height; }
 
     void setPostCallback(OnPostFn onPost, void* onPostContext);
+    void setPostRegionCallback(OnPostRegionFn onPost, void* onPostContext);
+    void setPostRate(int framesPerSecond);
+    void requestPost();
+    bool setFrameExport(const char *name);
+    bool isHeadless() const { return m_headless; }
+
+    // window surfaces draw into their color buffer through a framebuffer
+    // object rather than a pbuffer, when RENDERER_FBO_SURFACES is set
+    bool useFboSurfaces() const { return m_fboSurfaces; }
 
     void getGLStrings(const char** vendor, const char** renderer, const char** version) const {
         *vendor = m_glVendor;
@@ -72,7 +95,7 @@ public:
     HandleType createColorBuffer(int p_width, int p_height, GLenum p_internalFormat);
     void DestroyRenderContext(HandleType p_context);
     void DestroyWindowSurface(HandleType p_surface);
-    void openColorBuffer(HandleType p_colorbuffer);
+    bool openColorBuffer(HandleType p_colorbuffer);
     void closeColorBuffer(HandleType p_colorbuffer);
 
     bool  bindContext(HandleType p_context, HandleType p_drawSurface, HandleType p_readSurface);
@@ -83,10 +106,21 @@ public:
     bool updateColorBuffer(HandleType p_colorbuffer,
                            int x, int y, int width, int height,
                            GLenum format, GLenum type, void *pixels);
+    bool readColorBuffer(HandleType p_colorbuffer,
+                         int x, int y, int width, int height,
+                         GLenum format, GLenum type, void *pixels);
+    bool hasColorBuffer(HandleType p_colorbuffer);
 
     bool post(HandleType p_colorbuffer, bool needLock = true);
+    bool queuePost(HandleType p_colorbuffer);
+    void setSwapInterval(int p_interval);
+    bool compose(const rcComposeLayer *p_layers, int p_numLayers);
     bool repost();
 
+    ColorBufferPool *getColorBufferPool() { return &m_colorBufferPool; }
+    ColorBufferUploader *getUploader() const { return m_uploader; }
+    Presenter *getPresenter() const { return m_presenter; }
+
     EGLDisplay getDisplay() const { return m_eglDisplay; }
     EGLNativeWindowType getSubWindow() const { return m_subWin; }
     bool bind_locked();
@@ -100,24 +134,42 @@ public:
 private:
     FrameBuffer(int p_width, int p_height);
     ~FrameBuffer();
-    HandleType genHandle();
+    bool post_locked(HandleType p_colorbuffer);
+    ColorBuffer *pinColorBuffer(HandleType p_colorbuffer);
+    bool composeLayers(const rcComposeLayer *p_layers, int p_numLayers,
+                       HandleType *p_target);
     bool bindSubwin_locked();
     void initGLState();
+    void setPostCallbacks_locked(OnPostFn onPost, OnPostRegionFn onPostRegion,
+                                 void* onPostContext);
+    void updatePostDamage_locked(HandleType p_colorbuffer, ColorBuffer *p_cb,
+                                 bool p_readBack, DamageRegion *p_damage);
+    bool postDue_locked();
 
 private:
     static FrameBuffer *s_theFrameBuffer;
-    static HandleType s_nextHandle;
     int m_x;
     int m_y;
     int m_width;
     int m_height;
+    //
+    // m_lock serializes the use of the FrameBuffer contexts and of the
+    // color buffers and window surfaces, but for binding a color buffer
+    // in the current context, and is taken before the lock of a handle
+    // table, never after. The last reference to a ColorBuffer
+    // is dropped with it held, since its destructor binds the
+    // FrameBuffer context.
+    //
     android::Mutex m_lock;
     FBNativeWindowType m_nativeWindow;
     FrameBufferCaps m_caps;
     EGLDisplay m_eglDisplay;
-    RenderContextMap m_contexts;
-    WindowSurfaceMap m_windows;
-    ColorBufferMap m_colorbuffers;
+    RenderContextTable m_contexts;
+    WindowSurfaceTable m_windows;
+    ColorBufferTable m_colorbuffers;
+    ColorBufferPool m_colorBufferPool;
+    ColorBufferUploader *m_uploader;
+    Presenter *m_presenter;
 
     EGLSurface m_eglSurface;
     EGLContext m_eglContext;
@@ -131,6 +183,7 @@ private:
     EGLNativeDisplayType m_subWinDisplay;
     EGLConfig  m_eglConfig;
     HandleType m_lastPostedColorBuffer;
+    HandleType m_composeColorBuffer;    // target of compose()
     float      m_zRot;
     bool       m_eglContextInitialized;
 
@@ -139,8 +192,20 @@ private:
     bool m_fpsStats;
 
     OnPostFn m_onPost;
+    OnPostRegionFn m_onPostRegion;
     void* m_onPostContext;
     unsigned char* m_fbImage;
+    unsigned char* m_fbRegionTmp;
+    PostDamage m_postDamage[POST_DAMAGE_BUFFERS];  // least recently read first
+    int m_numPostDamage;
+    PostReadback* m_readback;
+    bool m_asyncReadback;
+    bool m_fboSurfaces;
+    bool m_headless;
+    int m_postRate;                // frames per second or POST_RATE_*
+    bool m_postRequested;
+    long long m_lastDeliveryUS;
+    FrameExport* m_export;
 
     const char* m_glVendor;
     const char* m_glRenderer;
@@ -0,0 +1,131 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "FrameExport.h"
+#include "TimeUtils.h"
+#include "ErrorLog.h"
+#include <GLES/gl.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+FrameExport::FrameExport() :
+    m_name(NULL),
+    m_hdr(NULL),
+    m_size(0),
+    m_slot(0),
+    m_frameNumber(0)
+{
+}
+
+FrameExport::~FrameExport()
+{
+#ifndef _WIN32
+    if (m_hdr) {
+        munmap(m_hdr, m_size);
+    }
+    if (m_name) {
+        shm_unlink(m_name);
+    }
+#endif
+    free(m_name);
+}
+
+FrameExport *FrameExport::create(const char *name, int width, int height)
+{
+#ifdef _WIN32
+    ERR("FrameExport: not supported on Windows\n");
+    return NULL;
+#else
+    // the pixels of each slot start on a page of their own
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t hdrSize = (sizeof(RenderFrameExportHeader) + page - 1) & ~(page - 1);
+    size_t slotSize = ((size_t)width * height * 4 + page - 1) & ~(page - 1);
+
+    FrameExport *ex = new FrameExport();
+    ex->m_size = hdrSize + RENDER_FRAME_EXPORT_SLOTS * slotSize;
+
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        ERR("FrameExport: shm_open %s failed: %s\n", name, strerror(errno));
+        delete ex;
+        return NULL;
+    }
+    ex->m_name = strdup(name);
+
+    // truncate first, so that a reader of a previous export sees no
+    // valid header while it is set up again
+    if (ftruncate(fd, 0) < 0 || ftruncate(fd, ex->m_size) < 0) {
+        ERR("FrameExport: failed to size %s: %s\n", name, strerror(errno));
+        close(fd);
+        delete ex;
+        return NULL;
+    }
+    void *p = mmap(NULL, ex->m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        ERR("FrameExport: mmap failed: %s\n", strerror(errno));
+        delete ex;
+        return NULL;
+    }
+
+    RenderFrameExportHeader *hdr = (RenderFrameExportHeader *)p;
+    ex->m_hdr = hdr;
+    hdr->version = RENDER_FRAME_EXPORT_VERSION;
+    hdr->width = width;
+    hdr->height = height;
+    hdr->format = GL_RGBA;
+    hdr->type = GL_UNSIGNED_BYTE;
+    hdr->ydir = 1;
+    hdr->stride = width * 4;
+    hdr->latest = RENDER_FRAME_EXPORT_NONE;
+    hdr->consumed = 0;
+    for (int i = 0; i < RENDER_FRAME_EXPORT_SLOTS; i++) {
+        hdr->slots[i].seq = 0;
+        hdr->slots[i].offset = hdrSize + i * slotSize;
+    }
+    __sync_synchronize();
+    hdr->magic = RENDER_FRAME_EXPORT_MAGIC;
+    return ex;
+#endif
+}
+
+unsigned char *FrameExport::beginFrame()
+{
+    m_slot = m_hdr->latest == RENDER_FRAME_EXPORT_NONE ? 0 :
+             (m_hdr->latest + 1) % RENDER_FRAME_EXPORT_SLOTS;
+
+    RenderFrameExportSlot &s = m_hdr->slots[m_slot];
+    s.seq++;
+    __sync_synchronize();
+    return (unsigned char *)m_hdr + s.offset;
+}
+
+void FrameExport::endFrame()
+{
+    RenderFrameExportSlot &s = m_hdr->slots[m_slot];
+    s.frameNumber = ++m_frameNumber;
+    s.timestampUs = GetCurrentTimeUS();
+    __sync_synchronize();
+    s.seq++;
+    __sync_synchronize();
+    m_hdr->latest = m_slot;
+}
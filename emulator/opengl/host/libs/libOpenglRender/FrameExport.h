@@ -0,0 +1,56 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _LIBRENDER_FRAME_EXPORT_H
+#define _LIBRENDER_FRAME_EXPORT_H
+
+#include "libOpenglRender/render_frame_export.h"
+#include <stddef.h>
+
+//
+// FrameExport - the writing side of the shared memory frame export, see
+// render_frame_export.h. Used by FrameBuffer::post() with the
+// FrameBuffer lock held.
+//
+class FrameExport
+{
+public:
+    static FrameExport *create(const char *name, int width, int height);
+
+    // unmaps and unlinks the shared memory
+    ~FrameExport();
+
+    // whether a reader consumed the newest frame, or none was exported
+    bool frameConsumed() const {
+        return m_hdr->consumed >= m_frameNumber;
+    }
+
+    // marks the slot after the latest one being written and returns its
+    // pixels, which endFrame() then publishes
+    unsigned char *beginFrame();
+    void endFrame();
+
+private:
+    FrameExport();
+
+private:
+    char *m_name;
+    RenderFrameExportHeader *m_hdr;
+    size_t m_size;
+    unsigned int m_slot;    // being written
+    unsigned long long m_frameNumber;
+};
+
+#endif
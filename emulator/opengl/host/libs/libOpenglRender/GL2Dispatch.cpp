@@ -21,6 +21,9 @@
 
 gl2_decoder_context_t s_gl2;
 int                   s_gl2_enabled;
+glBlitFramebufferEMU_t s_gl2BlitFramebufferEMU = NULL;
+glCopyToImageEMU_t s_gl2CopyToImageEMU = NULL;
+glReleaseBlitTargetsEMU_t s_gl2ReleaseBlitTargetsEMU = NULL;
 
 static osUtils::dynLibrary *s_gles2_lib = NULL;
 
@@ -45,6 +48,12 @@ bool init_gl2_dispatch()
     // init the GLES dispatch table
     //
     s_gl2.initDispatchByName( gl2_dispatch_get_proc_func, NULL );
+    s_gl2BlitFramebufferEMU = (glBlitFramebufferEMU_t)
+            s_gles2_lib->findSymbol("glBlitFramebufferEMU");
+    s_gl2CopyToImageEMU = (glCopyToImageEMU_t)
+            s_gles2_lib->findSymbol("glCopyToImageEMU");
+    s_gl2ReleaseBlitTargetsEMU = (glReleaseBlitTargetsEMU_t)
+            s_gles2_lib->findSymbol("glReleaseBlitTargetsEMU");
     s_gl2_enabled = true;
     return true;
 }
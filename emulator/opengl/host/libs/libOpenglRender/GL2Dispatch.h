@@ -19,12 +19,16 @@
 #ifdef WITH_GLES2
 
 #include "gl2_dec.h"
+#include "GLDispatch.h"
 
 bool init_gl2_dispatch();
 void *gl2_dispatch_get_proc_func(const char *name, void *userData);
 
 extern gl2_decoder_context_t s_gl2;
 extern int                   s_gl2_enabled;
+extern glBlitFramebufferEMU_t s_gl2BlitFramebufferEMU;
+extern glCopyToImageEMU_t s_gl2CopyToImageEMU;
+extern glReleaseBlitTargetsEMU_t s_gl2ReleaseBlitTargetsEMU;
 
 #endif
 #endif
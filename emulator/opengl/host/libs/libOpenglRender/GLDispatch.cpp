@@ -308,6 +308,9 @@ bool init_gl_dispatch()
     s_gl.glExtGetProgramBinarySourceQCOM = (glExtGetProgramBinarySourceQCOM_t) s_gles_lib->findSymbol("glExtGetProgramBinarySourceQCOM");
     s_gl.glStartTilingQCOM = (glStartTilingQCOM_t) s_gles_lib->findSymbol("glStartTilingQCOM");
     s_gl.glEndTilingQCOM = (glEndTilingQCOM_t) s_gles_lib->findSymbol("glEndTilingQCOM");
+    s_gl.glBlitFramebufferEMU = (glBlitFramebufferEMU_t) s_gles_lib->findSymbol("glBlitFramebufferEMU");
+    s_gl.glCopyToImageEMU = (glCopyToImageEMU_t) s_gles_lib->findSymbol("glCopyToImageEMU");
+    s_gl.glReleaseBlitTargetsEMU = (glReleaseBlitTargetsEMU_t) s_gles_lib->findSymbol("glReleaseBlitTargetsEMU");
 
     return true;
 }
@@ -18,6 +18,16 @@
 
 #include "gl_proc.h"
 
+// host only entry points of the translators, blitting or copying the
+// bound framebuffer into the texture of an EGLImage through host objects
+// the guest does not see; GL_FALSE if the host can not. The objects kept
+// by the blit are deleted by glReleaseBlitTargetsEMU.
+typedef GLboolean (GL_APIENTRY *glBlitFramebufferEMU_t)(GLeglImageOES image,
+        GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+        GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1);
+typedef GLboolean (GL_APIENTRY *glCopyToImageEMU_t)(GLeglImageOES image,
+        GLint x, GLint y, GLsizei width, GLsizei height);
+typedef void (GL_APIENTRY *glReleaseBlitTargetsEMU_t)(void);
 
 struct GLDispatch {
     glAlphaFunc_t glAlphaFunc;
@@ -291,6 +301,9 @@ struct GLDispatch {
     glExtGetProgramBinarySourceQCOM_t glExtGetProgramBinarySourceQCOM;
     glStartTilingQCOM_t glStartTilingQCOM;
     glEndTilingQCOM_t glEndTilingQCOM;
+    glBlitFramebufferEMU_t glBlitFramebufferEMU;
+    glCopyToImageEMU_t glCopyToImageEMU;
+    glReleaseBlitTargetsEMU_t glReleaseBlitTargetsEMU;
 };
 
 bool init_gl_dispatch();
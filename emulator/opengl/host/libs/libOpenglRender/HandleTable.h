@@ -0,0 +1,180 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _LIBRENDER_HANDLE_TABLE_H
+#define _LIBRENDER_HANDLE_TABLE_H
+
+#include <utils/threads.h>
+#include <vector>
+#include <stdint.h>
+
+typedef uint32_t HandleType;
+
+// the low bits of a handle are the slot index plus one, so that no
+// handle is 0, the high bits are the generation of the slot.
+#define HANDLE_INDEX_BITS 20
+#define HANDLE_INDEX_MASK ((1U << HANDLE_INDEX_BITS) - 1)
+#define HANDLE_MAX_SLOTS  (HANDLE_INDEX_MASK - 1)
+
+//
+// HandleTable - maps the handles given to the guest to the objects they
+// name, in a growable array of slots. Looking a handle up is an index
+// and a compare of the generation, which changes each time the slot is
+// freed, so a stale handle is rejected instead of naming the object
+// created after it.
+//
+// Freed slots are reused oldest first, so that a slot goes through its
+// generations as slowly as possible.
+//
+// Each table has a lock of its own, held for the lookup only; the
+// functions ending with _locked are called with lock() held.
+//
+template <class T>
+class HandleTable
+{
+public:
+    HandleTable() : m_freeHead(-1), m_freeTail(-1), m_count(0) {}
+
+    android::Mutex &lock() { return m_lock; }
+
+    // returns 0 when the table is full
+    HandleType add(const T &value) {
+        android::Mutex::Autolock lock(m_lock);
+        return add_locked(value);
+    }
+
+    HandleType add_locked(const T &value) {
+        int index;
+        if (m_freeHead >= 0) {
+            index = m_freeHead;
+            m_freeHead = m_slots[index].nextFree;
+            if (m_freeHead < 0) {
+                m_freeTail = -1;
+            }
+        }
+        else if (m_slots.size() < HANDLE_MAX_SLOTS) {
+            index = m_slots.size();
+            m_slots.push_back(Slot());
+        }
+        else {
+            return 0;
+        }
+
+        Slot &s = m_slots[index];
+        s.value = value;
+        s.used = true;
+        m_count++;
+        return (s.generation << HANDLE_INDEX_BITS) | (index + 1);
+    }
+
+    // copies the object out, so that it can be used once the table
+    // lock is released
+    bool get(HandleType h, T *value) {
+        android::Mutex::Autolock lock(m_lock);
+        T *v = find_locked(h);
+        if (!v) {
+            return false;
+        }
+        *value = *v;
+        return true;
+    }
+
+    bool has(HandleType h) {
+        android::Mutex::Autolock lock(m_lock);
+        return find_locked(h) != NULL;
+    }
+
+    T *find_locked(HandleType h) {
+        unsigned int index = (h & HANDLE_INDEX_MASK) - 1;
+        if (index >= m_slots.size()) {
+            return NULL;
+        }
+        Slot &s = m_slots[index];
+        if (!s.used || s.generation != (h >> HANDLE_INDEX_BITS)) {
+            return NULL;
+        }
+        return &s.value;
+    }
+
+    // moves the object out to 'value' when it is not NULL, the caller
+    // then chooses where the last reference goes. Otherwise it is dropped
+    // once the table lock is released, its destructor may take other locks.
+    bool remove(HandleType h, T *value) {
+        T removed;
+        {
+            android::Mutex::Autolock lock(m_lock);
+            if (!remove_locked(h, &removed)) {
+                return false;
+            }
+        }
+        if (value) {
+            *value = removed;
+        }
+        return true;
+    }
+
+    // the object is moved out to 'value', to be dropped by the caller
+    // after releasing the table lock
+    bool remove_locked(HandleType h, T *value) {
+        if (!find_locked(h)) {
+            return false;
+        }
+        int index = (h & HANDLE_INDEX_MASK) - 1;
+        Slot &s = m_slots[index];
+        *value = s.value;
+        s.value = T();
+        s.used = false;
+        s.generation = (s.generation + 1) & (0xffffffffU >> HANDLE_INDEX_BITS);
+        s.nextFree = -1;
+        if (m_freeTail >= 0) {
+            m_slots[m_freeTail].nextFree = index;
+        } else {
+            m_freeHead = index;
+        }
+        m_freeTail = index;
+        m_count--;
+        return true;
+    }
+
+    size_t size() {
+        android::Mutex::Autolock lock(m_lock);
+        return m_count;
+    }
+
+    void clear() {
+        android::Mutex::Autolock lock(m_lock);
+        m_slots.clear();
+        m_freeHead = -1;
+        m_freeTail = -1;
+        m_count = 0;
+    }
+
+private:
+    struct Slot {
+        Slot() : generation(0), nextFree(-1), used(false) {}
+        T value;
+        uint32_t generation;
+        int nextFree;
+        bool used;
+    };
+
+    android::Mutex m_lock;
+    std::vector<Slot> m_slots;
+    int m_freeHead;
+    int m_freeTail;
+    size_t m_count;
+};
+
+#endif
@@ -0,0 +1,298 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "PostReadback.h"
+#include "FrameBuffer.h"
+#include "EGLDispatch.h"
+#include "GLDispatch.h"
+#include "ErrorLog.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+PostReadback::PostReadback() :
+    m_display(EGL_NO_DISPLAY),
+    m_context(EGL_NO_CONTEXT),
+    m_surface(EGL_NO_SURFACE),
+    m_width(0),
+    m_height(0),
+    m_onPost(NULL),
+    m_onPostRegion(NULL),
+    m_onPostContext(NULL),
+    m_pixels(NULL),
+    m_tmp(NULL),
+    m_nextSeq(0),
+    m_dropped(0),
+    m_exit(false),
+    m_started(false)
+{
+    for (int i = 0; i < POST_READBACK_RING_SIZE; i++) {
+        m_slots[i].tex = 0;
+        m_slots[i].format = 0;
+        m_slots[i].fbo = 0;
+        m_slots[i].state = SLOT_FREE;
+        m_slots[i].seq = 0;
+    }
+}
+
+PostReadback::~PostReadback()
+{
+    if (m_started) {
+        {
+            android::Mutex::Autolock lock(m_lock);
+            m_exit = true;
+            m_cond.signal();
+        }
+        int exitStatus;
+        wait(&exitStatus);
+    }
+
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (fb->bind_locked()) {
+        for (int i = 0; i < POST_READBACK_RING_SIZE; i++) {
+            if (m_slots[i].tex) {
+                s_gl.glDeleteTextures(1, &m_slots[i].tex);
+            }
+        }
+        fb->unbind_locked();
+    }
+
+    if (m_surface != EGL_NO_SURFACE) {
+        s_egl.eglDestroySurface(m_display, m_surface);
+    }
+    if (m_context != EGL_NO_CONTEXT) {
+        s_egl.eglDestroyContext(m_display, m_context);
+    }
+    free(m_pixels);
+    free(m_tmp);
+}
+
+PostReadback *PostReadback::create(EGLDisplay p_display, EGLConfig p_config,
+                                   EGLContext p_shareContext,
+                                   int p_width, int p_height,
+                                   OnPostFn onPost, OnPostRegionFn onPostRegion,
+                                   void *onPostContext)
+{
+    PostReadback *rb = new PostReadback();
+    rb->m_display = p_display;
+    rb->m_width = p_width;
+    rb->m_height = p_height;
+    rb->m_onPost = onPost;
+    rb->m_onPostRegion = onPostRegion;
+    rb->m_onPostContext = onPostContext;
+
+    rb->m_pixels = (unsigned char *)malloc(4 * p_width * p_height);
+    if (onPostRegion) {
+        rb->m_tmp = (unsigned char *)malloc(4 * p_width * p_height);
+    }
+    if (!rb->m_pixels || (onPostRegion && !rb->m_tmp)) {
+        ERR("PostReadback: out of memory\n");
+        delete rb;
+        return NULL;
+    }
+
+    //
+    // the readback context shares the color buffer textures and has
+    // a pbuffer surface of its own to be bound with
+    //
+    GLint glContextAttribs[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 1,
+        EGL_NONE
+    };
+    rb->m_context = s_egl.eglCreateContext(p_display, p_config,
+                                           p_shareContext, glContextAttribs);
+    if (rb->m_context == EGL_NO_CONTEXT) {
+        ERR("PostReadback: failed to create context 0x%x\n", s_egl.eglGetError());
+        delete rb;
+        return NULL;
+    }
+
+    EGLint pbufAttribs[] = {
+        EGL_WIDTH, 1,
+        EGL_HEIGHT, 1,
+        EGL_NONE
+    };
+    rb->m_surface = s_egl.eglCreatePbufferSurface(p_display, p_config,
+                                                  pbufAttribs);
+    if (rb->m_surface == EGL_NO_SURFACE) {
+        ERR("PostReadback: failed to create pbuffer 0x%x\n", s_egl.eglGetError());
+        delete rb;
+        return NULL;
+    }
+
+    //
+    // the ring textures are allocated on first use, to the format of
+    // the color buffer copied into them
+    //
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (!fb->bind_locked()) {
+        delete rb;
+        return NULL;
+    }
+    for (int i = 0; i < POST_READBACK_RING_SIZE; i++) {
+        s_gl.glGenTextures(1, &rb->m_slots[i].tex);
+        s_gl.glBindTexture(GL_TEXTURE_2D, rb->m_slots[i].tex);
+        s_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        s_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    }
+    fb->unbind_locked();
+
+    if (!rb->start()) {
+        ERR("PostReadback: failed to start thread\n");
+        delete rb;
+        return NULL;
+    }
+    rb->m_started = true;
+
+    return rb;
+}
+
+bool PostReadback::queue(ColorBuffer *p_cb, const DamageRegion *p_damage)
+{
+    // keep the damage of frames which could not be queued
+    DamageRegion damage = m_lostDamage;
+    m_lostDamage.clear();
+    if (p_damage) {
+        damage.add(*p_damage);
+    }
+
+    //
+    // take a free texture, or the one of the oldest frame which is
+    // still waiting. Only this thread makes a slot leave SLOT_FREE.
+    //
+    int s = -1;
+    {
+        android::Mutex::Autolock lock(m_lock);
+        for (int i = 0; i < POST_READBACK_RING_SIZE; i++) {
+            if (m_slots[i].state == SLOT_FREE) {
+                s = i;
+                break;
+            }
+        }
+        if (s < 0) {
+            s = nextQueued_locked();
+            if (s < 0) {
+                m_lostDamage = damage;
+                return false;
+            }
+            m_slots[s].state = SLOT_FREE;
+            damage.add(m_slots[s].damage);
+            m_dropped++;
+        }
+    }
+
+    Slot &slot = m_slots[s];
+    GLenum format = p_cb->getInternalFormat();
+    if (slot.format != format) {
+        FrameBuffer *fb = FrameBuffer::getFB();
+        if (!fb->bind_locked()) {
+            m_lostDamage = damage;
+            return false;
+        }
+        s_gl.glBindTexture(GL_TEXTURE_2D, slot.tex);
+        s_gl.glTexImage2D(GL_TEXTURE_2D, 0, format, m_width, m_height, 0,
+                          format, GL_UNSIGNED_BYTE, NULL);
+        fb->unbind_locked();
+        slot.format = format;
+    }
+
+    int width = (int)p_cb->getWidth() < m_width ? p_cb->getWidth() : m_width;
+    int height = (int)p_cb->getHeight() < m_height ? p_cb->getHeight() : m_height;
+    if (!p_cb->copyToTexture(slot.tex, width, height)) {
+        m_lostDamage = damage;
+        return false;
+    }
+
+    android::Mutex::Autolock lock(m_lock);
+    slot.damage = damage;
+    slot.state = SLOT_QUEUED;
+    slot.seq = m_nextSeq++;
+    m_cond.signal();
+    return true;
+}
+
+int PostReadback::nextQueued_locked() const
+{
+    int s = -1;
+    for (int i = 0; i < POST_READBACK_RING_SIZE; i++) {
+        if (m_slots[i].state == SLOT_QUEUED &&
+            (s < 0 || (int)(m_slots[i].seq - m_slots[s].seq) < 0)) {
+            s = i;
+        }
+    }
+    return s;
+}
+
+int PostReadback::Main()
+{
+    if (!s_egl.eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+        ERR("PostReadback: eglMakeCurrent failed 0x%x\n", s_egl.eglGetError());
+        return -1;
+    }
+
+    while (1) {
+        int s;
+        {
+            android::Mutex::Autolock lock(m_lock);
+            while (!m_exit && (s = nextQueued_locked()) < 0) {
+                m_cond.wait(m_lock);
+            }
+            if (m_exit) {
+                break;
+            }
+            m_slots[s].state = SLOT_READING;
+        }
+
+        //
+        // attaching the texture again makes the copy flushed by the
+        // FrameBuffer context visible to this one
+        //
+        Slot &slot = m_slots[s];
+        if (!slot.fbo) {
+            s_gl.glGenFramebuffersOES(1, &slot.fbo);
+        }
+        s_gl.glBindFramebufferOES(GL_FRAMEBUFFER_OES, slot.fbo);
+        s_gl.glFramebufferTexture2DOES(GL_FRAMEBUFFER_OES,
+                                       GL_COLOR_ATTACHMENT0_OES,
+                                       GL_TEXTURE_2D, slot.tex, 0);
+        if (m_onPostRegion) {
+            slot.damage.readPixels(m_pixels, m_width, m_tmp);
+            m_onPostRegion(m_onPostContext, m_width, m_height, -1,
+                           GL_RGBA, GL_UNSIGNED_BYTE,
+                           slot.damage.numRects(), slot.damage.rects(),
+                           m_pixels);
+        }
+        else if (s_gl.glCheckFramebufferStatusOES(GL_FRAMEBUFFER_OES) ==
+                 GL_FRAMEBUFFER_COMPLETE_OES) {
+            s_gl.glReadPixels(0, 0, m_width, m_height,
+                              GL_RGBA, GL_UNSIGNED_BYTE, m_pixels);
+            m_onPost(m_onPostContext, m_width, m_height, -1,
+                     GL_RGBA, GL_UNSIGNED_BYTE, m_pixels);
+        }
+
+        android::Mutex::Autolock lock(m_lock);
+        slot.state = SLOT_FREE;
+    }
+
+    s_gl.glBindFramebufferOES(GL_FRAMEBUFFER_OES, 0);
+    for (int i = 0; i < POST_READBACK_RING_SIZE; i++) {
+        if (m_slots[i].fbo) {
+            s_gl.glDeleteFramebuffersOES(1, &m_slots[i].fbo);
+            m_slots[i].fbo = 0;
+        }
+    }
+    s_egl.eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                         EGL_NO_CONTEXT);
+    return 0;
+}
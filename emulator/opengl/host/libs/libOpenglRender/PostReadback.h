@@ -0,0 +1,107 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _LIBRENDER_POST_READBACK_H
+#define _LIBRENDER_POST_READBACK_H
+
+#include "libOpenglRender/render_api.h"
+#include "ColorBuffer.h"
+#include "DamageRegion.h"
+#include "osThread.h"
+#include <utils/threads.h>
+#include <EGL/egl.h>
+
+// number of posted frames which can wait for their readback
+#define POST_READBACK_RING_SIZE 3
+
+//
+// PostReadback - delivers the posted frames to the post callback from a
+// thread of its own, so that FrameBuffer::post() does not wait for the
+// pixels to reach the CPU.
+//
+// The translator has no pixel buffer objects or fences, so the pipeline
+// is built from a ring of textures instead: post() copies the color
+// buffer into the next free texture on the GPU and flushes, then the
+// readback thread reads the texture with glReadPixels through a context
+// sharing with the FrameBuffer's, and calls the callback. Frames are
+// delivered in order, usually one or two posts late. When all the
+// textures are waiting, the oldest waiting frame is dropped.
+//
+// With a region callback, only the damaged rectangles of each frame are
+// read, into an image kept from frame to frame; the damage of a dropped
+// frame goes with the next one.
+//
+class PostReadback : public osUtils::Thread
+{
+public:
+    static PostReadback *create(EGLDisplay p_display, EGLConfig p_config,
+                                EGLContext p_shareContext,
+                                int p_width, int p_height,
+                                OnPostFn onPost, OnPostRegionFn onPostRegion,
+                                void *onPostContext);
+
+    // stops the thread, no callback is made once it returns
+    ~PostReadback();
+
+    // queues the color buffer contents for the callback, must be called
+    // with the FrameBuffer lock held and its context not bound. The
+    // damage is needed by a region callback only.
+    bool queue(ColorBuffer *p_cb, const DamageRegion *p_damage);
+
+    unsigned int droppedFrames() const { return m_dropped; }
+
+private:
+    PostReadback();
+    virtual int Main();
+    int nextQueued_locked() const;
+
+    enum SlotState {
+        SLOT_FREE,
+        SLOT_QUEUED,
+        SLOT_READING
+    };
+
+    struct Slot {
+        GLuint tex;
+        GLenum format;    // internal format of tex, 0 until first use
+        GLuint fbo;       // in the readback context
+        SlotState state;
+        unsigned int seq;
+        DamageRegion damage;
+    };
+
+private:
+    EGLDisplay m_display;
+    EGLContext m_context;
+    EGLSurface m_surface;
+    int m_width;
+    int m_height;
+    OnPostFn m_onPost;
+    OnPostRegionFn m_onPostRegion;
+    void *m_onPostContext;
+    unsigned char *m_pixels;
+    unsigned char *m_tmp;
+
+    android::Mutex m_lock;
+    android::Condition m_cond;
+    Slot m_slots[POST_READBACK_RING_SIZE];
+    DamageRegion m_lostDamage;    // only used by queue()
+    unsigned int m_nextSeq;
+    unsigned int m_dropped;
+    bool m_exit;
+    bool m_started;
+};
+
+#endif
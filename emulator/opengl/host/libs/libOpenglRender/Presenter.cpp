@@ -0,0 +1,171 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "Presenter.h"
+#include "FrameBuffer.h"
+#include "RenderMetrics.h"
+#include "TimeUtils.h"
+#include "ErrorLog.h"
+
+Presenter::Presenter() :
+    m_fb(NULL),
+    m_pacing(PRESENT_SWAP_INTERVAL),
+    m_rate(PRESENT_DISPLAY_RATE),
+    m_pending(0),
+    m_swapInterval(1),
+    m_presented(0),
+    m_dropped(0),
+    m_exit(false),
+    m_started(false)
+{
+}
+
+Presenter::~Presenter()
+{
+    if (m_started) {
+        {
+            android::Mutex::Autolock lock(m_lock);
+            m_exit = true;
+            m_cond.signal();
+        }
+        int exitStatus;
+        wait(&exitStatus);
+    }
+    if (m_pending) {
+        m_fb->closeColorBuffer(m_pending);
+        m_pending = 0;
+    }
+    DBG("Presenter: %u frames presented, %u dropped\n", m_presented, m_dropped);
+}
+
+Presenter *Presenter::create(FrameBuffer *p_fb, PresentPacing p_pacing,
+                             int p_rate)
+{
+    Presenter *p = new Presenter();
+    p->m_fb = p_fb;
+    p->m_pacing = p_pacing;
+    if (p_pacing == PRESENT_FIXED_RATE) {
+        p->m_rate = p_rate > 0 ? p_rate : PRESENT_DISPLAY_RATE;
+    }
+
+    if (!p->start()) {
+        ERR("Presenter: failed to start thread\n");
+        delete p;
+        return NULL;
+    }
+    p->m_started = true;
+    return p;
+}
+
+void Presenter::queue(HandleType p_colorbuffer)
+{
+    HandleType replaced;
+    {
+        android::Mutex::Autolock lock(m_lock);
+        replaced = m_pending;
+        if (replaced) {
+            m_dropped++;
+            RenderMetrics::addDroppedPost();
+        }
+        m_pending = p_colorbuffer;
+        m_cond.signal();
+    }
+
+    // closing may destroy the color buffer, which takes the FrameBuffer
+    // lock
+    if (replaced) {
+        m_fb->closeColorBuffer(replaced);
+    }
+}
+
+void Presenter::setSwapInterval(int p_interval)
+{
+    if (p_interval < 0) {
+        p_interval = 0;
+    }
+    if (p_interval > PRESENT_MAX_SWAP_INTERVAL) {
+        p_interval = PRESENT_MAX_SWAP_INTERVAL;
+    }
+    android::Mutex::Autolock lock(m_lock);
+    m_swapInterval = p_interval;
+    m_cond.signal();
+}
+
+long long Presenter::periodUS_locked() const
+{
+    switch (m_pacing) {
+        case PRESENT_FIXED_RATE:
+            return 1000000LL / m_rate;
+        case PRESENT_SWAP_INTERVAL:
+            return m_swapInterval * 1000000LL / PRESENT_DISPLAY_RATE;
+        default:
+            return 0;
+    }
+}
+
+int Presenter::Main()
+{
+    long long lastUS = 0;
+
+    while (1) {
+        HandleType cb;
+        long long period = 0;
+        {
+            //
+            // wait for a frame, then for its time to come. A frame
+            // posted in the meantime replaces it.
+            //
+            android::Mutex::Autolock lock(m_lock);
+            while (!m_exit) {
+                if (!m_pending) {
+                    m_cond.wait(m_lock);
+                    continue;
+                }
+                period = periodUS_locked();
+                long long waitUS = lastUS + period - GetCurrentTimeUS();
+                if (waitUS <= 0) {
+                    break;
+                }
+                m_cond.waitRelative(m_lock, waitUS * 1000LL);
+            }
+            if (m_exit) {
+                break;
+            }
+            cb = m_pending;
+            m_pending = 0;
+        }
+
+        long long now = GetCurrentTimeUS();
+        bool posted = m_fb->post(cb);
+        m_fb->closeColorBuffer(cb);
+        {
+            android::Mutex::Autolock lock(m_lock);
+            if (posted) {
+                m_presented++;
+            } else {
+                m_dropped++;
+                RenderMetrics::addDroppedPost();
+            }
+        }
+
+        // keep to the cadence while the frames come in time for it
+        if (period > 0 && now - lastUS < 2 * period) {
+            lastUS += period;
+        } else {
+            lastUS = now;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _LIBRENDER_PRESENTER_H
+#define _LIBRENDER_PRESENTER_H
+
+#include "HandleTable.h"
+#include "osThread.h"
+#include <utils/threads.h>
+
+class FrameBuffer;
+
+// refresh rate of the display when pacing by the swap interval
+#define PRESENT_DISPLAY_RATE        60
+#define PRESENT_MAX_SWAP_INTERVAL   4
+
+enum PresentPacing {
+    PRESENT_UNTHROTTLED,     // present each frame as soon as it is posted
+    PRESENT_FIXED_RATE,      // at most 'rate' frames per second
+    PRESENT_SWAP_INTERVAL    // at most one frame every 'swap interval'
+                             // refreshes of a PRESENT_DISPLAY_RATE display
+};
+
+//
+// Presenter - shows the posted color buffers from a thread of its own,
+// so that rcFBPost returns as soon as the frame is queued instead of
+// waiting for the FrameBuffer lock and the swap.
+//
+// There is a single frame waiting, a mailbox: a frame posted before the
+// previous one was shown replaces it, and the replaced frame is counted
+// as dropped, as is a frame which fails to post. Frames are shown no
+// faster than the pacing allows.
+//
+class Presenter : public osUtils::Thread
+{
+public:
+    static Presenter *create(FrameBuffer *p_fb, PresentPacing p_pacing,
+                             int p_rate);
+
+    // stops the thread, the frame waiting is not shown but closed
+    ~Presenter();
+
+    // make the color buffer the next frame to show. The caller opened
+    // it, the presenter closes it once the frame is shown or replaced.
+    void queue(HandleType p_colorbuffer);
+
+    // swap interval of the guest, 0 to show frames unthrottled
+    void setSwapInterval(int p_interval);
+
+    unsigned int presentedFrames() const { return m_presented; }
+    unsigned int droppedFrames() const { return m_dropped; }
+
+private:
+    Presenter();
+    virtual int Main();
+    long long periodUS_locked() const;
+
+private:
+    FrameBuffer *m_fb;
+    PresentPacing m_pacing;
+    int m_rate;
+
+    android::Mutex m_lock;
+    android::Condition m_cond;
+    HandleType m_pending;        // 0 when no frame is waiting
+    int m_swapInterval;
+    unsigned int m_presented;
+    unsigned int m_dropped;
+    bool m_exit;
+    bool m_started;
+};
+
+#endif
@@ -17,48 +17,220 @@
 #include <string.h>
 #include <assert.h>
 #include <limits.h>
+#include <stdint.h>
 #include "ErrorLog.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define READ_BUFFER_USE_MIRROR 1
+#endif
+
+#ifdef READ_BUFFER_USE_MIRROR
+//
+// Allocate 'size' bytes of memory mapped twice back to back, so that
+// p[i] and p[i + size] alias each other. Any range of up to 'size' bytes
+// starting inside the first half is then contiguous, which lets the
+// buffer wrap around without ever moving data.
+//
+static unsigned char *allocMirrored(size_t size)
+{
+    static volatile int32_t s_counter = 0;
+    char name[64];
+    snprintf(name, sizeof(name), "/emugl-rbuf-%d-%d", (int)getpid(),
+             (int)__sync_add_and_fetch(&s_counter, 1));
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        return NULL;
+    }
+    shm_unlink(name);
+
+    if (ftruncate(fd, size) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    unsigned char *base = (unsigned char *)mmap(NULL, 2 * size, PROT_NONE,
+                                                MAP_PRIVATE | MAP_ANONYMOUS,
+                                                -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    for (int m = 0; m < 2; m++) {
+        if (mmap(base + m * size, size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(base, 2 * size);
+            close(fd);
+            return NULL;
+        }
+    }
+    close(fd);
+    return base;
+}
+
+static void freeMirrored(unsigned char *p, size_t size)
+{
+    munmap(p, 2 * size);
+}
+
+static size_t roundToPage(size_t size)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) & ~(page - 1);
+}
+#endif
+
 ReadBuffer::ReadBuffer(IOStream *stream, size_t bufsize)
 {
-    m_size = bufsize;
     m_stream = stream;
-    m_buf = (unsigned char*)malloc(m_size*sizeof(unsigned char));
+    m_buf = NULL;
     m_validData = 0;
+    m_direct = false;
+    m_mirrored = false;
+
+#ifdef READ_BUFFER_USE_MIRROR
+    bufsize = roundToPage(bufsize);
+    m_buf = allocMirrored(bufsize);
+    m_mirrored = (m_buf != NULL);
+#endif
+    if (!m_buf) {
+        m_buf = (unsigned char*)malloc(bufsize*sizeof(unsigned char));
+    }
+    m_size = m_baseSize = bufsize;
     m_readPtr = m_buf;
 }
 
 ReadBuffer::~ReadBuffer()
 {
+#ifdef READ_BUFFER_USE_MIRROR
+    if (m_mirrored) {
+        freeMirrored(m_buf, m_size);
+        return;
+    }
+#endif
     free(m_buf);
 }
 
-int ReadBuffer::getData()
+//
+// resize - reallocate the buffer to 'new_size' bytes, keeping the valid
+// data at the start of the new buffer. With a mirrored buffer this is the
+// only place data gets copied, once per growth step of a packet which
+// does not fit.
+//
+bool ReadBuffer::resize(size_t new_size)
 {
+    assert(new_size >= m_validData);
+
+#ifdef READ_BUFFER_USE_MIRROR
+    if (m_mirrored) {
+        new_size = roundToPage(new_size);
+        unsigned char *new_buf = allocMirrored(new_size);
+        if (!new_buf) {
+            return false;
+        }
+        if (m_validData > 0) {
+            memcpy(new_buf, m_readPtr, m_validData);
+        }
+        freeMirrored(m_buf, m_size);
+        m_buf = new_buf;
+        m_readPtr = m_buf;
+        m_size = new_size;
+        return true;
+    }
+#endif
+
     if ((m_validData > 0) && (m_readPtr > m_buf)) {
         memmove(m_buf, m_readPtr, m_validData);
     }
+    unsigned char *new_buf = (unsigned char*)realloc(m_buf, new_size);
+    if (!new_buf) {
+        return false;
+    }
+    m_buf = new_buf;
+    m_readPtr = m_buf;
+    m_size = new_size;
+    return true;
+}
+
+int ReadBuffer::getData()
+{
+    //
+    // If the stream exposes its incoming data in place, hand that memory
+    // to the decoders directly instead of copying it into m_buf.
+    //
+    if (m_stream->canPeek() && (m_direct || m_validData == 0)) {
+        size_t avail = 0;
+        const unsigned char *p = m_stream->peekIn(m_validData + 1, &avail);
+        if (!p) {
+            return -1;
+        }
+        if (avail > m_validData) {
+            int fresh = avail - m_validData;
+            m_readPtr = (unsigned char *)p;
+            m_validData = avail;
+            m_direct = true;
+            return fresh;
+        }
+
+        //
+        // The stream is full with a single incomplete packet which is
+        // larger than its buffer, move what we have into m_buf and
+        // continue with the copying path until the packet is consumed.
+        //
+        m_direct = false;
+        m_validData = 0;
+        m_readPtr = m_buf;
+        if (m_size <= avail && !resize(avail * 2)) {
+            ERR("Failed to alloc %zu bytes for ReadBuffer\n", avail * 2);
+            return -1;
+        }
+        memcpy(m_buf, p, avail);
+        m_stream->consumeIn(avail);
+        m_validData = avail;
+    }
+
+    if (m_validData == 0) {
+        m_readPtr = m_buf;
+    }
+    else if (!m_mirrored && m_readPtr > m_buf) {
+        memmove(m_buf, m_readPtr, m_validData);
+        m_readPtr = m_buf;
+    }
+
     // get fresh data into the buffer;
     size_t len = m_size - m_validData;
     if (len==0) {
-        //we need to inc our buffer
+        //
+        // A single packet does not fit, grow the buffer. The packet length
+        // is the second word of every packet header, so grow straight to
+        // a size which can hold it instead of doubling repeatedly.
+        //
         size_t new_size = m_size*2;
-        unsigned char* new_buf;
+        if (m_validData >= 8) {
+            size_t packetLen = *(uint32_t *)(m_readPtr + 4);
+            while (new_size < packetLen && new_size * 2 > new_size) {
+                new_size *= 2;
+            }
+        }
         if (new_size < m_size) { // overflow check
             new_size = INT_MAX;
         }
 
-        new_buf = (unsigned char*)realloc(m_buf, new_size);
-        if (!new_buf) {
+        if (!resize(new_size)) {
             ERR("Failed to alloc %zu bytes for ReadBuffer\n", new_size);
             return -1;
         }
-        m_size = new_size;
-        m_buf  = new_buf;
         len    = m_size - m_validData;
     }
-    m_readPtr = m_buf;
-    if (NULL != m_stream->read(m_buf + m_validData, &len)) {
+
+    // with a mirrored buffer the free space following the valid data is
+    // contiguous, even when it wraps around the end of m_buf.
+    if (NULL != m_stream->read(m_readPtr + m_validData, &len)) {
         m_validData += len;
         return len;
     }
@@ -68,6 +240,21 @@ int ReadBuffer::getData()
 void ReadBuffer::consume(size_t amount)
 {
     assert(amount <= m_validData);
+    if (m_direct) {
+        m_stream->consumeIn(amount);
+    }
     m_validData -= amount;
     m_readPtr += amount;
+    if (m_mirrored && !m_direct && m_readPtr >= m_buf + m_size) {
+        m_readPtr -= m_size;
+    }
+
+    //
+    // Shrink back to the base size as soon as the packets which made the
+    // buffer grow are consumed, a render thread may block in read() for
+    // a long time once the burst is over.
+    //
+    if (m_validData == 0 && m_size > m_baseSize) {
+        resize(m_baseSize);
+    }
 }
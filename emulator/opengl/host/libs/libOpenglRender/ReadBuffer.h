@@ -27,10 +27,15 @@ public:
     size_t validData() { return m_validData; } // return the amount of valid data in readptr
     void consume(size_t amount); // notify that 'amount' data has been consumed;
 private:
+    bool resize(size_t new_size);
+
     unsigned char *m_buf;
     unsigned char *m_readPtr;
     size_t m_size;
+    size_t m_baseSize;   // size to shrink back to after bursts
     size_t m_validData;
     IOStream *m_stream;
+    bool m_direct;    // m_readPtr points into the stream's own memory
+    bool m_mirrored;  // m_buf is mapped twice, data may wrap around its end
 };
 #endif
@@ -18,6 +18,16 @@
 #include "FrameBuffer.h"
 #include "EGLDispatch.h"
 #include "GLDispatch.h"
+#include "GL2Dispatch.h"
+#include <GLES/glext.h>
+#include <string.h>
+
+// calls the translator of the context, which must be current
+#ifdef WITH_GLES2
+#define CTX_GL(gl1call, gl2call) (m_isGL2 ? s_gl2.gl2call : s_gl.gl1call)
+#else
+#define CTX_GL(gl1call, gl2call) (s_gl.gl1call)
+#endif
 
 RenderContext *RenderContext::create(int p_config,
                                      RenderContextPtr p_shareContext,
@@ -64,13 +74,294 @@ RenderContext *RenderContext::create(int p_config,
 RenderContext::RenderContext() :
     m_ctx(EGL_NO_CONTEXT),
     m_config(0),
-    m_isGL2(false)
+    m_isGL2(false),
+    m_surfaceFbo(0),
+    m_surfaceTex(0),
+    m_surfaceDepthRB(0),
+    m_surfaceImage(NULL),
+    m_surfaceWidth(0),
+    m_surfaceHeight(0),
+    m_blitTargets(false),
+    m_blitUnsupported(false)
 {
 }
 
 RenderContext::~RenderContext()
 {
     if (m_ctx != EGL_NO_CONTEXT) {
+        deleteObjects();
         s_egl.eglDestroyContext(FrameBuffer::getFB()->getDisplay(), m_ctx);
     }
 }
+
+//
+// deleteObjects - delete the GL objects of the context, which is made
+// current on a small pbuffer of its config for that. The thread's
+// previous context and surfaces are restored.
+//
+void RenderContext::deleteObjects()
+{
+    if (!m_surfaceFbo && !m_surfaceTex && !m_surfaceDepthRB && !m_blitTargets) {
+        return;
+    }
+
+    EGLDisplay dpy = FrameBuffer::getFB()->getDisplay();
+    const FBConfig *fbconf = FBConfig::get(m_config);
+    if (!fbconf) {
+        return;
+    }
+    EGLint pbufAttribs[] = {
+        EGL_WIDTH, 1,
+        EGL_HEIGHT, 1,
+        EGL_NONE
+    };
+    EGLSurface pbuf = s_egl.eglCreatePbufferSurface(dpy, fbconf->getEGLConfig(),
+                                                    pbufAttribs);
+    if (pbuf == EGL_NO_SURFACE) {
+        ERR("RenderContext: failed to create a pbuffer to delete objects\n");
+        return;
+    }
+
+    EGLContext prevContext = s_egl.eglGetCurrentContext();
+    EGLSurface prevReadSurf = s_egl.eglGetCurrentSurface(EGL_READ);
+    EGLSurface prevDrawSurf = s_egl.eglGetCurrentSurface(EGL_DRAW);
+    if (s_egl.eglMakeCurrent(dpy, pbuf, pbuf, m_ctx)) {
+        if (m_surfaceFbo) {
+            CTX_GL(glDeleteFramebuffersOES(1, &m_surfaceFbo),
+                   glDeleteFramebuffers(1, &m_surfaceFbo));
+        }
+        if (m_surfaceTex) {
+            CTX_GL(glDeleteTextures(1, &m_surfaceTex),
+                   glDeleteTextures(1, &m_surfaceTex));
+        }
+        if (m_surfaceDepthRB) {
+            CTX_GL(glDeleteRenderbuffersOES(1, &m_surfaceDepthRB),
+                   glDeleteRenderbuffers(1, &m_surfaceDepthRB));
+        }
+        m_surfaceFbo = m_surfaceTex = m_surfaceDepthRB = 0;
+        if (m_blitTargets) {
+#ifdef WITH_GLES2
+            glReleaseBlitTargetsEMU_t release = m_isGL2 ?
+                    s_gl2ReleaseBlitTargetsEMU : s_gl.glReleaseBlitTargetsEMU;
+#else
+            glReleaseBlitTargetsEMU_t release = s_gl.glReleaseBlitTargetsEMU;
+#endif
+            if (release) {
+                release();
+            }
+            m_blitTargets = false;
+        }
+        s_egl.eglMakeCurrent(dpy, prevDrawSurf, prevReadSurf, prevContext);
+    }
+    else {
+        ERR("RenderContext: eglMakeCurrent failed, objects not deleted\n");
+    }
+    s_egl.eglDestroySurface(dpy, pbuf);
+}
+
+//
+// attachSurfaceImage - make the surface framebuffer object draw into
+// 'p_image', with depth and stencil buffers of its size. The first time,
+// the viewport and scissor box are set to the surface, as EGL does for
+// the first surface a context is bound to. The framebuffer binding is
+// left to the caller.
+//
+bool RenderContext::attachSurfaceImage(EGLImageKHR p_image,
+                                       GLuint p_width, GLuint p_height,
+                                       GLuint p_depthSize, GLuint p_stencilSize)
+{
+    if (m_surfaceFbo && p_image == m_surfaceImage &&
+        p_width == m_surfaceWidth && p_height == m_surfaceHeight) {
+        return true;
+    }
+
+    GLenum depthFormat = 0;
+    if (p_stencilSize > 0) {
+        depthFormat = GL_DEPTH24_STENCIL8_OES;
+    }
+    else if (p_depthSize > 16) {
+        depthFormat = GL_DEPTH_COMPONENT24_OES;
+    }
+    else if (p_depthSize > 0) {
+        depthFormat = GL_DEPTH_COMPONENT16_OES;
+    }
+
+    bool firstAttach = (m_surfaceFbo == 0);
+    bool ret;
+#ifdef WITH_GLES2
+    if (m_isGL2) {
+        ret = attachSurfaceImageGL2(p_image, p_width, p_height,
+                                    depthFormat, p_stencilSize > 0);
+    }
+    else
+#endif
+    {
+        ret = attachSurfaceImageGL1(p_image, p_width, p_height,
+                                    depthFormat, p_stencilSize > 0);
+    }
+    if (!ret) {
+        m_surfaceImage = NULL;
+        return false;
+    }
+
+    if (firstAttach) {
+#ifdef WITH_GLES2
+        if (m_isGL2) {
+            s_gl2.glViewport(0, 0, p_width, p_height);
+            s_gl2.glScissor(0, 0, p_width, p_height);
+        }
+        else
+#endif
+        {
+            s_gl.glViewport(0, 0, p_width, p_height);
+            s_gl.glScissor(0, 0, p_width, p_height);
+        }
+    }
+    m_surfaceImage = p_image;
+    m_surfaceWidth = p_width;
+    m_surfaceHeight = p_height;
+    return true;
+}
+
+bool RenderContext::attachSurfaceImageGL1(EGLImageKHR p_image,
+                                          GLuint p_width, GLuint p_height,
+                                          GLenum p_depthFormat, bool p_stencil)
+{
+    GLint prevFbo, prevTex, prevRB;
+    s_gl.glGetIntegerv(GL_FRAMEBUFFER_BINDING_OES, &prevFbo);
+    s_gl.glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTex);
+    s_gl.glGetIntegerv(GL_RENDERBUFFER_BINDING_OES, &prevRB);
+
+    if (!m_surfaceFbo) {
+        s_gl.glGenFramebuffersOES(1, &m_surfaceFbo);
+        s_gl.glGenTextures(1, &m_surfaceTex);
+    }
+    s_gl.glBindFramebufferOES(GL_FRAMEBUFFER_OES, m_surfaceFbo);
+
+    if (p_image != m_surfaceImage) {
+        s_gl.glBindTexture(GL_TEXTURE_2D, m_surfaceTex);
+        s_gl.glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, p_image);
+        s_gl.glFramebufferTexture2DOES(GL_FRAMEBUFFER_OES,
+                                       GL_COLOR_ATTACHMENT0_OES,
+                                       GL_TEXTURE_2D, m_surfaceTex, 0);
+    }
+
+    if (p_depthFormat &&
+        (!m_surfaceDepthRB || p_width != m_surfaceWidth ||
+         p_height != m_surfaceHeight)) {
+        if (!m_surfaceDepthRB) {
+            s_gl.glGenRenderbuffersOES(1, &m_surfaceDepthRB);
+        }
+        s_gl.glBindRenderbufferOES(GL_RENDERBUFFER_OES, m_surfaceDepthRB);
+        s_gl.glRenderbufferStorageOES(GL_RENDERBUFFER_OES, p_depthFormat,
+                                      p_width, p_height);
+        s_gl.glFramebufferRenderbufferOES(GL_FRAMEBUFFER_OES,
+                                          GL_DEPTH_ATTACHMENT_OES,
+                                          GL_RENDERBUFFER_OES, m_surfaceDepthRB);
+        if (p_stencil) {
+            s_gl.glFramebufferRenderbufferOES(GL_FRAMEBUFFER_OES,
+                                              GL_STENCIL_ATTACHMENT_OES,
+                                              GL_RENDERBUFFER_OES,
+                                              m_surfaceDepthRB);
+        }
+    }
+
+    bool ret = s_gl.glCheckFramebufferStatusOES(GL_FRAMEBUFFER_OES) ==
+               GL_FRAMEBUFFER_COMPLETE_OES;
+
+    s_gl.glBindRenderbufferOES(GL_RENDERBUFFER_OES, prevRB);
+    s_gl.glBindTexture(GL_TEXTURE_2D, prevTex);
+    s_gl.glBindFramebufferOES(GL_FRAMEBUFFER_OES, prevFbo);
+    return ret;
+}
+
+#ifdef WITH_GLES2
+bool RenderContext::attachSurfaceImageGL2(EGLImageKHR p_image,
+                                          GLuint p_width, GLuint p_height,
+                                          GLenum p_depthFormat, bool p_stencil)
+{
+    GLint prevFbo, prevTex, prevRB;
+    s_gl2.glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFbo);
+    s_gl2.glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTex);
+    s_gl2.glGetIntegerv(GL_RENDERBUFFER_BINDING, &prevRB);
+
+    if (!m_surfaceFbo) {
+        s_gl2.glGenFramebuffers(1, &m_surfaceFbo);
+        s_gl2.glGenTextures(1, &m_surfaceTex);
+    }
+    s_gl2.glBindFramebuffer(GL_FRAMEBUFFER, m_surfaceFbo);
+
+    if (p_image != m_surfaceImage) {
+        s_gl2.glBindTexture(GL_TEXTURE_2D, m_surfaceTex);
+        s_gl2.glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, p_image);
+        s_gl2.glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                     GL_TEXTURE_2D, m_surfaceTex, 0);
+    }
+
+    if (p_depthFormat &&
+        (!m_surfaceDepthRB || p_width != m_surfaceWidth ||
+         p_height != m_surfaceHeight)) {
+        if (!m_surfaceDepthRB) {
+            s_gl2.glGenRenderbuffers(1, &m_surfaceDepthRB);
+        }
+        s_gl2.glBindRenderbuffer(GL_RENDERBUFFER, m_surfaceDepthRB);
+        s_gl2.glRenderbufferStorage(GL_RENDERBUFFER, p_depthFormat,
+                                    p_width, p_height);
+        s_gl2.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                        GL_RENDERBUFFER, m_surfaceDepthRB);
+        if (p_stencil) {
+            s_gl2.glFramebufferRenderbuffer(GL_FRAMEBUFFER,
+                                            GL_STENCIL_ATTACHMENT,
+                                            GL_RENDERBUFFER, m_surfaceDepthRB);
+        }
+    }
+
+    bool ret = s_gl2.glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
+               GL_FRAMEBUFFER_COMPLETE;
+
+    s_gl2.glBindRenderbuffer(GL_RENDERBUFFER, prevRB);
+    s_gl2.glBindTexture(GL_TEXTURE_2D, prevTex);
+    s_gl2.glBindFramebuffer(GL_FRAMEBUFFER, prevFbo);
+    return ret;
+}
+#endif
+
+bool RenderContext::blitToImage(EGLImageKHR p_image,
+                                GLuint p_width, GLuint p_height)
+{
+#ifdef WITH_GLES2
+    glBlitFramebufferEMU_t blit = m_isGL2 ? s_gl2BlitFramebufferEMU :
+                                            s_gl.glBlitFramebufferEMU;
+#else
+    glBlitFramebufferEMU_t blit = s_gl.glBlitFramebufferEMU;
+#endif
+    if (m_blitUnsupported || !blit || !p_image) {
+        return false;
+    }
+
+    m_blitTargets = true;
+    if (!blit((GLeglImageOES)p_image, 0, 0, p_width, p_height,
+              0, p_height, p_width, 0)) {
+        m_blitUnsupported = true;
+        return false;
+    }
+
+    // the FrameBuffer context reads the image next
+    CTX_GL(glFlush(), glFlush());
+    return true;
+}
+
+bool RenderContext::copyToImage(EGLImageKHR p_image,
+                                GLuint p_width, GLuint p_height)
+{
+#ifdef WITH_GLES2
+    glCopyToImageEMU_t copy = m_isGL2 ? s_gl2CopyToImageEMU :
+                                        s_gl.glCopyToImageEMU;
+#else
+    glCopyToImageEMU_t copy = s_gl.glCopyToImageEMU;
+#endif
+    if (!copy || !p_image) {
+        return false;
+    }
+    return copy((GLeglImageOES)p_image, 0, 0, p_width, p_height) == GL_TRUE;
+}
@@ -18,6 +18,8 @@
 
 #include "SmartPtr.h"
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES/gl.h>
 #include "GLDecoderContextData.h"
 
 class RenderContext;
@@ -36,14 +38,47 @@ public:
 
     GLDecoderContextData & decoderContextData() { return m_contextData; }
 
+    // the framebuffer object which stands for the default framebuffer
+    // while the context draws to a window surface backed by its color
+    // buffer, see WindowSurface. Both are used with the context current.
+    GLuint getSurfaceFbo() const { return m_surfaceFbo; }
+    bool attachSurfaceImage(EGLImageKHR p_image, GLuint p_width, GLuint p_height,
+                            GLuint p_depthSize, GLuint p_stencilSize);
+
+    // copy the read buffer into the image of a color buffer storage,
+    // upside down with blitToImage(), which fails when the host cannot
+    // blit framebuffers, or as it is with copyToImage(). The translator
+    // does both through host objects, which take no name of the guest.
+    // Both are called with the context current.
+    bool blitToImage(EGLImageKHR p_image, GLuint p_width, GLuint p_height);
+    bool copyToImage(EGLImageKHR p_image, GLuint p_width, GLuint p_height);
+
 private:
     RenderContext();
 
+    void deleteObjects();
+    bool attachSurfaceImageGL1(EGLImageKHR p_image, GLuint p_width, GLuint p_height,
+                               GLenum p_depthFormat, bool p_stencil);
+    bool attachSurfaceImageGL2(EGLImageKHR p_image, GLuint p_width, GLuint p_height,
+                               GLenum p_depthFormat, bool p_stencil);
+
 private:
     EGLContext m_ctx;
     int        m_config;
     bool       m_isGL2;
     GLDecoderContextData    m_contextData;
+
+    // the surface objects, deleted by ~RenderContext: the host contexts
+    // all share their objects, so destroying m_ctx does not free them
+    GLuint      m_surfaceFbo;
+    GLuint      m_surfaceTex;
+    GLuint      m_surfaceDepthRB;
+    EGLImageKHR m_surfaceImage;
+    GLuint      m_surfaceWidth;
+    GLuint      m_surfaceHeight;
+
+    bool        m_blitTargets;     // the translator keeps objects to blit
+    bool        m_blitUnsupported;
 };
 
 #endif
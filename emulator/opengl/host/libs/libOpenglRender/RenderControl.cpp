@@ -20,8 +20,11 @@
 #include "GLDispatch.h"
 #include "GL2Dispatch.h"
 #include "ThreadInfo.h"
+#include "glUtils.h"
+#include <string.h>
 
-static const GLint rendererVersion = 1;
+// 2 - rcCompose is supported
+static const GLint rendererVersion = 2;
 
 static GLint rcGetRendererVersion()
 {
@@ -149,10 +152,11 @@ static EGLint rcGetFBParam(EGLint param)
             ret = 60;
             break;
         case FB_MIN_SWAP_INTERVAL:
-            ret = 1; // XXX: should be implemented
+            // the swap interval is only followed by the presenter thread
+            ret = fb->getPresenter() ? 0 : 1;
             break;
         case FB_MAX_SWAP_INTERVAL:
-            ret = 1; // XXX: should be implemented
+            ret = fb->getPresenter() ? PRESENT_MAX_SWAP_INTERVAL : 1;
             break;
         default:
             break;
@@ -275,12 +279,17 @@ static void rcFBPost(uint32_t colorBuffer)
         return;
     }
 
-    fb->post(colorBuffer);
+    fb->queuePost(colorBuffer);
 }
 
 static void rcFBSetSwapInterval(EGLint interval)
 {
-   // XXX: TBD - should be implemented
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (!fb) {
+        return;
+    }
+
+    fb->setSwapInterval(interval);
 }
 
 static void rcBindTexture(uint32_t colorBuffer)
@@ -303,19 +312,55 @@ static void rcBindRenderbuffer(uint32_t colorBuffer)
     fb->bindColorBufferToRenderbuffer(colorBuffer);
 }
 
+//
+// The renderer keeps no CPU copy of the color buffers, rcReadColorBuffer
+// reads the GPU, so there is never anything to flush: only the handle is
+// checked.
+//
 static EGLint rcColorBufferCacheFlush(uint32_t colorBuffer,
                                       EGLint postCount, int forRead)
 {
-   // XXX: TBD - should be implemented
-   return 0;
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (!fb || !fb->hasColorBuffer(colorBuffer)) {
+        return -1;
+    }
+    return 0;
 }
 
+//
+// rcReadColorBuffer - 'pixels' is the reply buffer of the decoder, the
+// rectangle is read into it directly. On failure it is cleared rather
+// than sending back whatever the buffer held.
+//
 static void rcReadColorBuffer(uint32_t colorBuffer,
                               GLint x, GLint y,
                               GLint width, GLint height,
                               GLenum format, GLenum type, void* pixels)
 {
-   // XXX: TBD - should be implemented
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (fb && fb->readColorBuffer(colorBuffer, x, y, width, height,
+                                  format, type, pixels)) {
+        return;
+    }
+    if (width > 0 && height > 0) {
+        size_t len = ((glUtilsPixelBitSize(format, type) * width) >> 3) * height;
+        memset(pixels, 0, len);
+    }
+}
+
+//
+// rcCompose - the layers are composed and shown on the host instead of
+// by the guest with GL. Returns -1 when nothing was posted.
+//
+static int rcCompose(uint32_t bufferSize, void* buffer)
+{
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (!fb || bufferSize % sizeof(rcComposeLayer) != 0) {
+        return -1;
+    }
+
+    int numLayers = bufferSize / sizeof(rcComposeLayer);
+    return fb->compose((const rcComposeLayer *)buffer, numLayers) ? 0 : -1;
 }
 
 static int rcUpdateColorBuffer(uint32_t colorBuffer,
@@ -359,4 +404,5 @@ void initRenderControlContext(renderControl_decoder_context_t *dec)
     dec->set_rcColorBufferCacheFlush(rcColorBufferCacheFlush);
     dec->set_rcReadColorBuffer(rcReadColorBuffer);
     dec->set_rcUpdateColorBuffer(rcUpdateColorBuffer);
+    dec->set_rcCompose(rcCompose);
 }
@@ -0,0 +1,398 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "RenderMetrics.h"
+#include "TimeUtils.h"
+#include <string.h>
+#include <stdio.h>
+#include <algorithm>
+
+#define OPCODE_PAGE_SHIFT 8
+#define OPCODE_PAGE_SIZE  (1 << OPCODE_PAGE_SHIFT)
+
+// opcodes above this are accounted as opcode 0, a corrupted stream
+// must not make us allocate pages for the whole 32-bit range.
+#define OPCODE_MAX        (1 << 16)
+
+// number of opcodes listed for each stream in the periodic dump
+#define DUMP_TOP_OPCODES  5
+
+android::Mutex RenderMetrics::s_lock;
+volatile bool RenderMetrics::s_enabled = false;
+int RenderMetrics::s_dumpPeriodMS = 0;
+long long RenderMetrics::s_lastDumpMS = 0;
+unsigned int RenderMetrics::s_nextStreamId = 1;
+RenderMetrics::StreamVec RenderMetrics::s_streams;
+RenderMetrics::StreamVec RenderMetrics::s_closed;
+unsigned long long RenderMetrics::s_posts = 0;
+unsigned long long RenderMetrics::s_postTimeUs = 0;
+unsigned int RenderMetrics::s_postHist[RENDER_METRICS_HIST_BUCKETS];
+unsigned long long RenderMetrics::s_droppedPosts = 0;
+RenderMetricsSnapshot *RenderMetrics::s_lastDump = NULL;
+
+StreamMetrics::StreamMetrics(unsigned int id) :
+    m_id(id),
+    m_startTimeMS(GetCurrentTimeMS()),
+    m_endTimeMS(0),
+    m_bytesReceived(0),
+    m_bytesReplied(0),
+    m_packets(0),
+    m_timeUs(0)
+{
+}
+
+StreamMetrics::~StreamMetrics()
+{
+    for (size_t i = 0; i < m_pages.size(); i++) {
+        delete [] m_pages[i];
+    }
+}
+
+void StreamMetrics::addReceived(size_t bytes)
+{
+    android::Mutex::Autolock mutex(m_lock);
+    m_bytesReceived += bytes;
+}
+
+void StreamMetrics::addPacket(uint32_t opcode, size_t bytes,
+                              size_t replyBytes, unsigned int timeUs)
+{
+    android::Mutex::Autolock mutex(m_lock);
+    if (opcode >= OPCODE_MAX) {
+        opcode = 0;
+    }
+    size_t page = opcode >> OPCODE_PAGE_SHIFT;
+    if (page >= m_pages.size()) {
+        m_pages.resize(page + 1, NULL);
+    }
+    if (!m_pages[page]) {
+        m_pages[page] = new OpcodeMetrics[OPCODE_PAGE_SIZE];
+        memset(m_pages[page], 0, OPCODE_PAGE_SIZE * sizeof(OpcodeMetrics));
+    }
+
+    OpcodeMetrics *op = &m_pages[page][opcode & (OPCODE_PAGE_SIZE - 1)];
+    op->calls++;
+    op->bytes += bytes;
+    op->replyBytes += replyBytes;
+    op->timeUs += timeUs;
+    op->timeHist[RenderMetrics::histBucket(timeUs)]++;
+
+    m_packets++;
+    m_bytesReplied += replyBytes;
+    m_timeUs += timeUs;
+}
+
+int RenderMetrics::histBucket(unsigned int timeUs)
+{
+    int b = 0;
+    while (timeUs > 0 && b < RENDER_METRICS_HIST_BUCKETS - 1) {
+        timeUs >>= 1;
+        b++;
+    }
+    return b;
+}
+
+void RenderMetrics::setEnabled(bool enable, int dumpPeriodMS)
+{
+    android::Mutex::Autolock mutex(s_lock);
+
+    if (!enable) {
+        //
+        // The streams belong to their render threads, which keep them
+        // until they exit, only reset what they collected.
+        //
+        for (size_t i = 0; i < s_streams.size(); i++) {
+            StreamMetrics *s = s_streams[i];
+            s->m_lock.lock();
+            for (size_t p = 0; p < s->m_pages.size(); p++) {
+                delete [] s->m_pages[p];
+            }
+            s->m_pages.clear();
+            s->m_bytesReceived = 0;
+            s->m_bytesReplied = 0;
+            s->m_packets = 0;
+            s->m_timeUs = 0;
+            s->m_lock.unlock();
+        }
+        for (size_t i = 0; i < s_closed.size(); i++) {
+            delete s_closed[i];
+        }
+        s_closed.clear();
+        s_posts = 0;
+        s_postTimeUs = 0;
+        memset(s_postHist, 0, sizeof(s_postHist));
+        s_droppedPosts = 0;
+        delete s_lastDump;
+        s_lastDump = NULL;
+    }
+
+    s_dumpPeriodMS = enable ? dumpPeriodMS : 0;
+    s_lastDumpMS = GetCurrentTimeMS();
+    s_enabled = enable;
+}
+
+StreamMetrics *RenderMetrics::openStream()
+{
+    android::Mutex::Autolock mutex(s_lock);
+    StreamMetrics *s = new StreamMetrics(s_nextStreamId++);
+    s_streams.push_back(s);
+    return s;
+}
+
+void RenderMetrics::closeStream(StreamMetrics *stream)
+{
+    if (!stream) {
+        return;
+    }
+    android::Mutex::Autolock mutex(s_lock);
+    StreamVec::iterator it = std::find(s_streams.begin(), s_streams.end(), stream);
+    if (it != s_streams.end()) {
+        s_streams.erase(it);
+    }
+
+    // no need to lock the stream, its render thread is done with it
+    stream->m_endTimeMS = GetCurrentTimeMS();
+    s_closed.push_back(stream);
+    if (s_closed.size() > RENDER_METRICS_MAX_STREAMS) {
+        delete s_closed.front();
+        s_closed.erase(s_closed.begin());
+    }
+}
+
+void RenderMetrics::addPost(unsigned int timeUs)
+{
+    android::Mutex::Autolock mutex(s_lock);
+    s_posts++;
+    s_postTimeUs += timeUs;
+    s_postHist[histBucket(timeUs)]++;
+}
+
+void RenderMetrics::addDroppedPost()
+{
+    if (!s_enabled) {
+        return;
+    }
+    android::Mutex::Autolock mutex(s_lock);
+    s_droppedPosts++;
+}
+
+static bool compareOpcodeTime(const RenderOpcodeMetrics &a,
+                              const RenderOpcodeMetrics &b)
+{
+    return a.timeUs > b.timeUs;
+}
+
+void RenderMetrics::snapshot(RenderMetricsSnapshot *snap)
+{
+    android::Mutex::Autolock mutex(s_lock);
+    snapshot_locked(snap);
+}
+
+void RenderMetrics::snapshot_locked(RenderMetricsSnapshot *snap)
+{
+    memset(snap, 0, sizeof(*snap));
+    snap->timeMs = GetCurrentTimeMS();
+
+    // open streams first, then the closed ones from the most recent
+    StreamVec streams(s_streams);
+    streams.insert(streams.end(), s_closed.rbegin(), s_closed.rend());
+
+    std::vector<RenderOpcodeMetrics> ops;
+    for (size_t i = 0; i < streams.size(); i++) {
+        StreamMetrics *s = streams[i];
+        s->m_lock.lock();
+
+        if (snap->numStreams < RENDER_METRICS_MAX_STREAMS) {
+            RenderStreamMetrics *sm = &snap->streams[snap->numStreams++];
+            sm->streamId = s->m_id;
+            sm->active = (s->m_endTimeMS == 0);
+            sm->ageMs = (sm->active ? snap->timeMs : s->m_endTimeMS) -
+                        s->m_startTimeMS;
+            sm->bytesReceived = s->m_bytesReceived;
+            sm->bytesReplied = s->m_bytesReplied;
+            sm->packets = s->m_packets;
+            sm->timeUs = s->m_timeUs;
+        }
+
+        for (size_t p = 0; p < s->m_pages.size(); p++) {
+            StreamMetrics::OpcodeMetrics *page = s->m_pages[p];
+            if (!page) {
+                continue;
+            }
+            for (int o = 0; o < OPCODE_PAGE_SIZE; o++) {
+                if (page[o].calls == 0) {
+                    continue;
+                }
+                RenderOpcodeMetrics om;
+                om.streamId = s->m_id;
+                om.opcode = (p << OPCODE_PAGE_SHIFT) + o;
+                om.calls = page[o].calls;
+                om.bytes = page[o].bytes;
+                om.replyBytes = page[o].replyBytes;
+                om.timeUs = page[o].timeUs;
+                memcpy(om.timeHist, page[o].timeHist, sizeof(om.timeHist));
+                ops.push_back(om);
+            }
+        }
+
+        s->m_lock.unlock();
+    }
+
+    size_t nops = std::min(ops.size(), (size_t)RENDER_METRICS_MAX_OPCODES);
+    std::partial_sort(ops.begin(), ops.begin() + nops, ops.end(),
+                      compareOpcodeTime);
+    for (size_t i = 0; i < nops; i++) {
+        snap->opcodes[i] = ops[i];
+    }
+    snap->numOpcodes = nops;
+
+    snap->posts = s_posts;
+    snap->postTimeUs = s_postTimeUs;
+    memcpy(snap->postHist, s_postHist, sizeof(s_postHist));
+    snap->droppedPosts = s_droppedPosts;
+}
+
+void RenderMetrics::dumpIfDue()
+{
+    if (!s_enabled || s_dumpPeriodMS <= 0) {
+        return;
+    }
+
+    long long now = GetCurrentTimeMS();
+    if (now - s_lastDumpMS < s_dumpPeriodMS) {
+        return;
+    }
+
+    android::Mutex::Autolock mutex(s_lock);
+    // check again, another thread may have dumped in the meantime
+    if (now - s_lastDumpMS < s_dumpPeriodMS) {
+        return;
+    }
+    s_lastDumpMS = now;
+
+    RenderMetricsSnapshot *snap = new RenderMetricsSnapshot;
+    snapshot_locked(snap);
+    dump(snap, s_lastDump);
+    delete s_lastDump;
+    s_lastDump = snap;
+}
+
+static const RenderStreamMetrics *findStream(const RenderMetricsSnapshot *snap,
+                                             unsigned int id)
+{
+    for (unsigned int i = 0; snap && i < snap->numStreams; i++) {
+        if (snap->streams[i].streamId == id) {
+            return &snap->streams[i];
+        }
+    }
+    return NULL;
+}
+
+static const RenderOpcodeMetrics *findOpcode(const RenderMetricsSnapshot *snap,
+                                             unsigned int id,
+                                             unsigned int opcode)
+{
+    for (unsigned int i = 0; snap && i < snap->numOpcodes; i++) {
+        if (snap->opcodes[i].streamId == id &&
+            snap->opcodes[i].opcode == opcode) {
+            return &snap->opcodes[i];
+        }
+    }
+    return NULL;
+}
+
+//
+// dump - print the activity since the previous dump, 'prev' may be NULL.
+// Counters of streams and opcodes which were not in 'prev' are taken
+// whole.
+//
+void RenderMetrics::dump(const RenderMetricsSnapshot *snap,
+                         const RenderMetricsSnapshot *prev)
+{
+    long long dt = prev ? snap->timeMs - prev->timeMs : s_dumpPeriodMS;
+    if (dt <= 0) {
+        dt = 1;
+    }
+    float dts = (float)dt / 1000.0f;
+    const float MB = 1024.0f * 1024.0f;
+
+    unsigned long long posts = snap->posts - (prev ? prev->posts : 0);
+    unsigned long long postTime = snap->postTimeUs - (prev ? prev->postTimeUs : 0);
+    unsigned long long dropped = snap->droppedPosts - (prev ? prev->droppedPosts : 0);
+    unsigned int active = 0;
+    for (unsigned int i = 0; i < snap->numStreams; i++) {
+        active += snap->streams[i].active;
+    }
+    printf("Renderer metrics: %u streams, %5.1f posts/s, post avg %llu us, "
+           "%5.1f dropped/s\n",
+           active, (float)posts / dts,
+           posts ? postTime / posts : 0ULL, (float)dropped / dts);
+
+    for (unsigned int i = 0; i < snap->numStreams; i++) {
+        const RenderStreamMetrics *s = &snap->streams[i];
+        const RenderStreamMetrics *p = findStream(prev, s->streamId);
+        unsigned long long in = s->bytesReceived - (p ? p->bytesReceived : 0);
+        unsigned long long out = s->bytesReplied - (p ? p->bytesReplied : 0);
+        unsigned long long packets = s->packets - (p ? p->packets : 0);
+        unsigned long long time = s->timeUs - (p ? p->timeUs : 0);
+        if (!s->active && p && packets == 0) {
+            continue;
+        }
+        printf("  stream %u: in %7.3f MB/s, out %7.3f MB/s, %8.0f packets/s, busy %5.1f%%\n",
+               s->streamId, (float)in / MB / dts, (float)out / MB / dts,
+               (float)packets / dts, (float)time / (dts * 10000.0f));
+
+        //
+        // the opcodes are sorted by total time, list those which
+        // took the most time during this period.
+        //
+        const RenderOpcodeMetrics *top[DUMP_TOP_OPCODES];
+        unsigned long long topTime[DUMP_TOP_OPCODES];
+        int ntop = 0;
+        for (unsigned int o = 0; o < snap->numOpcodes; o++) {
+            const RenderOpcodeMetrics *op = &snap->opcodes[o];
+            if (op->streamId != s->streamId) {
+                continue;
+            }
+            const RenderOpcodeMetrics *pop = findOpcode(prev, s->streamId, op->opcode);
+            unsigned long long t = op->timeUs - (pop ? pop->timeUs : 0);
+            if (op->calls == (pop ? pop->calls : 0)) {
+                continue;
+            }
+            int k = ntop < DUMP_TOP_OPCODES ? ntop++ : DUMP_TOP_OPCODES;
+            while (k > 0 && topTime[k - 1] < t) {
+                if (k < DUMP_TOP_OPCODES) {
+                    top[k] = top[k - 1];
+                    topTime[k] = topTime[k - 1];
+                }
+                k--;
+            }
+            if (k < DUMP_TOP_OPCODES) {
+                top[k] = op;
+                topTime[k] = t;
+            }
+        }
+        for (int k = 0; k < ntop; k++) {
+            const RenderOpcodeMetrics *op = top[k];
+            const RenderOpcodeMetrics *pop = findOpcode(prev, s->streamId, op->opcode);
+            unsigned long long calls = op->calls - (pop ? pop->calls : 0);
+            unsigned long long bytes = op->bytes - (pop ? pop->bytes : 0);
+            printf("    opcode %5u: %8.0f calls/s, %7.3f MB/s, avg %llu us\n",
+                   op->opcode, (float)calls / dts, (float)bytes / MB / dts,
+                   topTime[k] / calls);
+        }
+    }
+    fflush(stdout);
+}
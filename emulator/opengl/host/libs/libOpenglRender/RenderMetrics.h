@@ -0,0 +1,111 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _LIB_OPENGL_RENDER_RENDER_METRICS_H
+#define _LIB_OPENGL_RENDER_RENDER_METRICS_H
+
+#include "libOpenglRender/render_api.h"
+#include <utils/threads.h>
+#include <stdint.h>
+#include <vector>
+
+//
+// StreamMetrics - the metrics of one connection to the renderer, updated
+// by the connection's RenderThread. The lock is never held while a packet
+// is executed, which may need the FrameBuffer lock.
+//
+class StreamMetrics
+{
+public:
+    void addReceived(size_t bytes);
+    void addPacket(uint32_t opcode, size_t bytes, size_t replyBytes,
+                   unsigned int timeUs);
+
+private:
+    friend class RenderMetrics;
+
+    StreamMetrics(unsigned int id);
+    ~StreamMetrics();
+
+    struct OpcodeMetrics {
+        unsigned long long calls;
+        unsigned long long bytes;
+        unsigned long long replyBytes;
+        unsigned long long timeUs;
+        unsigned int       timeHist[RENDER_METRICS_HIST_BUCKETS];
+    };
+
+    // opcodes are grouped in lazily allocated pages of 256 entries
+    typedef std::vector<OpcodeMetrics *> PageVec;
+
+    android::Mutex m_lock;
+    unsigned int m_id;
+    long long m_startTimeMS;
+    long long m_endTimeMS;   // 0 while the stream is open
+    unsigned long long m_bytesReceived;
+    unsigned long long m_bytesReplied;
+    unsigned long long m_packets;
+    unsigned long long m_timeUs;
+    PageVec m_pages;
+};
+
+//
+// RenderMetrics - registry of the connections' metrics and of the
+// FrameBuffer post timings, see the metrics section of render_api.h.
+//
+class RenderMetrics
+{
+public:
+    static bool enabled() { return s_enabled; }
+    static void setEnabled(bool enable, int dumpPeriodMS);
+
+    // register the metrics of a connection, and release them when it
+    // closes. The metrics of the last closed streams are kept around.
+    static StreamMetrics *openStream();
+    static void closeStream(StreamMetrics *stream);
+
+    static void addPost(unsigned int timeUs);
+    static void addDroppedPost();
+
+    static void snapshot(RenderMetricsSnapshot *snap);
+
+    // print a summary if the dump period elapsed since the last one
+    static void dumpIfDue();
+
+    // index of the histogram bucket of a sample
+    static int histBucket(unsigned int timeUs);
+
+private:
+    typedef std::vector<StreamMetrics *> StreamVec;
+
+    static void snapshot_locked(RenderMetricsSnapshot *snap);
+    static void dump(const RenderMetricsSnapshot *snap,
+                     const RenderMetricsSnapshot *prev);
+
+    static android::Mutex s_lock;
+    static volatile bool s_enabled;
+    static int s_dumpPeriodMS;
+    static long long s_lastDumpMS;
+    static unsigned int s_nextStreamId;
+    static StreamVec s_streams;
+    static StreamVec s_closed;   // oldest first
+    static unsigned long long s_posts;
+    static unsigned long long s_postTimeUs;
+    static unsigned int s_postHist[RENDER_METRICS_HIST_BUCKETS];
+    static unsigned long long s_droppedPosts;
+    static RenderMetricsSnapshot *s_lastDump;
+};
+
+#endif
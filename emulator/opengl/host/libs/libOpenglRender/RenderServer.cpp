@@ -20,11 +20,20 @@
 #else
 #include "UnixStream.h"
 #endif
+#ifdef __linux__
+#include "ShmStream.h"
+#endif
 #include "RenderThread.h"
 #include "FrameBuffer.h"
 #include <set>
+#include <vector>
 
 typedef std::set<RenderThread *> RenderThreadsSet;
+typedef std::vector<RenderThread *> RenderThreadsPool;
+
+// number of render threads started ahead of the connections, ready to
+// serve them without the cost of creating a thread and its decoders.
+#define RENDER_THREAD_POOL_SIZE 2
 
 RenderServer::RenderServer() :
     m_listenSock(NULL),
@@ -49,6 +58,10 @@ RenderServer *RenderServer::create(char* addr, size_t addrLen)
 
     if (gRendererStreamMode == STREAM_MODE_TCP) {
         server->m_listenSock = new TcpStream();
+#ifdef __linux__
+    } else if (gRendererStreamMode == STREAM_MODE_SHM) {
+        server->m_listenSock = new ShmStream();
+#endif
     } else {
 #ifdef _WIN32
         server->m_listenSock = new Win32PipeStream();
@@ -76,9 +89,28 @@ RenderServer *RenderServer::create(char* addr, size_t addrLen)
     return server;
 }
 
+static void fillPool(RenderThreadsPool &pool)
+{
+    while (pool.size() < RENDER_THREAD_POOL_SIZE) {
+        RenderThread *rt = RenderThread::create(NULL);
+        if (!rt) {
+            break;
+        }
+        if (!rt->start()) {
+            fprintf(stderr,"Failed to start pooled RenderThread\n");
+            delete rt;
+            break;
+        }
+        pool.push_back(rt);
+    }
+}
+
 int RenderServer::Main()
 {
     RenderThreadsSet threads;
+    RenderThreadsPool pool;
+
+    fillPool(pool);
 
     while(1) {
         SocketStream *stream = m_listenSock->accept();
@@ -102,17 +134,42 @@ int RenderServer::Main()
             break;
         }
 
-        RenderThread *rt = RenderThread::create(stream);
-        if (!rt) {
-            fprintf(stderr,"Failed to create RenderThread\n");
-            delete stream;
-            stream = NULL;
-        } else if (!rt->start()) {
-            fprintf(stderr,"Failed to start RenderThread\n");
-            delete rt;
-            rt = NULL;
+        //
+        // tell the client whether its request for compression is
+        // accepted, the data which follows the answer is compressed
+        //
+        if ((clientFlags & IOSTREAM_CLIENT_COMPRESS) != 0) {
+            unsigned int accepted = stream->canCompress() ?
+                                    IOSTREAM_CLIENT_COMPRESS : 0;
+            if (stream->writeFully(&accepted, sizeof(accepted)) < 0 ||
+                (accepted && !stream->enableCompression())) {
+                fprintf(stderr,"Error negotiating stream compression\n");
+                delete stream;
+                continue;
+            }
         }
 
+        RenderThread *rt = NULL;
+        if (!pool.empty()) {
+            rt = pool.back();
+            pool.pop_back();
+            rt->setStream(stream);
+        } else {
+            rt = RenderThread::create(stream);
+            if (!rt) {
+                fprintf(stderr,"Failed to create RenderThread\n");
+                delete stream;
+                stream = NULL;
+            } else if (!rt->start()) {
+                fprintf(stderr,"Failed to start RenderThread\n");
+                delete rt;
+                rt = NULL;
+            }
+        }
+
+        // the new connection is being served, get ready for the next one
+        fillPool(pool);
+
         //
         // remove from the threads list threads which are
         // no longer running
@@ -140,8 +197,16 @@ int RenderServer::Main()
     }
 
     //
-    // Wait for all threads to finish
+    // release the idle threads, then wait for all threads to finish
     //
+    for (size_t i = 0; i < pool.size(); i++) {
+        int exitStatus;
+        pool[i]->setStream(NULL);
+        pool[i]->wait(&exitStatus);
+        delete pool[i];
+    }
+    pool.clear();
+
     for (RenderThreadsSet::iterator t = threads.begin();
          t != threads.end();
          t++) {
@@ -22,13 +22,49 @@
 #include "GL2Dispatch.h"
 #include "EGLDispatch.h"
 #include "FrameBuffer.h"
+#include "RenderMetrics.h"
+#include "renderer_dispatch.h"
 
-#define STREAM_BUFFER_SIZE 4*1024*1024
+// base size of the read buffer, it grows to fit larger packets
+// and shrinks back to this size after bursts.
+#define STREAM_BUFFER_SIZE 512*1024
+
+// the decoders leave their replies in the stream, which is flushed once
+// all received commands are decoded or when this many bytes are pending.
+#define REPLY_FLUSH_THRESHOLD 64*1024
+
+//
+// The decoder tables are resolved once, through the dispatch tables the
+// translator libraries were loaded into, and copied by every new thread.
+//
+static android::Mutex s_decoderLock;
+static GLDecoder *s_glDecTemplate = NULL;
+static GL2Decoder *s_gl2DecTemplate = NULL;
+
+static void initDecoders(RenderThreadInfo *tInfo)
+{
+    {
+        android::Mutex::Autolock _lock(s_decoderLock);
+        if (!s_glDecTemplate) {
+            s_glDecTemplate = new GLDecoder();
+            s_glDecTemplate->initGL( gl_dispatch_get_proc_func, NULL );
+            s_gl2DecTemplate = new GL2Decoder();
+            s_gl2DecTemplate->initGL( gl2_dispatch_get_proc_func, NULL );
+            FrameBuffer *fb = FrameBuffer::getFB();
+            if (fb && fb->useFboSurfaces()) {
+                WindowSurface::installFboHooks(s_glDecTemplate, s_gl2DecTemplate);
+            }
+        }
+    }
+    tInfo->m_glDec.initGLFrom(*s_glDecTemplate);
+    tInfo->m_gl2Dec.initGLFrom(*s_gl2DecTemplate);
+}
 
 RenderThread::RenderThread() :
     osUtils::Thread(),
     m_stream(NULL),
-    m_finished(false)
+    m_finished(false),
+    m_streamSet(false)
 {
 }
 
@@ -45,10 +81,28 @@ RenderThread *RenderThread::create(IOStream *p_stream)
     }
 
     rt->m_stream = p_stream;
+    rt->m_streamSet = (p_stream != NULL);
 
     return rt;
 }
 
+void RenderThread::setStream(IOStream *p_stream)
+{
+    android::Mutex::Autolock _lock(m_lock);
+    m_stream = p_stream;
+    m_streamSet = true;
+    m_streamCond.signal();
+}
+
+IOStream *RenderThread::waitForStream()
+{
+    android::Mutex::Autolock _lock(m_lock);
+    while (!m_streamSet) {
+        m_streamCond.wait(m_lock);
+    }
+    return m_stream;
+}
+
 int RenderThread::Main()
 {
     RenderThreadInfo tInfo;
@@ -56,20 +110,40 @@ int RenderThread::Main()
     //
     // initialize decoders
     //
-    tInfo.m_glDec.initGL( gl_dispatch_get_proc_func, NULL );
-    tInfo.m_gl2Dec.initGL( gl2_dispatch_get_proc_func, NULL );
+    initDecoders(&tInfo);
     initRenderControlContext( &m_rcDec );
 
+    //
+    // route each packet to its decoder by opcode
+    //
+    renderer_dispatch_t dispatch;
+    dispatch.m_gl = &tInfo.m_glDec;
+    dispatch.m_gl2 = &tInfo.m_gl2Dec;
+    dispatch.m_renderControl = &m_rcDec;
+    dispatch.m_replyFlushSize = REPLY_FLUSH_THRESHOLD;
+
+    //
+    // a pooled thread is ready to decode, wait for its connection
+    //
+    if (!waitForStream()) {
+        m_finished = true;
+        return 0;
+    }
+
     ReadBuffer readBuf(m_stream, STREAM_BUFFER_SIZE);
 
-    int stats_totalBytes = 0;
-    long long stats_t0 = GetCurrentTimeMS();
+    // registered the first time data arrives while metrics are enabled
+    StreamMetrics *metrics = NULL;
 
     //
-    // open dump file if RENDER_DUMP_DIR is defined
+    // open dump file if RENDER_DUMP_DIR is defined, along with a text file
+    // listing the arrival time in microseconds and the size of each chunk
+    // of data, which renderer_replay uses to reproduce the original pacing.
+    // Times are from the monotonic clock, so the streams can be aligned.
     //
     const char *dump_dir = getenv("RENDERER_DUMP_DIR");
     FILE *dumpFP = NULL;
+    FILE *timesFP = NULL;
     if (dump_dir) {
         size_t bsize = strlen(dump_dir) + 32;
         char *fname = new char[bsize];
@@ -78,6 +152,8 @@ int RenderThread::Main()
         if (!dumpFP) {
             fprintf(stderr,"Warning: stream dump failed to open file %s\n",fname);
         }
+        snprintf(fname,bsize,"%s/stream_%p.times", dump_dir, this);
+        timesFP = dumpFP ? fopen(fname, "w") : NULL;
         delete [] fname;
     }
 
@@ -88,16 +164,8 @@ int RenderThread::Main()
             break;
         }
 
-        //
-        // log received bandwidth statistics
-        //
-        stats_totalBytes += readBuf.validData();
-        long long dt = GetCurrentTimeMS() - stats_t0;
-        if (dt > 1000) {
-            float dts = (float)dt / 1000.0f;
-            //printf("Used Bandwidth %5.3f MB/s\n", ((float)stats_totalBytes / dts) / (1024.0f*1024.0f));
-            stats_totalBytes = 0;
-            stats_t0 = GetCurrentTimeMS();
+        if (!metrics && RenderMetrics::enabled()) {
+            metrics = RenderMetrics::openStream();
         }
 
         //
@@ -107,47 +175,47 @@ int RenderThread::Main()
             int skip = readBuf.validData() - stat;
             fwrite(readBuf.buf()+skip, 1, readBuf.validData()-skip, dumpFP);
             fflush(dumpFP);
-        }
-
-        bool progress;
-        do {
-            progress = false;
-
-            //
-            // try to process some of the command buffer using the GLESv1 decoder
-            //
-            size_t last = tInfo.m_glDec.decode(readBuf.buf(), readBuf.validData(), m_stream);
-            if (last > 0) {
-                progress = true;
-                readBuf.consume(last);
-            }
-
-            //
-            // try to process some of the command buffer using the GLESv2 decoder
-            //
-            last = tInfo.m_gl2Dec.decode(readBuf.buf(), readBuf.validData(), m_stream);
-            if (last > 0) {
-                progress = true;
-                readBuf.consume(last);
-            }
-
-            //
-            // try to process some of the command buffer using the
-            // renderControl decoder
-            //
-            last = m_rcDec.decode(readBuf.buf(), readBuf.validData(), m_stream);
-            if (last > 0) {
-                readBuf.consume(last);
-                progress = true;
+            if (timesFP) {
+                fprintf(timesFP, "%lld %d\n", GetCurrentTimeUS(), stat);
             }
+        }
 
-        } while( progress );
+        //
+        // decode all complete packets, the dispatcher hands each run of
+        // consecutive packets to the GLESv1, GLESv2 or renderControl
+        // decoder owning their opcodes.
+        //
+        size_t last;
+        if (metrics && RenderMetrics::enabled()) {
+            metrics->addReceived(stat);
+            last = decodeWithMetrics(&dispatch, readBuf.buf(),
+                                     readBuf.validData(), metrics);
+            RenderMetrics::dumpIfDue();
+        }
+        else {
+            last = dispatch.decode(readBuf.buf(), readBuf.validData(), m_stream);
+        }
+        if (last > 0) {
+            readBuf.consume(last);
+        }
 
+        //
+        // nothing more can be decoded before reading from the stream,
+        // send the replies which are still pending
+        //
+        if (m_stream->flush() < 0) {
+            break;
+        }
     }
 
     if (dumpFP) {
         fclose(dumpFP);
     }
+    if (timesFP) {
+        fclose(timesFP);
+    }
+
+    RenderMetrics::closeStream(metrics);
 
     //
     // Release references to the current thread's context/surfaces if any
@@ -163,3 +231,46 @@ int RenderThread::Main()
 
     return 0;
 }
+
+//
+// decodeWithMetrics - same as renderer_dispatch_t::decode but hands the
+// packets to the dispatcher one at a time, to account each of them to
+// its opcode.
+//
+size_t RenderThread::decodeWithMetrics(renderer_dispatch_t *dispatch,
+                                       unsigned char *buf, size_t len,
+                                       StreamMetrics *metrics)
+{
+    // flush here rather than in the dispatcher, after the reply is counted
+    size_t flushSize = dispatch->m_replyFlushSize;
+    dispatch->m_replyFlushSize = 0;
+
+    size_t pos = 0;
+    while (len - pos >= 8) {
+        uint32_t opcode = *(uint32_t *)(buf + pos);
+        uint32_t packetLen = *(uint32_t *)(buf + pos + 4);
+        if (len - pos < packetLen) {
+            break;
+        }
+
+        size_t pending = m_stream->pending();
+        long long t0 = GetCurrentTimeUS();
+        size_t last = dispatch->decode(buf + pos, packetLen, m_stream);
+        long long t1 = GetCurrentTimeUS();
+        if (last == 0) {
+            break; // unknown opcode
+        }
+
+        size_t reply = m_stream->pending();
+        reply = reply > pending ? reply - pending : 0;
+        metrics->addPacket(opcode, last, reply, (unsigned int)(t1 - t0));
+        pos += last;
+
+        if (flushSize && m_stream->pending() >= flushSize) {
+            m_stream->flush();
+        }
+    }
+
+    dispatch->m_replyFlushSize = flushSize;
+    return pos;
+}
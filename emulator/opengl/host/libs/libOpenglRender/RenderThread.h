@@ -20,22 +20,39 @@
 #include "GLDecoder.h"
 #include "renderControl_dec.h"
 #include "osThread.h"
+#include <utils/threads.h>
+
+class StreamMetrics;
+struct renderer_dispatch_t;
 
 class RenderThread : public osUtils::Thread
 {
 public:
+    //
+    // A thread created without a stream prepares its decoders once
+    // started and waits for setStream(), which hands it the stream to
+    // serve or, with NULL, makes it exit.
+    //
     static RenderThread *create(IOStream *p_stream);
     virtual ~RenderThread();
     bool isFinished() const { return m_finished; }
+    void setStream(IOStream *p_stream);
 
 private:
     RenderThread();
     virtual int Main();
+    IOStream *waitForStream();
+    size_t decodeWithMetrics(renderer_dispatch_t *dispatch,
+                             unsigned char *buf, size_t len,
+                             StreamMetrics *metrics);
 
 private:
     IOStream *m_stream;
     renderControl_decoder_context_t m_rcDec;
     bool m_finished;
+    bool m_streamSet;
+    android::Mutex m_lock;
+    android::Condition m_streamCond;
 };
 
 #endif
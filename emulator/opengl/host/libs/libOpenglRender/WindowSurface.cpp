@@ -20,6 +20,8 @@
 #include "EGLDispatch.h"
 #include "GLDispatch.h"
 #include "GL2Dispatch.h"
+#include "ThreadInfo.h"
+#include "ErrorLog.h"
 #include <stdio.h>
 #include <string.h>
 #include "GLErrorLog.h"
@@ -35,7 +37,8 @@ WindowSurface::WindowSurface() :
     m_width(0),
     m_height(0),
     m_pbufWidth(0),
-    m_pbufHeight(0)
+    m_pbufHeight(0),
+    m_useFbo(false)
 {
 }
 
@@ -65,7 +68,9 @@ WindowSurface *WindowSurface::create(int p_config, int p_width, int p_height)
     // Create a pbuffer to be used as the egl surface
     // for that window.
     //
-    if (!win->resizePbuffer(p_width, p_height)) {
+    win->m_useFbo = fb->useFboSurfaces();
+    if (!win->resizePbuffer(win->m_useFbo ? 1 : p_width,
+                            win->m_useFbo ? 1 : p_height)) {
         delete win;
         return NULL;
     }
@@ -83,10 +88,31 @@ WindowSurface *WindowSurface::create(int p_config, int p_width, int p_height)
 //
 bool WindowSurface::flushColorBuffer()
 {
-    if (m_attachedColorBuffer.Ptr() != NULL) {
+    if (m_attachedColorBuffer.Ptr() == NULL) {
+        return true;
+    }
+    if (!m_useFbo) {
         return blitToColorBuffer();
     }
-    return true;
+
+    //
+    // the drawing must reach the blit image before the FrameBuffer
+    // context reads it, a context no longer current was flushed when
+    // it was unbound
+    //
+    RenderThreadInfo *tInfo = RenderThreadInfo::get();
+    if (m_drawContext.Ptr() && tInfo->currContext.Ptr() == m_drawContext.Ptr()) {
+#ifdef WITH_GLES2
+        if (m_drawContext->isGL2()) {
+            s_gl2.glFlush();
+        }
+        else
+#endif
+        {
+            s_gl.glFlush();
+        }
+    }
+    return m_attachedColorBuffer->blitFromBlitImage();
 }
 
 //
@@ -98,6 +124,17 @@ void WindowSurface::setColorBuffer(ColorBufferPtr p_colorBuffer)
 {
     m_attachedColorBuffer = p_colorBuffer;
 
+    //
+    // a surface drawn through a framebuffer object only needs to attach
+    // the new color buffer, now if it is bound in this thread
+    //
+    if (m_useFbo) {
+        RenderThreadInfo *tInfo = RenderThreadInfo::get();
+        if (tInfo->currDrawSurf.Ptr() == this && m_drawContext.Ptr()) {
+            attachFbo(m_drawContext);
+        }
+    }
+
     //
     // resize the window if the attached color buffer is of different
     // size
@@ -107,7 +144,7 @@ void WindowSurface::setColorBuffer(ColorBufferPtr p_colorBuffer)
 
     if (cbWidth != m_width || cbHeight != m_height) {
 
-        if (m_pbufWidth && m_pbufHeight) {
+        if (!m_useFbo && m_pbufWidth && m_pbufHeight) {
             // if we use pbuffer, need to resize it
             resizePbuffer(cbWidth, cbHeight);
         }
@@ -117,6 +154,32 @@ void WindowSurface::setColorBuffer(ColorBufferPtr p_colorBuffer)
     }
 }
 
+//
+// setDefaultFramebuffer - bind 'p_fbo' in the current context, unless a
+// framebuffer object of the guest is bound there
+//
+static void setDefaultFramebuffer(RenderContext *p_ctx, GLuint p_fbo)
+{
+    GLuint surfaceFbo = p_ctx->getSurfaceFbo();
+    if (!surfaceFbo) {
+        return;
+    }
+    GLint cur;
+#ifdef WITH_GLES2
+    if (p_ctx->isGL2()) {
+        s_gl2.glGetIntegerv(GL_FRAMEBUFFER_BINDING, &cur);
+        if (cur == 0 || (GLuint)cur == surfaceFbo) {
+            s_gl2.glBindFramebuffer(GL_FRAMEBUFFER, p_fbo);
+        }
+        return;
+    }
+#endif
+    s_gl.glGetIntegerv(GL_FRAMEBUFFER_BINDING_OES, &cur);
+    if (cur == 0 || (GLuint)cur == surfaceFbo) {
+        s_gl.glBindFramebufferOES(GL_FRAMEBUFFER_OES, p_fbo);
+    }
+}
+
 //
 // This function is called after the context and eglSurface is already
 // bound in the current thread (eglMakeCurrent has been called).
@@ -139,6 +202,104 @@ void WindowSurface::bind(RenderContextPtr p_ctx, SurfaceBindType p_bindType)
         return;  // bad param
     }
 
+    if (p_ctx.Ptr() && p_bindType != SURFACE_BIND_READ) {
+        if (m_useFbo) {
+            attachFbo(p_ctx);
+        }
+        else {
+            setDefaultFramebuffer(p_ctx.Ptr(), 0);
+        }
+    }
+}
+
+//
+// attachFbo - make the surface framebuffer object of the context, now
+// current, draw into the attached color buffer. If it cannot, the
+// surface goes back to a pbuffer of its size for good.
+//
+bool WindowSurface::attachFbo(RenderContextPtr p_ctx)
+{
+    if (!m_attachedColorBuffer.Ptr()) {
+        // nothing to draw to until a color buffer is set
+        return true;
+    }
+
+    ColorBuffer *cb = m_attachedColorBuffer.Ptr();
+    if (cb->getBlitEGLImage() &&
+        p_ctx->attachSurfaceImage(cb->getBlitEGLImage(),
+                                  cb->getWidth(), cb->getHeight(),
+                                  m_fbconf->getDepthSize(),
+                                  m_fbconf->getStencilSize())) {
+        setDefaultFramebuffer(p_ctx.Ptr(), p_ctx->getSurfaceFbo());
+        return true;
+    }
+
+    ERR("WindowSurface: framebuffer object failed, using a pbuffer\n");
+    m_useFbo = false;
+    setDefaultFramebuffer(p_ctx.Ptr(), 0);
+    resizePbuffer(cb->getWidth(), cb->getHeight());
+    return false;
+}
+
+//
+// The decoder hooks below map the default framebuffer to the surface
+// framebuffer object of the current context, while it draws to a
+// surface using one.
+//
+static GLuint currentSurfaceFbo()
+{
+    RenderThreadInfo *tInfo = RenderThreadInfo::get();
+    if (tInfo->currDrawSurf.Ptr() && tInfo->currDrawSurf->usesFbo() &&
+        tInfo->currContext.Ptr()) {
+        return tInfo->currContext->getSurfaceFbo();
+    }
+    return 0;
+}
+
+static void gl_APIENTRY s_glBindFramebufferOES(GLenum target, GLuint framebuffer)
+{
+    if (framebuffer == 0) {
+        framebuffer = currentSurfaceFbo();
+    }
+    s_gl.glBindFramebufferOES(target, framebuffer);
+}
+
+static void gl_APIENTRY s_glGetIntegerv(GLenum pname, GLint *params)
+{
+    s_gl.glGetIntegerv(pname, params);
+    if (pname == GL_FRAMEBUFFER_BINDING_OES && params && *params &&
+        (GLuint)*params == currentSurfaceFbo()) {
+        *params = 0;
+    }
+}
+
+#ifdef WITH_GLES2
+static void gl2_APIENTRY s_gl2BindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    if (framebuffer == 0) {
+        framebuffer = currentSurfaceFbo();
+    }
+    s_gl2.glBindFramebuffer(target, framebuffer);
+}
+
+static void gl2_APIENTRY s_gl2GetIntegerv(GLenum pname, GLint *params)
+{
+    s_gl2.glGetIntegerv(pname, params);
+    if (pname == GL_FRAMEBUFFER_BINDING && params && *params &&
+        (GLuint)*params == currentSurfaceFbo()) {
+        *params = 0;
+    }
+}
+#endif
+
+void WindowSurface::installFboHooks(GLDecoder *p_glDec, GL2Decoder *p_gl2Dec)
+{
+    p_glDec->set_glBindFramebufferOES(s_glBindFramebufferOES);
+    p_glDec->set_glGetIntegerv(s_glGetIntegerv);
+#ifdef WITH_GLES2
+    p_gl2Dec->set_glBindFramebuffer(s_gl2BindFramebuffer);
+    p_gl2Dec->set_glGetIntegerv(s_gl2GetIntegerv);
+#endif
 }
 
 bool WindowSurface::blitToColorBuffer()
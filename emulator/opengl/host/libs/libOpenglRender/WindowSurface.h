@@ -24,12 +24,25 @@
 #include <EGL/egl.h>
 #include <GLES/gl.h>
 
+class GLDecoder;
+class GL2Decoder;
+
 enum SurfaceBindType {
     SURFACE_BIND_READ,
     SURFACE_BIND_DRAW,
     SURFACE_BIND_READDRAW
 };
 
+//
+// WindowSurface - the EGL surface a guest window draws to. By default it
+// is a pbuffer of the window size, copied into the attached color buffer
+// on each flush. With FrameBuffer::useFboSurfaces(), the context draws
+// instead through a framebuffer object into the blit image of the color
+// buffer, and the flush only has to draw it upright into the color
+// buffer; the pbuffer is then 1x1, to make the context current with.
+// The decoders bind that framebuffer object in place of the default
+// framebuffer, see installFboHooks().
+//
 class WindowSurface
 {
 public:
@@ -40,9 +53,15 @@ public:
     void setColorBuffer(ColorBufferPtr p_colorBuffer);
     bool flushColorBuffer();
     void bind(RenderContextPtr p_ctx, SurfaceBindType p_bindType);
+    bool usesFbo() const { return m_useFbo; }
+
+    // make the decoders map the default framebuffer to the one of the
+    // current draw surface, once at initialization
+    static void installFboHooks(GLDecoder *p_glDec, GL2Decoder *p_gl2Dec);
 
 private:
     WindowSurface();
+    bool attachFbo(RenderContextPtr p_ctx);
 
     bool blitToColorBuffer();  // copy pbuffer content with texload and blit
     bool resizePbuffer(unsigned int p_width, unsigned int p_height);
@@ -59,6 +78,7 @@ private:
     GLuint m_height;
     GLuint m_pbufWidth;
     GLuint m_pbufHeight;
+    bool m_useFbo;
     bool m_useEGLImage;
     bool m_useBindToTexture;
     FixedBuffer m_xferBuffer;
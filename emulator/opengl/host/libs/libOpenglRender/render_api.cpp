@@ -17,6 +17,7 @@
 #include "IOStream.h"
 #include "FrameBuffer.h"
 #include "RenderServer.h"
+#include "RenderMetrics.h"
 #include "osProcess.h"
 #include "TimeUtils.h"
 
@@ -26,6 +27,9 @@
 #else
 #include "UnixStream.h"
 #endif
+#ifdef __linux__
+#include "ShmStream.h"
+#endif
 
 #include "EGLDispatch.h"
 #include "GLDispatch.h"
@@ -34,6 +38,7 @@
 static osUtils::childProcess *s_renderProc = NULL;
 static RenderServer *s_renderThread = NULL;
 static char s_renderAddr[256];
+static bool s_headless = false;
 
 static IOStream *createRenderThread(int p_stream_buffer_size,
                                     unsigned int clientFlags);
@@ -86,12 +91,21 @@ int initOpenGLRenderer(int width, int height, char* addr, size_t addrLen)
         return false;
     }
 
+    //
+    // RENDERER_METRICS=<dump period in ms> enables the metrics collection
+    //
+    const char *metrics = getenv("RENDERER_METRICS");
+    if (metrics) {
+        RenderMetrics::setEnabled(true, atoi(metrics));
+    }
+
 #ifdef RENDER_API_USE_THREAD  // should be defined for mac
     //
     // initialize the renderer and listen to connections
     // on a thread in the current process.
     //
-    bool inited = FrameBuffer::initialize(width, height);
+    bool inited = FrameBuffer::initialize(width, height,
+                                          s_headless || getenv("RENDERER_HEADLESS") != NULL);
     if (!inited) {
         return false;
     }
@@ -210,6 +224,55 @@ void setPostCallback(OnPostFn onPost, void* onPostContext)
 #endif
 }
 
+void setPostRegionCallback(OnPostRegionFn onPost, void* onPostContext)
+{
+#ifdef RENDER_API_USE_THREAD  // should be defined for mac
+    FrameBuffer* fb = FrameBuffer::getFB();
+    if (fb) {
+        fb->setPostRegionCallback(onPost, onPostContext);
+    }
+#endif
+}
+
+void setPostRate(int framesPerSecond)
+{
+    FrameBuffer* fb = FrameBuffer::getFB();
+    if (fb) {
+        fb->setPostRate(framesPerSecond);
+    }
+}
+
+void requestPostFrame(void)
+{
+    FrameBuffer* fb = FrameBuffer::getFB();
+    if (fb) {
+        fb->requestPost();
+    }
+}
+
+int setFrameExport(const char* name)
+{
+    FrameBuffer* fb = FrameBuffer::getFB();
+    if (!fb) {
+        return false;
+    }
+    return fb->setFrameExport(name);
+}
+
+void setRenderMetrics(int enable, int dumpPeriodMs)
+{
+    RenderMetrics::setEnabled(enable != 0, dumpPeriodMs);
+}
+
+int getRenderMetrics(RenderMetricsSnapshot* snapshot)
+{
+    if (!snapshot || !RenderMetrics::enabled()) {
+        return false;
+    }
+    RenderMetrics::snapshot(snapshot);
+    return true;
+}
+
 void getHardwareStrings(const char** vendor, const char** renderer, const char** version)
 {
     FrameBuffer* fb = FrameBuffer::getFB();
@@ -332,6 +395,10 @@ IOStream *createRenderThread(int p_stream_buffer_size, unsigned int clientFlags)
 
     if (gRendererStreamMode == STREAM_MODE_TCP) {
         stream = new TcpStream(p_stream_buffer_size);
+#ifdef __linux__
+    } else if (gRendererStreamMode == STREAM_MODE_SHM) {
+        stream = new ShmStream(p_stream_buffer_size);
+#endif
     } else {
 #ifdef _WIN32
         stream = new Win32PipeStream(p_stream_buffer_size);
@@ -350,6 +417,16 @@ IOStream *createRenderThread(int p_stream_buffer_size, unsigned int clientFlags)
         return NULL;
     }
 
+    //
+    // ask for a compressed stream over TCP when RENDERER_STREAM_COMPRESS
+    // is set, the renderer is ours and knows the flag
+    //
+    if (gRendererStreamMode == STREAM_MODE_TCP &&
+        (clientFlags & IOSTREAM_CLIENT_EXIT_SERVER) == 0 &&
+        getenv("RENDERER_STREAM_COMPRESS")) {
+        clientFlags |= IOSTREAM_CLIENT_COMPRESS;
+    }
+
     //
     // send clientFlags to the renderer
     //
@@ -358,6 +435,27 @@ IOStream *createRenderThread(int p_stream_buffer_size, unsigned int clientFlags)
     *pClientFlags = clientFlags;
     stream->commitBuffer(sizeof(unsigned int));
 
+    //
+    // the renderer answers a request for compression with the flags it
+    // accepts, both ends compress what follows if it did
+    //
+    if ((clientFlags & IOSTREAM_CLIENT_COMPRESS) != 0) {
+        unsigned int accepted = 0;
+        if (!stream->readFully(&accepted, sizeof(accepted))) {
+            ERR("createRenderThread failed to read the compression answer\n");
+            delete stream;
+            return NULL;
+        }
+        if ((accepted & IOSTREAM_CLIENT_COMPRESS) != 0 &&
+            !stream->enableCompression()) {
+            ERR("createRenderThread failed to enable compression\n");
+            delete stream;
+            return NULL;
+        }
+        DBG("createRenderThread: stream compression %s\n",
+            (accepted & IOSTREAM_CLIENT_COMPRESS) ? "enabled" : "refused");
+    }
+
     return stream;
 }
 
@@ -375,6 +473,10 @@ setStreamMode(int mode)
 #ifndef _WIN32
         case STREAM_MODE_UNIX:
             break;
+#ifdef __linux__
+        case STREAM_MODE_SHM:
+            break;
+#endif
 #else /* _WIN32 */
         case STREAM_MODE_PIPE:
             break;
@@ -386,3 +488,13 @@ setStreamMode(int mode)
     gRendererStreamMode = mode;
     return true;
 }
+
+int setHeadlessMode(int headless)
+{
+    if (s_renderProc || s_renderThread) {
+        // too late, the FrameBuffer exists
+        return false;
+    }
+    s_headless = headless != 0;
+    return true;
+}
@@ -13,6 +13,8 @@
 * See the License for the specific language governing permissions and
 * limitations under the License.
 */
+#ifndef __RENDER_CONTROL_TYPES_H
+#define __RENDER_CONTROL_TYPES_H
 
 #include <stdint.h>
 #include <EGL/egl.h>
@@ -26,3 +28,40 @@
 #define FB_FPS      5
 #define FB_MIN_SWAP_INTERVAL 6
 #define FB_MAX_SWAP_INTERVAL 7
+
+//
+// rcCompose - the guest posts a list of layers, drawn from the first to
+// the last into the display. 'buffer' is an array of rcComposeLayer and
+// 'bufferSize' its size in bytes. Rectangles are in pixels, with the
+// origin at the top left as in the guest's display.
+//
+
+// values for 'transform', as in the gralloc HAL: flips are applied
+// first, then the rotation by 90 degrees clockwise
+#define COMPOSE_TRANSFORM_FLIP_H    0x01
+#define COMPOSE_TRANSFORM_FLIP_V    0x02
+#define COMPOSE_TRANSFORM_ROT_90    0x04
+#define COMPOSE_TRANSFORM_ROT_180   0x03
+#define COMPOSE_TRANSFORM_ROT_270   0x07
+
+// values for 'blendMode'
+#define COMPOSE_BLEND_NONE          1   // opaque, the layer alpha is ignored
+#define COMPOSE_BLEND_PREMULTIPLIED 2
+#define COMPOSE_BLEND_COVERAGE      3
+
+typedef struct {
+    uint32_t colorBuffer;
+    int32_t  srcLeft;       // crop in the color buffer
+    int32_t  srcTop;
+    int32_t  srcRight;
+    int32_t  srcBottom;
+    int32_t  dstLeft;       // destination in the display
+    int32_t  dstTop;
+    int32_t  dstRight;
+    int32_t  dstBottom;
+    uint32_t transform;
+    uint32_t blendMode;
+    float    alpha;         // plane alpha, 0.0 to 1.0
+} rcComposeLayer;
+
+#endif
@@ -20,6 +20,7 @@
 #include "strUtils.h"
 #include <errno.h>
 #include <sys/types.h>
+#include <algorithm>
 
 /* Define this to 1 to enable support for the 'isLarge' variable flag
  * that instructs the encoder to send large data buffers by a direct
@@ -427,11 +428,20 @@ static void writeVarEncodingExpression(Var& var, FILE* fp)
 }
 
 #if WITH_LARGE_SUPPORT
-static void writeVarLargeEncodingExpression(Var& var, FILE* fp)
+static void writeVarLargeEncodingExpression(Var& var, FILE* fp, bool byRef)
 {
     const char* varname = var.name().c_str();
 
-    fprintf(fp, "\tstream->writeFully(&__size_%s,4);\n", varname);
+    if (byRef && var.writeExpression() != "") {
+        // custom writers go straight to the stream, commit what is queued
+        fprintf(fp, "\tstream->flush();\n");
+    }
+    if (byRef && var.writeExpression() == "") {
+        fprintf(fp, "\tptr = stream->alloc(4);\n");
+        fprintf(fp, "\tmemcpy(ptr, &__size_%s, 4);\n", varname);
+    } else {
+        fprintf(fp, "\tstream->writeFully(&__size_%s,4);\n", varname);
+    }
     if (var.nullAllowed()) {
         fprintf(fp, "\tif (%s != NULL) ", varname);
     } else {
@@ -439,6 +449,9 @@ static void writeVarLargeEncodingExpression(Var& var, FILE* fp)
     }
     if (var.writeExpression() != "") {
         fprintf(fp, "%s", var.writeExpression().c_str());
+    } else if (byRef) {
+        // queued by reference and sent together with the packet header
+        fprintf(fp, "stream->allocRef(%s, __size_%s)", varname, varname);
     } else {
         fprintf(fp, "stream->writeFully(%s, __size_%s)", varname, varname);
     }
@@ -505,12 +518,16 @@ int ApiGen::genEncoderImpl(const std::string &filename)
 #if WITH_LARGE_SUPPORT
         // We need to take care of 'isLarge' variable in a special way
         // Anything before an isLarge variable can be packed into a single
-        // buffer, which is then commited. Each isLarge variable is a pointer
-        // to data that can be written to directly through the pipe, which
-        // will be instant when using a QEMU pipe
+        // buffer. Each isLarge variable is a pointer to data that is either
+        // written directly through the stream once the buffer is commited,
+        // or, with -R, queued by reference with allocRef(), so the stream
+        // can send it together with the surrounding fragments without
+        // copying it. Since the data is owned by the caller, the stream is
+        // then flushed before returning.
 
         size_t  nvars   = 0;
         size_t  npointers = 0;
+        bool    hasLarge = false;
 
         // First, compute the total size, 8 bytes for the opcode + payload size
         fprintf(fp, "\t unsigned char *ptr;\n");
@@ -584,20 +601,26 @@ int ApiGen::genEncoderImpl(const std::string &filename)
                 }
 
                 // Ensure the fragment is commited if it is followed by a large variable
-                if (j < maxvars) {
+                if (j < maxvars && !m_largeByRef) {
                     fprintf(fp, "\tstream->flush();\n");
                 }
             }
 
-            // If we have one or more large variables, write them directly.
-            // As size + data
+            // If we have one or more large variables, write them directly
+            // or queue them by reference. As size + data
             for ( ; j < maxvars && evars[j].isLarge(); j++) {
-                writeVarLargeEncodingExpression(evars[j], fp);
+                writeVarLargeEncodingExpression(evars[j], fp, m_largeByRef);
+                hasLarge = true;
             }
 
             nvars = j;
         }
 
+        // large variables are caller-owned, send them before returning
+        if (hasLarge && m_largeByRef) {
+            fprintf(fp, "\tstream->flush();\n");
+        }
+
 #else /* !WITH_LARGE_SUPPORT */
         size_t nvars = evars.size();
         size_t npointers = 0;
@@ -744,6 +767,45 @@ int ApiGen::genContextImpl(const std::string &filename, SideType side)
     return 0;
 }
 
+// Host types whose size may differ from their size on the wire, e.g.
+// GLintptr is 32-bit in the protocol but pointer-sized on 64-bit hosts.
+static bool hasHostDependentSize(const VarType *type)
+{
+    const std::string &name = type->name();
+    return name == "GLintptr" || name == "GLsizeiptr" || name == "GLeglImageOES";
+}
+
+// true if all arguments of 'e' are values of a fixed size, which the
+// table backend reads through a packed struct view of the packet.
+static bool hasFixedSizeArgs(EntryPoint *e)
+{
+    size_t nargs = 0;
+    VarsArray &evars = e->vars();
+    for (size_t j = 0; j < evars.size(); j++) {
+        if (evars[j].isVoid()) {
+            continue;
+        }
+        if (evars[j].isPointer() || hasHostDependentSize(evars[j].type())) {
+            return false;
+        }
+        nargs++;
+    }
+    return nargs > 0;
+}
+
+// offset expression of the table backend, 'base' is a local variable
+// holding the end of the last variable-size argument, if any.
+static std::string foldOffset(const std::string &base, size_t offset)
+{
+    if (base.size() == 0) {
+        return toString(offset);
+    }
+    if (offset == 0) {
+        return base;
+    }
+    return base + " + " + toString(offset);
+}
+
 int ApiGen::genDecoderImpl(const std::string &filename)
 {
     FILE *fp = fopen(filename.c_str(), "wt");
@@ -764,6 +826,39 @@ int ApiGen::genDecoderImpl(const std::string &filename)
     fprintf(fp, "#include <stdio.h>\n\n");
     fprintf(fp, "typedef unsigned int tsize_t; // Target \"size_t\", which is 32-bit for now. It may or may not be the same as host's size_t when emugen is compiled.\n\n");
 
+    bool table = (m_decoderBackend == DECODER_TABLE);
+    if (table) {
+        // dispatch through a table of label addresses where the compiler
+        // supports it, each command then ends with its own indirect jump.
+        fprintf(fp, "#if defined(__GNUC__) && !defined(EMUGL_DECODER_USE_SWITCH)\n");
+        fprintf(fp, "#define DECODER_COMPUTED_GOTO 1\n");
+        fprintf(fp, "#define DECODER_LABEL(name) op_##name:\n");
+        fprintf(fp, "#else\n");
+        fprintf(fp, "#define DECODER_LABEL(name)\n");
+        fprintf(fp, "#endif\n\n");
+
+        // packed views of the commands made of fixed-size arguments only
+        fprintf(fp, "namespace {\n\n");
+        fprintf(fp, "#pragma pack(push, 1)\n");
+        for (size_t f = 0; f < n; f++) {
+            EntryPoint *e = &at(f);
+            if (!hasFixedSizeArgs(e)) {
+                continue;
+            }
+            fprintf(fp, "struct %s_args {\n", e->name().c_str());
+            VarsArray &evars = e->vars();
+            for (size_t j = 0; j < evars.size(); j++) {
+                if (!evars[j].isVoid()) {
+                    fprintf(fp, "\t%s %s;\n", evars[j].type()->name().c_str(),
+                            evars[j].name().c_str());
+                }
+            }
+            fprintf(fp, "};\n");
+        }
+        fprintf(fp, "#pragma pack(pop)\n\n");
+        fprintf(fp, "} // namespace\n\n");
+    }
+
     // decoder switch;
     fprintf(fp, "size_t %s::decode(void *buf, size_t len, IOStream *stream)\n{\n", classname.c_str());
     fprintf(fp,
@@ -779,10 +874,25 @@ int ApiGen::genDecoderImpl(const std::string &filename)
 \t\tvoid *params[%u]; \n\
 \t\tint opcode = *(int *)ptr;   \n\
 \t\tunsigned int packetLen = *(int *)(ptr + 4);\n\
-\t\tif (len - pos < packetLen)  return pos; \n\
-\t\tswitch(opcode) {\n",
+\t\tif (len - pos < packetLen)  return pos; \n",
             (uint) m_maxEntryPointsParams);
 
+    if (table) {
+        fprintf(fp, "#ifdef DECODER_COMPUTED_GOTO\n");
+        fprintf(fp, "\t\tstatic const void *s_dispatch[] = {\n");
+        for (size_t f = 0; f < n; f++) {
+            fprintf(fp, "\t\t\t&&op_%s,\n", at(f).name().c_str());
+        }
+        fprintf(fp, "\t\t};\n");
+        fprintf(fp, "\t\tif ((unsigned int)(opcode - %d) >= %u) {\n", m_baseOpcode, (uint)n);
+        fprintf(fp, "\t\t\tunknownOpcode = true;\n");
+        fprintf(fp, "\t\t\tcontinue;\n");
+        fprintf(fp, "\t\t}\n");
+        fprintf(fp, "\t\tgoto *s_dispatch[opcode - %d];\n", m_baseOpcode);
+        fprintf(fp, "#endif\n");
+    }
+    fprintf(fp, "\t\tswitch(opcode) {\n");
+
     for (size_t f = 0; f < n; f++) {
         enum Pass_t { PASS_TmpBuffAlloc = 0, PASS_MemAlloc, PASS_DebugPrint, PASS_FunctionCall, PASS_Epilog, PASS_LAST };
         EntryPoint *e = &at(f);
@@ -797,8 +907,17 @@ int ApiGen::genDecoderImpl(const std::string &filename)
         // TODO - add for return value;
 
         fprintf(fp, "\t\t\tcase OP_%s:\n", e->name().c_str());
+        if (table) {
+            fprintf(fp, "\t\t\tDECODER_LABEL(%s)\n", e->name().c_str());
+        }
         fprintf(fp, "\t\t\t{\n");
 
+        bool useView = table && hasFixedSizeArgs(e);
+        if (useView) {
+            fprintf(fp, "\t\t\tconst %s_args *args = (const %s_args *)(ptr + 8);\n",
+                    e->name().c_str(), e->name().c_str());
+        }
+
         bool totalTmpBuffExist = false;
         std::string totalTmpBuffOffset = "0";
         std::string *tmpBufOffset = new std::string[e->vars().size()];
@@ -828,6 +947,10 @@ int ApiGen::genDecoderImpl(const std::string &filename)
             }
 
             std::string varoffset = "8"; // skip the header
+            // the table backend folds constant offsets at generation time
+            // and keeps the end of variable-size arguments in locals.
+            std::string offBase = "";
+            size_t offConst = 8;
             VarsArray & evars = e->vars();
             // allocate memory for out pointers;
             for (size_t j = 0; j < evars.size(); j++) {
@@ -838,31 +961,61 @@ int ApiGen::genDecoderImpl(const std::string &filename)
 
                     if (!v->isPointer()) {
                         if (pass == PASS_FunctionCall || pass == PASS_DebugPrint) {
-                            fprintf(fp, "*(%s *)(ptr + %s)", v->type()->name().c_str(), varoffset.c_str());
+                            if (useView) {
+                                fprintf(fp, "args->%s", v->name().c_str());
+                            } else {
+                                fprintf(fp, "*(%s *)(ptr + %s)", v->type()->name().c_str(), varoffset.c_str());
+                            }
+                        }
+                        if (table) {
+                            offConst += v->type()->bytes();
+                            varoffset = foldOffset(offBase, offConst);
+                        } else {
+                            varoffset += " + " + toString(v->type()->bytes());
                         }
-                        varoffset += " + " + toString(v->type()->bytes());
                     } else {
                         if (v->pointerDir() == Var::POINTER_IN || v->pointerDir() == Var::POINTER_INOUT) {
+                            // the data follows its 4 bytes size
+                            std::string dataoffset = table ? foldOffset(offBase, offConst + 4) :
+                                                             varoffset + " + 4";
                             if (pass == PASS_MemAlloc && v->pointerDir() == Var::POINTER_INOUT) {
                                 fprintf(fp, "\t\t\tsize_t tmpPtr%uSize = (size_t)*(unsigned int *)(ptr + %s);\n",
                                         (uint) j, varoffset.c_str());
-                                fprintf(fp, "unsigned char *tmpPtr%u = (ptr + %s + 4);\n",
-                                        (uint) j, varoffset.c_str());
+                                fprintf(fp, "unsigned char *tmpPtr%u = (ptr + %s);\n",
+                                        (uint) j, dataoffset.c_str());
                             }
                             if (pass == PASS_FunctionCall) {
                                 if (v->nullAllowed()) {
-                                    fprintf(fp, "*((unsigned int *)(ptr + %s)) == 0 ? NULL : (%s)(ptr + %s + 4)",
-                                            varoffset.c_str(), v->type()->name().c_str(), varoffset.c_str());
+                                    fprintf(fp, "*((unsigned int *)(ptr + %s)) == 0 ? NULL : (%s)(ptr + %s)",
+                                            varoffset.c_str(), v->type()->name().c_str(), dataoffset.c_str());
                                 } else {
-                                    fprintf(fp, "(%s)(ptr + %s + 4)",
-                                            v->type()->name().c_str(), varoffset.c_str());
+                                    fprintf(fp, "(%s)(ptr + %s)",
+                                            v->type()->name().c_str(), dataoffset.c_str());
                                 }
                             } else if (pass == PASS_DebugPrint) {
-                                fprintf(fp, "(%s)(ptr + %s + 4), *(unsigned int *)(ptr + %s)",
-                                        v->type()->name().c_str(), varoffset.c_str(),
+                                fprintf(fp, "(%s)(ptr + %s), *(unsigned int *)(ptr + %s)",
+                                        v->type()->name().c_str(), dataoffset.c_str(),
                                         varoffset.c_str());
                             }
-                            varoffset += " + 4 + *(tsize_t *)(ptr +" + varoffset + ")";
+                            if (table) {
+                                char endName[32];
+                                sprintf(endName, "inPtr%uEnd", (uint) j);
+                                bool usedLater = false;
+                                for (size_t k = j + 1; k < evars.size(); k++) {
+                                    usedLater = usedLater || !evars[k].isVoid();
+                                }
+                                if (usedLater) {
+                                    if (pass == PASS_TmpBuffAlloc) {
+                                        fprintf(fp, "\t\t\tsize_t %s = %s + 4 + *(tsize_t *)(ptr + %s);\n",
+                                                endName, varoffset.c_str(), varoffset.c_str());
+                                    }
+                                    offBase = endName;
+                                    offConst = 0;
+                                    varoffset = endName;
+                                }
+                            } else {
+                                varoffset += " + 4 + *(tsize_t *)(ptr +" + varoffset + ")";
+                            }
                         } else { // out pointer;
                             if (pass == PASS_TmpBuffAlloc) {
                                 fprintf(fp, "\t\t\tsize_t tmpPtr%uSize = (size_t)*(unsigned int *)(ptr + %s);\n",
@@ -892,7 +1045,12 @@ int ApiGen::genDecoderImpl(const std::string &filename)
                                         v->type()->name().c_str(), (uint) j,
                                         varoffset.c_str());
                             }
-                            varoffset += " + 4";
+                            if (table) {
+                                offConst += 4;
+                                varoffset = foldOffset(offBase, offConst);
+                            } else {
+                                varoffset += " + 4";
+                            }
                         }
                     }
                 }
@@ -916,13 +1074,19 @@ int ApiGen::genDecoderImpl(const std::string &filename)
             }
 
             if (pass == PASS_Epilog) {
-                // send back out pointers data as well as retval
-                if (totalTmpBuffExist) {
+                // send back out pointers data as well as retval, unless
+                // the caller collects replies and flushes them itself
+                if (totalTmpBuffExist && !m_deferReplyFlush) {
                     fprintf(fp, "\t\t\tstream->flush();\n");
                 }
 
-                fprintf(fp, "\t\t\tpos += *(int *)(ptr + 4);\n");
-                fprintf(fp, "\t\t\tptr += *(int *)(ptr + 4);\n");
+                if (table) {
+                    fprintf(fp, "\t\t\tpos += packetLen;\n");
+                    fprintf(fp, "\t\t\tptr += packetLen;\n");
+                } else {
+                    fprintf(fp, "\t\t\tpos += *(int *)(ptr + 4);\n");
+                    fprintf(fp, "\t\t\tptr += *(int *)(ptr + 4);\n");
+                }
             }
 
         } // pass;
@@ -1080,3 +1244,106 @@ int ApiGen::setGlobalAttribute(const std::string & line, size_t lc)
     return 0;
 }
 
+
+static bool compareBaseOpcode(ApiGen *a, ApiGen *b)
+{
+    return a->baseOpcode() < b->baseOpcode();
+}
+
+int ApiGen::genDispatcherHeader(const std::string &filename,
+                                const std::string &name, ApiVec &apis)
+{
+    FILE *fp = fopen(filename.c_str(), "wt");
+    if (fp == NULL) {
+        perror(filename.c_str());
+        return -1;
+    }
+
+    std::string classname = name + "_dispatch_t";
+
+    apis[0]->printHeader(fp);
+    fprintf(fp, "\n#ifndef GUARD_%s\n", classname.c_str());
+    fprintf(fp, "#define GUARD_%s\n\n", classname.c_str());
+    fprintf(fp, "#include \"IOStream.h\"\n");
+    for (size_t i = 0; i < apis.size(); i++) {
+        fprintf(fp, "#include \"%s_dec.h\"\n", apis[i]->m_basename.c_str());
+    }
+    fprintf(fp, "\n\n");
+
+    fprintf(fp, "struct %s {\n\n", classname.c_str());
+    for (size_t i = 0; i < apis.size(); i++) {
+        const char *basename = apis[i]->m_basename.c_str();
+        fprintf(fp, "\t%s_decoder_context_t *m_%s;\n", basename, basename);
+    }
+    fprintf(fp, "\n\t%s() ", classname.c_str());
+    for (size_t i = 0; i < apis.size(); i++) {
+        fprintf(fp, "%s m_%s(NULL)", i == 0 ? ":" : ",", apis[i]->m_basename.c_str());
+    }
+    fprintf(fp, ", m_replyFlushSize(0) {}\n");
+    fprintf(fp, "\tsize_t decode(void *buf, size_t bufsize, IOStream *stream);\n\n");
+    fprintf(fp, "\t// when non-zero, flush the stream between decoder runs once that\n");
+    fprintf(fp, "\t// many reply bytes are pending (for decoders generated with -F)\n");
+    fprintf(fp, "\tsize_t m_replyFlushSize;\n");
+    fprintf(fp, "};\n\n#endif\n");
+
+    fclose(fp);
+    return 0;
+}
+
+int ApiGen::genDispatcherImpl(const std::string &filename,
+                              const std::string &name, ApiVec &apis)
+{
+    ApiVec sorted(apis);
+    std::sort(sorted.begin(), sorted.end(), compareBaseOpcode);
+    for (size_t i = 1; i < sorted.size(); i++) {
+        if (sorted[i - 1]->baseOpcode() + (int)sorted[i - 1]->size() > sorted[i]->baseOpcode()) {
+            fprintf(stderr, "ERROR: opcode ranges of %s and %s overlap\n",
+                    sorted[i - 1]->m_basename.c_str(), sorted[i]->m_basename.c_str());
+            return -1;
+        }
+    }
+
+    FILE *fp = fopen(filename.c_str(), "wt");
+    if (fp == NULL) {
+        perror(filename.c_str());
+        return -1;
+    }
+
+    std::string classname = name + "_dispatch_t";
+
+    apis[0]->printHeader(fp);
+    fprintf(fp, "\n\n#include \"%s_dispatch.h\"\n\n", name.c_str());
+
+    // each decoder consumes the run of consecutive packets that belong
+    // to it, so a packet is only ever looked at by the decoder owning it.
+    fprintf(fp, "size_t %s::decode(void *buf, size_t len, IOStream *stream)\n{\n", classname.c_str());
+    fprintf(fp, "\tsize_t pos = 0;\n");
+    fprintf(fp, "\tunsigned char *ptr = (unsigned char *)buf;\n");
+    fprintf(fp, "\twhile (len - pos >= 8) {\n");
+    fprintf(fp, "\t\tint opcode = *(int *)ptr;\n");
+    fprintf(fp, "\t\tunsigned int packetLen = *(int *)(ptr + 4);\n");
+    fprintf(fp, "\t\tif (len - pos < packetLen) break;\n");
+    fprintf(fp, "\t\tsize_t last = 0;\n");
+    for (size_t i = 0; i < sorted.size(); i++) {
+        const char *basename = sorted[i]->m_basename.c_str();
+        int first = sorted[i]->baseOpcode();
+        int end = first + (int)sorted[i]->size();
+        fprintf(fp, "\t\t%sif (opcode >= %d && opcode < %d) {\n",
+                i == 0 ? "" : "else ", first, end);
+        fprintf(fp, "\t\t\tif (m_%s) last = m_%s->decode(ptr, len - pos, stream);\n",
+                basename, basename);
+        fprintf(fp, "\t\t}\n");
+    }
+    fprintf(fp, "\t\tif (last == 0) break; // unknown opcode\n");
+    fprintf(fp, "\t\tpos += last;\n");
+    fprintf(fp, "\t\tptr += last;\n");
+    fprintf(fp, "\t\tif (m_replyFlushSize && stream->pending() >= m_replyFlushSize) {\n");
+    fprintf(fp, "\t\t\tstream->flush();\n");
+    fprintf(fp, "\t\t}\n");
+    fprintf(fp, "\t}\n");
+    fprintf(fp, "\treturn pos;\n");
+    fprintf(fp, "}\n");
+
+    fclose(fp);
+    return 0;
+}
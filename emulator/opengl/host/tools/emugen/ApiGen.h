@@ -26,11 +26,15 @@ class ApiGen : public std::vector<EntryPoint> {
 public:
     typedef std::vector<std::string> StringVec;
     typedef enum { CLIENT_SIDE, SERVER_SIDE, WRAPPER_SIDE } SideType;
+    typedef enum { DECODER_SWITCH, DECODER_TABLE } DecoderBackend;
 
     ApiGen(const std::string & basename) :
         m_basename(basename),
         m_maxEntryPointsParams(0),
-        m_baseOpcode(0)
+        m_baseOpcode(0),
+        m_deferReplyFlush(false),
+        m_largeByRef(false),
+        m_decoderBackend(DECODER_SWITCH)
     { }
     virtual ~ApiGen() {}
     int readSpec(const std::string & filename);
@@ -41,6 +45,12 @@ public:
     }
     int baseOpcode() { return m_baseOpcode; }
     void setBaseOpcode(int base) { m_baseOpcode = base; }
+    bool deferReplyFlush() { return m_deferReplyFlush; }
+    void setDeferReplyFlush(bool defer) { m_deferReplyFlush = defer; }
+    bool largeByRef() { return m_largeByRef; }
+    void setLargeByRef(bool byRef) { m_largeByRef = byRef; }
+    DecoderBackend decoderBackend() { return m_decoderBackend; }
+    void setDecoderBackend(DecoderBackend backend) { m_decoderBackend = backend; }
 
     const char *sideString(SideType side) {
         const char *retval;
@@ -80,6 +90,14 @@ public:
     int genDecoderHeader(const std::string &filename);
     int genDecoderImpl(const std::string &filename);
 
+    // merged front-end which routes each packet to one of the 'apis'
+    // decoders according to the opcode range it falls in.
+    typedef std::vector<ApiGen *> ApiVec;
+    static int genDispatcherHeader(const std::string &filename,
+                                   const std::string &name, ApiVec &apis);
+    static int genDispatcherImpl(const std::string &filename,
+                                 const std::string &name, ApiVec &apis);
+
 protected:
     virtual void printHeader(FILE *fp) const;
     std::string m_basename;
@@ -89,6 +107,9 @@ protected:
     StringVec m_decoderHeaders;
     size_t m_maxEntryPointsParams; // record the maximum number of parameters in the entry points;
     int m_baseOpcode;
+    bool m_deferReplyFlush; // decoders leave replies in the stream for the caller to flush
+    bool m_largeByRef;      // encoders queue large parameters with IOStream::allocRef()
+    DecoderBackend m_decoderBackend;
     int setGlobalAttribute(const std::string & line, size_t lc);
 };
 
@@ -128,7 +128,11 @@ int TypeFactory::initFromFile(const std::string &filename)
             return -1;
         }
 
-        if (getVarTypeByName(name)->id() != 0) {
+        // identical definitions are expected when several specs sharing
+        // types are read by the same run (see the -M option)
+        const VarType *known = getVarTypeByName(name);
+        if (known->id() != 0 &&
+            (known->bytes() != v->bytes() || known->isPointer() != isPointer)) {
             fprintf(stderr,
                     "Warining: %d : type %s is already known, definition in line %d is taken\n",
                     lc, name.c_str(), lc);
@@ -35,6 +35,65 @@ void usage(const char *filename)
     fprintf(stderr, "\t-i: input dir, local directory by default\n");
     fprintf(stderr, "\t-T : generate attribute template into the input directory\n\t\tno other files are generated\n");
     fprintf(stderr, "\t-W : generate wrapper into dir\n");
+    fprintf(stderr, "\t-M <dir>: generate into dir a dispatcher named <base name> which routes packets\n\t\tby opcode to the decoders of the specs given as extra <input dir>/<base name> arguments\n");
+    fprintf(stderr, "\t-B <switch|table>: decoder backend, 'switch' by default. 'table' precomputes\n\t\targument offsets and dispatches through a table of labels when supported\n");
+    fprintf(stderr, "\t-F : do not flush the stream after each decoded reply,\n\t\tthe caller of decode() is responsible for flushing it\n");
+    fprintf(stderr, "\t-R : queue the large parameters of encoded calls with IOStream::allocRef(),\n\t\tfor encoders whose streams implement it\n");
+}
+
+//
+// Read the specs given as "<input dir>/<base name>" and generate a
+// dispatcher which routes packets to their decoders by opcode range.
+//
+static int genDispatcher(const std::string &outDir, const std::string &name,
+                         int nspecs, char **specs)
+{
+    if (nspecs == 0) {
+        fprintf(stderr, "No decoder specified for the dispatcher - aborting\n");
+        return BAD_USAGE;
+    }
+
+    ApiGen::ApiVec apis;
+    int ret = 0;
+    for (int i = 0; i < nspecs && ret == 0; i++) {
+        std::string spec(specs[i]);
+        std::string inDir = ".";
+        std::string baseName = spec;
+        size_t slash = spec.rfind('/');
+        if (slash != std::string::npos) {
+            inDir = spec.substr(0, slash);
+            baseName = spec.substr(slash + 1);
+        }
+
+        ApiGen *api = new ApiGen(baseName);
+        apis.push_back(api);
+
+        std::string prefix = inDir + "/" + baseName;
+        if (TypeFactory::instance()->initFromFile(prefix + TYPES_EXTENTION) < 0) {
+            fprintf(stderr, "missing or error reading types file: %s...ignored\n",
+                    (prefix + TYPES_EXTENTION).c_str());
+        }
+        if (api->readSpec(prefix + SPEC_EXTENSION) < 0) {
+            perror((prefix + SPEC_EXTENSION).c_str());
+            ret = BAD_SPEC_FILE;
+        } else if (api->readAttributes(prefix + ATTRIB_EXTENSION) < 0) {
+            perror((prefix + ATTRIB_EXTENSION).c_str());
+            fprintf(stderr, "failed to parse attributes\n");
+            ret = BAD_ATTRIBUTES_FILE;
+        }
+    }
+
+    if (ret == 0) {
+        if (ApiGen::genDispatcherHeader(outDir + "/" + name + "_dispatch.h", name, apis) < 0 ||
+            ApiGen::genDispatcherImpl(outDir + "/" + name + "_dispatch.cpp", name, apis) < 0) {
+            ret = 1;
+        }
+    }
+
+    for (size_t i = 0; i < apis.size(); i++) {
+        delete apis[i];
+    }
+    return ret;
 }
 
 int main(int argc, char *argv[])
@@ -42,11 +101,15 @@ int main(int argc, char *argv[])
     std::string encoderDir = "";
     std::string decoderDir = "";
     std::string wrapperDir = "";
+    std::string dispatcherDir = "";
     std::string inDir = ".";
     bool generateAttributesTemplate = false;
+    bool deferReplyFlush = false;
+    bool largeByRef = false;
+    ApiGen::DecoderBackend decoderBackend = ApiGen::DECODER_SWITCH;
 
     int c;
-    while((c = getopt(argc, argv, "TE:D:i:hW:")) != -1) {
+    while((c = getopt(argc, argv, "TE:D:i:hW:FRM:B:")) != -1) {
         switch(c) {
         case 'W':
             wrapperDir = std::string(optarg);
@@ -54,6 +117,26 @@ int main(int argc, char *argv[])
         case 'T':
             generateAttributesTemplate = true;
             break;
+        case 'F':
+            deferReplyFlush = true;
+            break;
+        case 'R':
+            largeByRef = true;
+            break;
+        case 'M':
+            dispatcherDir = std::string(optarg);
+            break;
+        case 'B':
+            if (std::string(optarg) == "table") {
+                decoderBackend = ApiGen::DECODER_TABLE;
+            } else if (std::string(optarg) == "switch") {
+                decoderBackend = ApiGen::DECODER_SWITCH;
+            } else {
+                fprintf(stderr, "Unknown decoder backend: %s\n", optarg);
+                usage(argv[0]);
+                exit(0);
+            }
+            break;
         case 'h':
             usage(argv[0]);
             exit(0);
@@ -81,6 +164,10 @@ int main(int argc, char *argv[])
         return BAD_USAGE;
     }
 
+    if (dispatcherDir.size() != 0) {
+        return genDispatcher(dispatcherDir, argv[optind], argc - optind - 1, argv + optind + 1);
+    }
+
     if (encoderDir.size() == 0 &&
         decoderDir.size() == 0 &&
         generateAttributesTemplate == false &&
@@ -91,6 +178,9 @@ int main(int argc, char *argv[])
 
     std::string baseName = std::string(argv[optind]);
     ApiGen apiEntries(baseName);
+    apiEntries.setDeferReplyFlush(deferReplyFlush);
+    apiEntries.setLargeByRef(largeByRef);
+    apiEntries.setDecoderBackend(decoderBackend);
 
     // init types;
     std::string typesFilename = inDir + "/" + baseName + TYPES_EXTENTION;
@@ -0,0 +1,18 @@
+LOCAL_PATH:=$(call my-dir)
+
+# host stream replay tool, see main.cpp ##########
+$(call emugl-begin-host-executable,renderer_replay)
+$(call emugl-import,libOpenglRender lib_renderControl_dec)
+
+LOCAL_SRC_FILES := \
+    main.cpp \
+    ReplayStream.cpp
+
+# use Translator's egl/gles headers
+LOCAL_C_INCLUDES += $(EMUGL_PATH)/host/libs/Translator/include
+
+ifeq ($(HOST_OS),linux)
+LOCAL_LDLIBS += -lX11
+endif
+
+$(call emugl-end-module)
@@ -0,0 +1,228 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "ReplayStream.h"
+#include "TimeUtils.h"
+#include "renderControl_opcodes.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+ReplayStream::ReplayStream(const char *fileName) :
+    IOStream(4096),
+    m_fileName(strdup(fileName)),
+    m_data(NULL),
+    m_size(0),
+    m_pos(0),
+    m_nextPacket(0),
+    m_chunk(0),
+    m_paceOffsetUS(0),
+    m_paced(false),
+    m_replyBuf(NULL),
+    m_replyBufSize(0),
+    m_replyBytes(0),
+    m_packets(0),
+    m_startUS(0),
+    m_endUS(0),
+    m_frameStartUS(0),
+    m_frameEnd(false)
+{
+}
+
+ReplayStream::~ReplayStream()
+{
+    free(m_fileName);
+    free(m_data);
+    free(m_replyBuf);
+}
+
+ReplayStream *ReplayStream::create(const char *fileName, bool paced)
+{
+    ReplayStream *stream = new ReplayStream(fileName);
+    if (!stream->load(paced)) {
+        delete stream;
+        return NULL;
+    }
+    return stream;
+}
+
+bool ReplayStream::load(bool paced)
+{
+    FILE *fp = fopen(m_fileName, "rb");
+    if (!fp) {
+        ERR("Failed to open %s\n", m_fileName);
+        return false;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size <= 0) {
+        ERR("%s is empty\n", m_fileName);
+        fclose(fp);
+        return false;
+    }
+    m_data = (unsigned char *)malloc(size);
+    if (!m_data || fread(m_data, 1, size, fp) != (size_t)size) {
+        ERR("Failed to read %s\n", m_fileName);
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+    m_size = size;
+
+    if (!paced) {
+        return true;
+    }
+
+    //
+    // read the arrival time and size of each chunk of the capture
+    //
+    size_t nameLen = strlen(m_fileName) + 8;
+    char *timesName = new char[nameLen];
+    snprintf(timesName, nameLen, "%s.times", m_fileName);
+    fp = fopen(timesName, "r");
+    if (!fp) {
+        ERR("Failed to open %s, needed to pace the replay\n", timesName);
+        delete [] timesName;
+        return false;
+    }
+    delete [] timesName;
+
+    Chunk chunk;
+    chunk.end = 0;
+    long long t;
+    unsigned int len;
+    while (fscanf(fp, "%lld %u", &t, &len) == 2) {
+        chunk.timeUS = t;
+        chunk.end += len;
+        if (chunk.end > m_size) {
+            break;
+        }
+        m_chunks.push_back(chunk);
+    }
+    fclose(fp);
+
+    if (m_chunks.empty()) {
+        ERR("No pacing information for %s\n", m_fileName);
+        return false;
+    }
+    // data past the last chunk went with it
+    m_chunks.back().end = m_size;
+    m_paced = true;
+    return true;
+}
+
+long long ReplayStream::captureStartUS() const
+{
+    return m_chunks.empty() ? 0 : m_chunks[0].timeUS;
+}
+
+void ReplayStream::setPacing(long long baseUS, long long captureBaseUS)
+{
+    m_paceOffsetUS = baseUS - captureBaseUS;
+}
+
+void *ReplayStream::allocBuffer(size_t minSize)
+{
+    if (m_replyBufSize < minSize) {
+        unsigned char *p = (unsigned char *)realloc(m_replyBuf, minSize);
+        if (!p) {
+            return NULL;
+        }
+        m_replyBuf = p;
+        m_replyBufSize = minSize;
+    }
+    return m_replyBuf;
+}
+
+int ReplayStream::commitBuffer(size_t size)
+{
+    m_replyBytes += size;
+    return 0;
+}
+
+const unsigned char *ReplayStream::readFully(void *buf, size_t len)
+{
+    // the decoders never read back from their stream
+    ERR("ReplayStream::readFully not supported\n");
+    return NULL;
+}
+
+int ReplayStream::writeFully(const void *buf, size_t len)
+{
+    m_replyBytes += len;
+    return 0;
+}
+
+const unsigned char *ReplayStream::read(void *buf, size_t *inout_len)
+{
+    long long now = GetCurrentTimeUS();
+    if (m_startUS == 0) {
+        m_startUS = m_frameStartUS = now;
+    }
+
+    //
+    // everything handed out so far has been decoded, close the frame
+    // which ended with the last read.
+    //
+    if (m_frameEnd) {
+        m_frameTimes.push_back((unsigned int)(now - m_frameStartUS));
+        m_frameStartUS = now;
+        m_frameEnd = false;
+    }
+
+    if (m_pos >= m_size) {
+        m_endUS = now;
+        return NULL;
+    }
+
+    size_t end = m_size;
+    if (m_paced) {
+        while (m_chunk < m_chunks.size() - 1 && m_chunks[m_chunk].end <= m_pos) {
+            m_chunk++;
+        }
+        long long due = m_chunks[m_chunk].timeUS + m_paceOffsetUS;
+        if (due > now) {
+            TimeSleepMS((int)((due - now + 999) / 1000));
+        }
+        end = m_chunks[m_chunk].end;
+    }
+    if (end - m_pos > *inout_len) {
+        end = m_pos + *inout_len;
+    }
+
+    //
+    // count the packets handed out whole and stop after the end of a frame
+    //
+    while (m_nextPacket + 8 <= end) {
+        uint32_t opcode = *(uint32_t *)(m_data + m_nextPacket);
+        uint32_t packetLen = *(uint32_t *)(m_data + m_nextPacket + 4);
+        if (packetLen < 8 || m_nextPacket + packetLen > end) {
+            break;
+        }
+        m_nextPacket += packetLen;
+        m_packets++;
+        if (opcode == OP_rcFlushWindowColorBuffer) {
+            end = m_nextPacket;
+            m_frameEnd = true;
+            break;
+        }
+    }
+
+    memcpy(buf, m_data + m_pos, end - m_pos);
+    *inout_len = end - m_pos;
+    m_pos = end;
+    return (const unsigned char *)buf;
+}
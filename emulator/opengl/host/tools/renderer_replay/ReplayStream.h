@@ -0,0 +1,89 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef __REPLAY_STREAM_H
+#define __REPLAY_STREAM_H
+
+#include "IOStream.h"
+#include <vector>
+
+//
+// ReplayStream - an IOStream which feeds a RenderThread with a stream
+// captured in RENDERER_DUMP_DIR, and discards the replies.
+//
+// Reads are cut right after each rcFlushWindowColorBuffer packet, the
+// end of a guest frame. The render thread only reads again once it has
+// decoded everything it was given, so the time between two such reads
+// is the time the renderer took to process the frame.
+//
+// When paced, the data is handed out no faster than it arrived in the
+// capture, using the .times file written along with the dump.
+//
+class ReplayStream : public IOStream {
+public:
+    static ReplayStream *create(const char *fileName, bool paced);
+    virtual ~ReplayStream();
+
+    // monotonic time of the first chunk in the capture, in microseconds
+    long long captureStartUS() const;
+    // replay the chunks relative to 'baseUS', which is mapped to the
+    // capture time 'captureBaseUS'
+    void setPacing(long long baseUS, long long captureBaseUS);
+
+    virtual void *allocBuffer(size_t minSize);
+    virtual int commitBuffer(size_t size);
+    virtual const unsigned char *readFully(void *buf, size_t len);
+    virtual const unsigned char *read(void *buf, size_t *inout_len);
+    virtual int writeFully(const void *buf, size_t len);
+
+    const char *fileName() const { return m_fileName; }
+    size_t bytes() const { return m_size; }
+    unsigned long long packets() const { return m_packets; }
+    unsigned long long replyBytes() const { return m_replyBytes; }
+    long long elapsedUS() const { return m_endUS - m_startUS; }
+    const std::vector<unsigned int> &frameTimes() const { return m_frameTimes; }
+
+private:
+    struct Chunk {
+        long long timeUS;
+        size_t end;      // offset of the end of the chunk in m_data
+    };
+
+    ReplayStream(const char *fileName);
+    bool load(bool paced);
+
+    char *m_fileName;
+    unsigned char *m_data;
+    size_t m_size;
+    size_t m_pos;
+    size_t m_nextPacket;   // offset of the first packet not handed out whole
+    std::vector<Chunk> m_chunks;
+    size_t m_chunk;
+    long long m_paceOffsetUS;
+    bool m_paced;
+
+    unsigned char *m_replyBuf;
+    size_t m_replyBufSize;
+    unsigned long long m_replyBytes;
+
+    unsigned long long m_packets;
+    long long m_startUS;
+    long long m_endUS;
+    long long m_frameStartUS;
+    bool m_frameEnd;       // the last read ended a frame
+    std::vector<unsigned int> m_frameTimes;
+};
+
+#endif
@@ -0,0 +1,289 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+//
+// renderer_replay - replays streams captured with RENDERER_DUMP_DIR
+// through the renderer, one RenderThread per stream, into an offscreen
+// FrameBuffer. It reports the packet rate and frame times of each stream
+// and, optionally, the time spent in each opcode.
+//
+// Nothing is displayed, so it runs without a GPU on top of a software GL
+// such as Mesa llvmpipe (the translator still needs an X display on
+// Linux, e.g. Xvfb).
+//
+// Streams are replayed concurrently. Handles are allocated in the order
+// the streams create their objects, so streams which share objects,
+// e.g. the gralloc and an application stream, only replay faithfully in
+// the original order, which -pace approximates.
+//
+#include "libOpenglRender/render_api.h"
+#include "FrameBuffer.h"
+#include "RenderThread.h"
+#include "RenderMetrics.h"
+#include "ReplayStream.h"
+#include "TimeUtils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#ifdef __linux__
+#include <X11/Xlib.h>
+#endif
+
+// number of opcodes listed by -opcodes
+#define REPORT_TOP_OPCODES 20
+
+static void printUsage(const char *progName)
+{
+    fprintf(stderr, "Usage: %s [options] <stream dump> ...\n", progName);
+    fprintf(stderr, "    -width <num>   - framebuffer width (default 320)\n");
+    fprintf(stderr, "    -height <num>  - framebuffer height (default 480)\n");
+    fprintf(stderr, "    -pace          - replay at the pace the streams were captured\n");
+    fprintf(stderr, "    -opcodes       - report the time spent in each opcode,\n");
+    fprintf(stderr, "                     packets are then timed one by one\n");
+    fprintf(stderr, "    -soft          - ask Mesa for software rendering\n");
+    exit(-1);
+}
+
+static unsigned int percentile(const std::vector<unsigned int> &sorted, int p)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t i = (sorted.size() - 1) * p / 100;
+    return sorted[i];
+}
+
+static void reportStream(ReplayStream *stream)
+{
+    double secs = (double)stream->elapsedUS() / 1000000.0;
+    if (secs <= 0.0) {
+        secs = 1e-6;
+    }
+    printf("%s:\n", stream->fileName());
+    printf("    %llu packets, %.3f MB in %.3f s: %.0f packets/s, %.3f MB/s, %.3f MB replies\n",
+           stream->packets(), (double)stream->bytes() / (1024.0 * 1024.0), secs,
+           (double)stream->packets() / secs,
+           (double)stream->bytes() / (1024.0 * 1024.0) / secs,
+           (double)stream->replyBytes() / (1024.0 * 1024.0));
+
+    std::vector<unsigned int> frames(stream->frameTimes());
+    if (frames.empty()) {
+        return;
+    }
+    std::sort(frames.begin(), frames.end());
+    unsigned long long total = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        total += frames[i];
+    }
+    printf("    %zu frames: avg %llu us, p50 %u us, p95 %u us, p99 %u us, max %u us\n",
+           frames.size(), total / frames.size(), percentile(frames, 50),
+           percentile(frames, 95), percentile(frames, 99), frames.back());
+}
+
+static bool compareOpcodeTime(const RenderOpcodeMetrics &a,
+                              const RenderOpcodeMetrics &b)
+{
+    return a.timeUs > b.timeUs;
+}
+
+//
+// reportOpcodes - print the opcodes which took the most time over all
+// the streams.
+//
+static void reportOpcodes()
+{
+    RenderMetricsSnapshot *snap = new RenderMetricsSnapshot;
+    RenderMetrics::snapshot(snap);
+
+    std::map<unsigned int, RenderOpcodeMetrics> ops;
+    unsigned long long totalTime = 0;
+    for (unsigned int i = 0; i < snap->numOpcodes; i++) {
+        const RenderOpcodeMetrics &m = snap->opcodes[i];
+        RenderOpcodeMetrics &op = ops[m.opcode];
+        op.opcode = m.opcode;
+        op.calls += m.calls;
+        op.bytes += m.bytes;
+        op.timeUs += m.timeUs;
+        for (int b = 0; b < RENDER_METRICS_HIST_BUCKETS; b++) {
+            op.timeHist[b] += m.timeHist[b];
+        }
+        totalTime += m.timeUs;
+    }
+
+    std::vector<RenderOpcodeMetrics> sorted;
+    for (std::map<unsigned int, RenderOpcodeMetrics>::iterator it = ops.begin();
+         it != ops.end(); it++) {
+        sorted.push_back(it->second);
+    }
+    std::sort(sorted.begin(), sorted.end(), compareOpcodeTime);
+
+    printf("opcode     calls   total ms  avg us  p95 us  %% time\n");
+    for (size_t i = 0; i < sorted.size() && i < REPORT_TOP_OPCODES; i++) {
+        const RenderOpcodeMetrics &op = sorted[i];
+
+        // upper bound of the histogram bucket holding the 95th percentile
+        unsigned long long seen = 0;
+        int b = 0;
+        while (b < RENDER_METRICS_HIST_BUCKETS - 1 &&
+               (seen + op.timeHist[b]) * 100 < op.calls * 95) {
+            seen += op.timeHist[b];
+            b++;
+        }
+
+        printf("%6u %9llu %10.3f %7llu %7u %6.1f\n",
+               op.opcode, op.calls, (double)op.timeUs / 1000.0,
+               op.timeUs / op.calls, 1u << b,
+               totalTime ? 100.0 * op.timeUs / totalTime : 0.0);
+    }
+
+    if (snap->posts) {
+        printf("posts: %llu, avg %llu us, %llu dropped\n", snap->posts,
+               snap->postTimeUs / snap->posts, snap->droppedPosts);
+    }
+
+    delete snap;
+}
+
+static void discardFrame(void *context, int width, int height, int ydir,
+                         int format, int type, unsigned char *pixels)
+{
+}
+
+int main(int argc, char *argv[])
+{
+    int width = 320;
+    int height = 480;
+    bool paced = false;
+    bool opcodes = false;
+    std::vector<const char *> files;
+
+    for (int i=1; i<argc; i++) {
+        if (!strcmp(argv[i], "-width")) {
+            if (++i >= argc || sscanf(argv[i],"%d", &width) != 1) {
+                printUsage(argv[0]);
+            }
+        }
+        else if (!strcmp(argv[i], "-height")) {
+            if (++i >= argc || sscanf(argv[i],"%d", &height) != 1) {
+                printUsage(argv[0]);
+            }
+        }
+        else if (!strcmp(argv[i], "-pace")) {
+            paced = true;
+        }
+        else if (!strcmp(argv[i], "-opcodes")) {
+            opcodes = true;
+        }
+        else if (!strcmp(argv[i], "-soft")) {
+#ifndef _WIN32
+            setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+#endif
+        }
+        else if (argv[i][0] == '-') {
+            printUsage(argv[0]);
+        }
+        else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty()) {
+        printUsage(argv[0]);
+    }
+
+    std::vector<ReplayStream *> streams;
+    for (size_t i = 0; i < files.size(); i++) {
+        ReplayStream *stream = ReplayStream::create(files[i], paced);
+        if (!stream) {
+            return -1;
+        }
+        streams.push_back(stream);
+    }
+
+#ifdef __linux__
+    // the render threads may all end up calling X through the translator
+    XInitThreads();
+#endif
+
+    if (!initLibrary()) {
+        fprintf(stderr, "Failed to load the GLES translator libraries\n");
+        return -1;
+    }
+
+    // headless, so the posts are not dropped for the lack of a subwindow:
+    // each one is read back and handed to discardFrame, as the emulator's
+    // display would get it
+    if (!FrameBuffer::initialize(width, height, true)) {
+        fprintf(stderr, "Failed to initialize Framebuffer\n");
+        return -1;
+    }
+    FrameBuffer::getFB()->setPostCallback(discardFrame, NULL);
+
+    if (opcodes) {
+        RenderMetrics::setEnabled(true, 0);
+    }
+
+    //
+    // align the captures on the earliest one, leaving a little time for
+    // the threads to start
+    //
+    if (paced) {
+        long long captureBase = streams[0]->captureStartUS();
+        for (size_t i = 1; i < streams.size(); i++) {
+            captureBase = std::min(captureBase, streams[i]->captureStartUS());
+        }
+        long long base = GetCurrentTimeUS() + 10000;
+        for (size_t i = 0; i < streams.size(); i++) {
+            streams[i]->setPacing(base, captureBase);
+        }
+    }
+
+    std::vector<RenderThread *> threads;
+    for (size_t i = 0; i < streams.size(); i++) {
+        RenderThread *rt = RenderThread::create(streams[i]);
+        if (!rt || !rt->start()) {
+            fprintf(stderr, "Failed to start RenderThread\n");
+            return -1;
+        }
+        threads.push_back(rt);
+    }
+
+    long long t0 = GetCurrentTimeUS();
+    unsigned long long totalPackets = 0;
+    for (size_t i = 0; i < threads.size(); i++) {
+        int exitStatus;
+        threads[i]->wait(&exitStatus);
+        reportStream(streams[i]);
+        totalPackets += streams[i]->packets();
+    }
+    double secs = (double)(GetCurrentTimeUS() - t0) / 1000000.0;
+    printf("total: %llu packets in %.3f s, %.0f packets/s\n",
+           totalPackets, secs, secs > 0.0 ? (double)totalPackets / secs : 0.0);
+
+    if (opcodes) {
+        reportOpcodes();
+    }
+
+    // the threads own their streams
+    for (size_t i = 0; i < threads.size(); i++) {
+        delete threads[i];
+    }
+    FrameBuffer::finalize();
+    return 0;
+}
@@ -7,6 +7,7 @@ commonSources := \
         GLClientState.cpp \
         GLSharedGroup.cpp \
         glUtils.cpp \
+        Lz4Block.cpp \
         SocketStream.cpp \
         TcpStream.cpp \
         TimeUtils.cpp
@@ -19,6 +20,10 @@ else
     host_commonSources += UnixStream.cpp
 endif
 
+ifeq ($(HOST_OS),linux)
+    host_commonSources += ShmStream.cpp
+endif
+
 
 ### OpenglCodecCommon  host ##############################################
 $(call emugl-begin-host-static-library,libOpenglCodecCommon)
@@ -0,0 +1,211 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "Lz4Block.h"
+#include <stdint.h>
+#include <string.h>
+
+#define MIN_MATCH       4
+#define MAX_OFFSET      65535
+#define HASH_LOG        12
+// the last match must start at least MF_LIMIT bytes before the end of
+// the block, and the block must end with LAST_LITERALS literals.
+#define MF_LIMIT        12
+#define LAST_LITERALS   5
+// the search step grows by one every 2^SKIP_SHIFT bytes without a match,
+// to get through incompressible data quickly.
+#define SKIP_SHIFT      6
+
+static inline uint32_t read32(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash32(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - HASH_LOG);
+}
+
+// append a length continuation: 255s followed by the remainder
+static inline unsigned char *writeLength(unsigned char *op, size_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+static unsigned char *writeLiterals(unsigned char *op, unsigned char *token,
+                                    const unsigned char *lit, size_t len)
+{
+    if (len >= 15) {
+        *token = 15 << 4;
+        op = writeLength(op, len - 15);
+    } else {
+        *token = (unsigned char)(len << 4);
+    }
+    memcpy(op, lit, len);
+    return op + len;
+}
+
+int lz4BlockCompress(const void *srcv, size_t srcSize,
+                     void *dstv, size_t dstCapacity)
+{
+    const unsigned char *src = (const unsigned char *)srcv;
+    const unsigned char *end = src + srcSize;
+    const unsigned char *ip = src;
+    const unsigned char *anchor = src;
+    unsigned char *dst = (unsigned char *)dstv;
+    unsigned char *op = dst;
+    unsigned char *oend = dst + dstCapacity;
+
+    if (srcSize > MF_LIMIT) {
+        const unsigned char *mflimit = end - MF_LIMIT;
+        const unsigned char *matchlimit = end - LAST_LITERALS;
+        uint32_t table[1 << HASH_LOG];
+        memset(table, 0, sizeof(table));
+
+        while (ip <= mflimit) {
+            uint32_t h = hash32(read32(ip));
+            const unsigned char *ref = src + table[h];
+            table[h] = (uint32_t)(ip - src);
+
+            if (ref >= ip || ip - ref > MAX_OFFSET || read32(ref) != read32(ip)) {
+                ip += 1 + ((ip - anchor) >> SKIP_SHIFT);
+                continue;
+            }
+
+            // extend the match backwards over the pending literals
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+
+            const unsigned char *mp = ip + MIN_MATCH;
+            const unsigned char *rp = ref + MIN_MATCH;
+            while (mp < matchlimit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+
+            size_t litLen = ip - anchor;
+            size_t matchLen = mp - ip - MIN_MATCH;
+            if ((size_t)(oend - op) < 1 + litLen + litLen / 255 + 1 +
+                                      2 + matchLen / 255 + 1) {
+                return -1;
+            }
+
+            unsigned char *token = op++;
+            op = writeLiterals(op, token, anchor, litLen);
+
+            size_t offset = ip - ref;
+            *op++ = (unsigned char)(offset & 0xff);
+            *op++ = (unsigned char)(offset >> 8);
+
+            if (matchLen >= 15) {
+                *token |= 15;
+                op = writeLength(op, matchLen - 15);
+            } else {
+                *token |= (unsigned char)matchLen;
+            }
+
+            ip = anchor = mp;
+            if (ip <= mflimit) {
+                // help the next match find the end of this one
+                table[hash32(read32(ip - 2))] = (uint32_t)(ip - 2 - src);
+            }
+        }
+    }
+
+    size_t litLen = end - anchor;
+    if ((size_t)(oend - op) < 1 + litLen + litLen / 255 + 1) {
+        return -1;
+    }
+    unsigned char *token = op++;
+    op = writeLiterals(op, token, anchor, litLen);
+    return (int)(op - dst);
+}
+
+int lz4BlockDecompress(const void *srcv, size_t srcSize,
+                       void *dstv, size_t dstCapacity)
+{
+    const unsigned char *ip = (const unsigned char *)srcv;
+    const unsigned char *iend = ip + srcSize;
+    unsigned char *dst = (unsigned char *)dstv;
+    unsigned char *op = dst;
+    unsigned char *oend = dst + dstCapacity;
+
+    while (ip < iend) {
+        unsigned int token = *ip++;
+
+        size_t litLen = token >> 4;
+        if (litLen == 15) {
+            unsigned int b;
+            do {
+                if (ip >= iend) return -1;
+                b = *ip++;
+                litLen += b;
+            } while (b == 255);
+        }
+        if ((size_t)(iend - ip) < litLen || (size_t)(oend - op) < litLen) {
+            return -1;
+        }
+        memcpy(op, ip, litLen);
+        ip += litLen;
+        op += litLen;
+
+        // the last sequence has no match
+        if (ip == iend) {
+            break;
+        }
+
+        if (iend - ip < 2) return -1;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) {
+            return -1;
+        }
+
+        size_t matchLen = token & 15;
+        if (matchLen == 15) {
+            unsigned int b;
+            do {
+                if (ip >= iend) return -1;
+                b = *ip++;
+                matchLen += b;
+            } while (b == 255);
+        }
+        matchLen += MIN_MATCH;
+        if ((size_t)(oend - op) < matchLen) {
+            return -1;
+        }
+
+        const unsigned char *ref = op - offset;
+        if (offset >= matchLen) {
+            memcpy(op, ref, matchLen);
+            op += matchLen;
+        } else {
+            // overlapping copy, repeats the last 'offset' bytes
+            for (size_t i = 0; i < matchLen; i++) {
+                *op++ = *ref++;
+            }
+        }
+    }
+    return (int)(op - dst);
+}
@@ -0,0 +1,39 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef __LZ4_BLOCK_H
+#define __LZ4_BLOCK_H
+
+#include <stddef.h>
+
+//
+// A compressor and decompressor for the LZ4 block format. The compressor
+// is a plain greedy one with a single hash table, which favors speed
+// over ratio; its output can be decoded by any LZ4 block decoder.
+//
+
+// maximum compressed size of 'size' bytes of input
+#define LZ4_BLOCK_BOUND(size) ((size) + (size) / 255 + 16)
+
+// returns the compressed size, or -1 if it does not fit in 'dstCapacity'
+int lz4BlockCompress(const void *src, size_t srcSize,
+                     void *dst, size_t dstCapacity);
+
+// returns the decompressed size, or -1 if the input is malformed or does
+// not fit in 'dstCapacity'
+int lz4BlockDecompress(const void *src, size_t srcSize,
+                       void *dst, size_t dstCapacity);
+
+#endif
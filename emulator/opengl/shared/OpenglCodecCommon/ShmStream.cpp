@@ -0,0 +1,549 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "ShmStream.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <time.h>
+
+#define SHM_STREAM_MAGIC      0x53484d31  // 'SHM1'
+#define SHM_WAIT_TIMEOUT_MS   100
+
+//
+// Control block of one direction of the stream. The fields written by
+// the producer and by the consumer live on separate cache lines.
+//
+struct ShmStream::RingHeader {
+    volatile uint32_t head;           // written by the producer
+    volatile uint32_t readerWaiting;  // set by the consumer before sleeping
+    volatile uint32_t closed;         // set by either side on shutdown
+    uint32_t          pad0[13];
+    volatile uint32_t tail;           // written by the consumer
+    volatile uint32_t writerWaiting;  // set by the producer before sleeping
+    uint32_t          pad1[14];
+};
+
+struct ShmHandshake {
+    uint32_t magic;
+    uint32_t ringSize;
+};
+
+static int futex_wait(volatile uint32_t *addr, uint32_t val, int timeoutMS)
+{
+    struct timespec ts;
+    ts.tv_sec = timeoutMS / 1000;
+    ts.tv_nsec = (timeoutMS % 1000) * 1000000L;
+    return syscall(__NR_futex, (uint32_t *)addr, FUTEX_WAIT, val, &ts, NULL, 0);
+}
+
+static void futex_wake(volatile uint32_t *addr)
+{
+    syscall(__NR_futex, (uint32_t *)addr, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+static size_t pageSize()
+{
+    static size_t s_pageSize = 0;
+    if (!s_pageSize) {
+        s_pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    }
+    return s_pageSize;
+}
+
+// ring sizes must be a power of two (for the free running 32-bit
+// head/tail counters) and a multiple of the page size (for the mirror)
+static uint32_t roundRingSize(size_t size)
+{
+    uint32_t r = (uint32_t)pageSize();
+    while (r < size && r < 0x40000000) {
+        r <<= 1;
+    }
+    return r;
+}
+
+ShmStream::ShmStream(size_t bufSize, size_t ringSize) :
+    UnixStream(bufSize),
+    m_map(NULL),
+    m_mapSize(0),
+    m_ringSize(roundRingSize(ringSize)),
+    m_staging(false)
+{
+    memset(&m_in, 0, sizeof(m_in));
+    memset(&m_out, 0, sizeof(m_out));
+}
+
+ShmStream::ShmStream(int sock, size_t bufSize, uint32_t ringSize) :
+    UnixStream(sock, bufSize),
+    m_map(NULL),
+    m_mapSize(0),
+    m_ringSize(ringSize),
+    m_staging(false)
+{
+    memset(&m_in, 0, sizeof(m_in));
+    memset(&m_out, 0, sizeof(m_out));
+}
+
+ShmStream::~ShmStream()
+{
+    unmapShared();
+}
+
+bool ShmStream::mapShared(int fd, uint32_t ringSize, bool isServer)
+{
+    size_t hdrSize = pageSize();
+    size_t reserveSize = hdrSize + 4 * (size_t)ringSize;
+
+    //
+    // reserve the address range first, then map the header and each
+    // ring data area twice over it.
+    //
+    unsigned char *base = (unsigned char *)mmap(NULL, reserveSize, PROT_NONE,
+                                                MAP_PRIVATE | MAP_ANONYMOUS,
+                                                -1, 0);
+    if (base == MAP_FAILED) {
+        ERR("%s: failed to reserve %zu bytes: %s\n", __FUNCTION__,
+            reserveSize, strerror(errno));
+        return false;
+    }
+    m_map = base;
+    m_mapSize = reserveSize;
+
+    if (mmap(base, hdrSize, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        ERR("%s: failed to map header: %s\n", __FUNCTION__, strerror(errno));
+        unmapShared();
+        return false;
+    }
+
+    Ring rings[2];
+    for (int r = 0; r < 2; r++) {
+        unsigned char *data = base + hdrSize + r * 2 * (size_t)ringSize;
+        off_t offset = hdrSize + r * (size_t)ringSize;
+        for (int m = 0; m < 2; m++) {
+            if (mmap(data + m * (size_t)ringSize, ringSize,
+                     PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                     fd, offset) == MAP_FAILED) {
+                ERR("%s: failed to map ring %d: %s\n", __FUNCTION__, r,
+                    strerror(errno));
+                unmapShared();
+                return false;
+            }
+        }
+        rings[r].hdr = (RingHeader *)base + r;
+        rings[r].data = data;
+        rings[r].size = ringSize;
+    }
+
+    // ring 0 carries client->server data, ring 1 server->client data
+    m_in = rings[isServer ? 0 : 1];
+    m_out = rings[isServer ? 1 : 0];
+    m_ringSize = ringSize;
+    return true;
+}
+
+void ShmStream::unmapShared()
+{
+    if (!m_map) return;
+
+    if (m_in.hdr && m_out.hdr) {
+        m_in.hdr->closed = 1;
+        m_out.hdr->closed = 1;
+        __sync_synchronize();
+        futex_wake(&m_in.hdr->tail);
+        futex_wake(&m_out.hdr->head);
+    }
+
+    munmap(m_map, m_mapSize);
+    m_map = NULL;
+    m_mapSize = 0;
+    memset(&m_in, 0, sizeof(m_in));
+    memset(&m_out, 0, sizeof(m_out));
+}
+
+SocketStream *ShmStream::accept()
+{
+    while (true) {
+        int clientSock = -1;
+
+        while (true) {
+            struct sockaddr_un addr;
+            socklen_t len = sizeof(addr);
+            clientSock = ::accept(m_sock, (sockaddr *)&addr, &len);
+
+            if (clientSock < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        if (clientSock < 0) {
+            return NULL;
+        }
+
+        //
+        // receive the shared memory descriptor and ring size from the client
+        //
+        ShmHandshake hs;
+        struct iovec iov;
+        iov.iov_base = &hs;
+        iov.iov_len = sizeof(hs);
+
+        char cbuf[CMSG_SPACE(sizeof(int))];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = cbuf;
+        msg.msg_controllen = sizeof(cbuf);
+
+        ssize_t n;
+        do {
+            n = ::recvmsg(clientSock, &msg, 0);
+        } while (n < 0 && errno == EINTR);
+
+        int fd = -1;
+        struct cmsghdr *cmsg = (n > 0) ? CMSG_FIRSTHDR(&msg) : NULL;
+        if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+        }
+
+        // the object must hold the header page and both rings, a shorter
+        // one would fault on the first access past its end
+        struct stat st;
+        if (n != (ssize_t)sizeof(hs) || fd < 0 || hs.magic != SHM_STREAM_MAGIC ||
+            hs.ringSize != roundRingSize(hs.ringSize) ||
+            fstat(fd, &st) < 0 ||
+            st.st_size < (off_t)(pageSize() + 2 * (size_t)hs.ringSize)) {
+            // a misbehaving client must not bring the server down,
+            // drop it and wait for the next one.
+            ERR("%s: bad shared memory handshake\n", __FUNCTION__);
+            if (fd >= 0) ::close(fd);
+            ::close(clientSock);
+            continue;
+        }
+
+        ShmStream *clientStream = new ShmStream(clientSock, m_bufsize, hs.ringSize);
+        bool mapped = clientStream->mapShared(fd, hs.ringSize, true);
+        ::close(fd);
+        if (!mapped) {
+            delete clientStream;
+            continue;
+        }
+        return clientStream;
+    }
+}
+
+int ShmStream::connect(const char* addr)
+{
+    if (UnixStream::connect(addr) < 0) {
+        return -1;
+    }
+
+    //
+    // create an anonymous shared memory object holding the header page
+    // and the two rings, then hand it to the server.
+    //
+    static volatile int32_t s_counter = 0;
+    char name[64];
+    snprintf(name, sizeof(name), "/emugl-shm-%d-%d", (int)getpid(),
+             (int)__sync_add_and_fetch(&s_counter, 1));
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        ERR("%s: shm_open failed: %s\n", __FUNCTION__, strerror(errno));
+        return -1;
+    }
+    shm_unlink(name);
+
+    uint32_t ringSize = (uint32_t)m_ringSize;
+    off_t fileSize = pageSize() + 2 * (size_t)ringSize;
+    if (ftruncate(fd, fileSize) < 0 || !mapShared(fd, ringSize, false)) {
+        ERR("%s: failed to set up shared memory\n", __FUNCTION__);
+        ::close(fd);
+        return -1;
+    }
+
+    ShmHandshake hs;
+    hs.magic = SHM_STREAM_MAGIC;
+    hs.ringSize = ringSize;
+
+    struct iovec iov;
+    iov.iov_base = &hs;
+    iov.iov_len = sizeof(hs);
+
+    char cbuf[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    ssize_t n;
+    do {
+        n = ::sendmsg(m_sock, &msg, 0);
+    } while (n < 0 && errno == EINTR);
+    ::close(fd);
+
+    if (n != (ssize_t)sizeof(hs)) {
+        ERR("%s: failed to send handshake: %s\n", __FUNCTION__, strerror(errno));
+        unmapShared();
+        return -1;
+    }
+    return 0;
+}
+
+//
+// peerClosed - check whether the other end has shut down, either
+// explicitly through the ring header or by closing its socket.
+//
+bool ShmStream::peerClosed()
+{
+    if (!m_in.hdr || m_in.hdr->closed) {
+        return true;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = m_sock;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (::poll(&pfd, 1, 0) <= 0) {
+        return false;
+    }
+    if (pfd.revents & (POLLHUP | POLLERR)) {
+        return true;
+    }
+    char c;
+    return ::recv(m_sock, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0;
+}
+
+//
+// waitForData - wait until at least minSize bytes are readable or the
+// ring is full. Returns the number of readable bytes, or 0 if the peer
+// has closed the stream before enough data arrived.
+//
+size_t ShmStream::waitForData(size_t minSize)
+{
+    RingHeader *hdr = m_in.hdr;
+    if (!hdr) return 0;
+
+    while (true) {
+        uint32_t head = hdr->head;
+        __sync_synchronize();
+        size_t avail = head - hdr->tail;
+        if (avail >= minSize || avail == m_in.size) {
+            return avail;
+        }
+        if (hdr->closed) {
+            return 0;
+        }
+
+        hdr->readerWaiting = 1;
+        __sync_synchronize();
+        if (hdr->head == head) {
+            int ret = futex_wait(&hdr->head, head, SHM_WAIT_TIMEOUT_MS);
+            if (ret < 0 && errno == ETIMEDOUT && peerClosed()) {
+                hdr->readerWaiting = 0;
+                return 0;
+            }
+        }
+        hdr->readerWaiting = 0;
+    }
+}
+
+//
+// waitForSpace - wait until at least minSize bytes can be written.
+// Returns the amount of free space or 0 if the peer has closed the stream.
+//
+size_t ShmStream::waitForSpace(size_t minSize)
+{
+    RingHeader *hdr = m_out.hdr;
+    if (!hdr) return 0;
+
+    while (true) {
+        if (hdr->closed) {
+            return 0;
+        }
+
+        uint32_t tail = hdr->tail;
+        __sync_synchronize();
+        size_t space = m_out.size - (uint32_t)(hdr->head - tail);
+        if (space >= minSize) {
+            return space;
+        }
+
+        hdr->writerWaiting = 1;
+        __sync_synchronize();
+        if (hdr->tail == tail) {
+            int ret = futex_wait(&hdr->tail, tail, SHM_WAIT_TIMEOUT_MS);
+            if (ret < 0 && errno == ETIMEDOUT && peerClosed()) {
+                hdr->writerWaiting = 0;
+                return 0;
+            }
+        }
+        hdr->writerWaiting = 0;
+    }
+}
+
+void ShmStream::publish(size_t len)
+{
+    RingHeader *hdr = m_out.hdr;
+    __sync_synchronize();
+    hdr->head += (uint32_t)len;
+    __sync_synchronize();
+    if (hdr->readerWaiting) {
+        futex_wake(&hdr->head);
+    }
+}
+
+void *ShmStream::allocBuffer(size_t minSize)
+{
+    if (!m_out.hdr) return NULL;
+
+    //
+    // packets larger than the ring cannot be placed in it directly,
+    // stage them in a heap buffer and copy them in chunks on commit.
+    //
+    if (minSize > m_out.size) {
+        m_staging = true;
+        return SocketStream::allocBuffer(minSize);
+    }
+
+    m_staging = false;
+    if (!waitForSpace(minSize)) {
+        return NULL;
+    }
+    return m_out.data + (m_out.hdr->head & (m_out.size - 1));
+}
+
+int ShmStream::commitBuffer(size_t size)
+{
+    if (m_staging) {
+        m_staging = false;
+        return writeFully(m_buf, size);
+    }
+    if (!m_out.hdr) return -1;
+    publish(size);
+    return 0;
+}
+
+int ShmStream::writeFully(const void *buf, size_t len)
+{
+    if (!m_out.hdr) return -1;
+
+    const unsigned char *p = (const unsigned char *)buf;
+    while (len > 0) {
+        size_t space = waitForSpace(1);
+        if (!space) {
+            ERR("%s: peer closed the stream\n", __FUNCTION__);
+            return -1;
+        }
+        size_t n = len < space ? len : space;
+        memcpy(m_out.data + (m_out.hdr->head & (m_out.size - 1)), p, n);
+        publish(n);
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+const unsigned char *ShmStream::peekIn(size_t minSize, size_t *out_avail)
+{
+    size_t avail = waitForData(minSize ? minSize : 1);
+    if (!avail) {
+        return NULL;
+    }
+    *out_avail = avail;
+    return m_in.data + (m_in.hdr->tail & (m_in.size - 1));
+}
+
+void ShmStream::consumeIn(size_t len)
+{
+    RingHeader *hdr = m_in.hdr;
+    if (!hdr || !len) return;
+
+    __sync_synchronize();
+    hdr->tail += (uint32_t)len;
+    __sync_synchronize();
+    if (hdr->writerWaiting) {
+        futex_wake(&hdr->tail);
+    }
+}
+
+const unsigned char *ShmStream::readFully(void *buf, size_t len)
+{
+    if (!buf || !m_in.hdr) return NULL;
+
+    unsigned char *p = (unsigned char *)buf;
+    size_t res = len;
+    while (res > 0) {
+        size_t avail = 0;
+        const unsigned char *src = peekIn(1, &avail);
+        if (!src) {
+            return NULL;
+        }
+        size_t n = res < avail ? res : avail;
+        memcpy(p, src, n);
+        consumeIn(n);
+        p += n;
+        res -= n;
+    }
+    return (const unsigned char *)buf;
+}
+
+const unsigned char *ShmStream::read(void *buf, size_t *inout_len)
+{
+    if (!buf) return NULL;
+
+    int n = recv(buf, *inout_len);
+    if (n > 0) {
+        *inout_len = n;
+        return (const unsigned char *)buf;
+    }
+    return NULL;
+}
+
+int ShmStream::recv(void *buf, size_t len)
+{
+    if (!m_in.hdr) return int(ERR_INVALID_SOCKET);
+
+    size_t avail = 0;
+    const unsigned char *src = peekIn(1, &avail);
+    if (!src) {
+        return 0;
+    }
+    size_t n = len < avail ? len : avail;
+    memcpy(buf, src, n);
+    consumeIn(n);
+    return (int)n;
+}
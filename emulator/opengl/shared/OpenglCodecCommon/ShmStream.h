@@ -0,0 +1,89 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef __SHM_STREAM_H
+#define __SHM_STREAM_H
+
+#include "UnixStream.h"
+#include <stdint.h>
+
+//
+// ShmStream - a stream which moves data through a pair of memory-mapped
+// ring buffers shared between the two ends of the connection, one ring
+// per direction. A unix domain socket is still used to rendezvous, to
+// pass the shared memory file descriptor and to detect that the peer
+// went away, but no data goes through it.
+//
+// Each ring's data area is mapped twice back to back in the virtual
+// address space, so any range of up to the ring size is contiguous in
+// memory. This lets allocBuffer() hand out pointers directly into the
+// ring and lets the reader decode packets in place through peekIn().
+//
+// Wakeups are done with futexes on the ring head/tail words; they are
+// only issued when the other side flagged that it is waiting.
+//
+class ShmStream : public UnixStream {
+public:
+    static const size_t DEFAULT_RING_SIZE = 4 * 1024 * 1024;
+
+    explicit ShmStream(size_t bufsize = 10000,
+                       size_t ringSize = DEFAULT_RING_SIZE);
+    virtual ~ShmStream();
+
+    virtual SocketStream *accept();
+    virtual int connect(const char* addr);
+
+    virtual void *allocBuffer(size_t minSize);
+    virtual int commitBuffer(size_t size);
+    virtual const unsigned char *readFully(void *buf, size_t len);
+    virtual const unsigned char *read(void *buf, size_t *inout_len);
+    virtual int writeFully(const void *buf, size_t len);
+    virtual int recv(void *buf, size_t len);
+
+    virtual bool canPeek() const { return true; }
+    virtual const unsigned char *peekIn(size_t minSize, size_t *out_avail);
+    virtual void consumeIn(size_t len);
+
+    // data has to be copied into the ring anyway, allocRef() writes large
+    // payloads straight into it with writeFully()
+    virtual bool canWriteV() const { return false; }
+
+private:
+    struct RingHeader;
+    struct Ring {
+        RingHeader    *hdr;
+        unsigned char *data;   // 2 * size bytes, second half mirrors first
+        uint32_t       size;
+    };
+
+    ShmStream(int sock, size_t bufSize, uint32_t ringSize);
+
+    bool mapShared(int fd, uint32_t ringSize, bool isServer);
+    void unmapShared();
+    bool peerClosed();
+
+    size_t waitForData(size_t minSize);
+    size_t waitForSpace(size_t minSize);
+    void   publish(size_t len);
+
+    void          *m_map;
+    size_t         m_mapSize;
+    size_t         m_ringSize;
+    Ring           m_in;
+    Ring           m_out;
+    bool           m_staging;  // true when the last allocBuffer fell back to m_buf
+};
+
+#endif
@@ -24,16 +24,23 @@
 #ifndef _WIN32
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #else
 #include <ws2tcpip.h>
 #endif
 
+// number of commits which fit in the base size before an oversized
+// staging buffer is released.
+#define SOCKET_STREAM_SHRINK_DELAY 64
+
 SocketStream::SocketStream(size_t bufSize) :
     IOStream(bufSize),
     m_sock(-1),
     m_bufsize(bufSize),
-    m_buf(NULL)
+    m_buf(NULL),
+    m_baseBufsize(bufSize),
+    m_shrinkCount(0)
 {
 }
 
@@ -41,7 +48,9 @@ SocketStream::SocketStream(int sock, size_t bufSize) :
     IOStream(bufSize),
     m_sock(sock),
     m_bufsize(bufSize),
-    m_buf(NULL)
+    m_buf(NULL),
+    m_baseBufsize(bufSize),
+    m_shrinkCount(0)
 {
 }
 
@@ -66,6 +75,7 @@ void *SocketStream::allocBuffer(size_t minSize)
     size_t allocSize = (m_bufsize < minSize ? minSize : m_bufsize);
     if (!m_buf) {
         m_buf = (unsigned char *)malloc(allocSize);
+        m_bufsize = m_buf ? allocSize : m_baseBufsize;
     }
     else if (m_bufsize < allocSize) {
         unsigned char *p = (unsigned char *)realloc(m_buf, allocSize);
@@ -85,9 +95,92 @@ void *SocketStream::allocBuffer(size_t minSize)
 
 int SocketStream::commitBuffer(size_t size)
 {
-    return writeFully(m_buf, size);
+    int retval = writeFully(m_buf, size);
+    trimBuffer(size);
+    return retval;
+}
+
+//
+// Release a staging buffer which grew past its base size once it has
+// not been needed for a while, so a single large packet does not keep
+// its memory alive for the lifetime of the connection.
+//
+void SocketStream::trimBuffer(size_t used)
+{
+    if (!m_buf || m_bufsize <= m_baseBufsize) {
+        return;
+    }
+    if (used > m_baseBufsize) {
+        m_shrinkCount = 0;
+        return;
+    }
+    if (++m_shrinkCount > SOCKET_STREAM_SHRINK_DELAY) {
+        free(m_buf);
+        m_buf = NULL;
+        m_bufsize = m_baseBufsize;
+        m_shrinkCount = 0;
+    }
 }
 
+#ifndef _WIN32
+//
+// Send all segments with as few writev() calls as possible, resuming
+// after partial writes.
+//
+int SocketStream::writeV(const IOStreamSegment *segs, int count)
+{
+    if (!valid()) return -1;
+
+    if (count > IOSTREAM_MAX_SEGMENTS) {
+        ERR("%s: %d segments, at most %d can be sent\n", __FUNCTION__,
+            count, IOSTREAM_MAX_SEGMENTS);
+        return -1;
+    }
+
+    struct iovec iov[IOSTREAM_MAX_SEGMENTS];
+    size_t staged = 0;
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (segs[i].len == 0) {
+            continue;
+        }
+        const unsigned char *p = (const unsigned char *)segs[i].base;
+        if (m_buf && p >= m_buf && p < m_buf + m_bufsize) {
+            staged += segs[i].len;
+        }
+        iov[n].iov_base = (void *)segs[i].base;
+        iov[n].iov_len = segs[i].len;
+        n++;
+    }
+
+    int retval = 0;
+    struct iovec *cur = iov;
+    while (n > 0) {
+        ssize_t stat = ::writev(m_sock, cur, n);
+        if (stat < 0) {
+            if (errno != EINTR) {
+                retval = stat;
+                ERR("%s: failed: %s\n", __FUNCTION__, strerror(errno));
+                break;
+            }
+            continue;
+        }
+        while (n > 0 && (size_t)stat >= cur->iov_len) {
+            stat -= cur->iov_len;
+            cur++;
+            n--;
+        }
+        if (n > 0) {
+            cur->iov_base = (char *)cur->iov_base + stat;
+            cur->iov_len -= stat;
+        }
+    }
+
+    trimBuffer(staged);
+    return retval;
+}
+#endif
+
 int SocketStream::writeFully(const void* buffer, size_t size)
 {
     if (!valid()) return -1;
@@ -40,12 +40,28 @@ public:
     virtual int recv(void *buf, size_t len);
     virtual int writeFully(const void *buf, size_t len);
 
+#ifndef _WIN32
+    virtual bool canWriteV() const { return true; }
+    virtual int writeV(const IOStreamSegment *segs, int count);
+#endif
+
+    //
+    // Optional compression of the data, negotiated with the
+    // IOSTREAM_CLIENT_COMPRESS client flag. Both ends must enable it
+    // at the same point of the stream.
+    //
+    virtual bool canCompress() const { return false; }
+    virtual bool enableCompression() { return false; }
+
 protected:
     int            m_sock;
     size_t         m_bufsize;
     unsigned char *m_buf;
+    size_t         m_baseBufsize;
+    int            m_shrinkCount;
 
     SocketStream(int sock, size_t bufSize);
+    void trimBuffer(size_t used);
 };
 
 #endif /* __SOCKET_STREAM_H */
@@ -14,6 +14,8 @@
 * limitations under the License.
 */
 #include "TcpStream.h"
+#include "Lz4Block.h"
+#include <stdint.h>
 #include <cutils/sockets.h>
 #include <errno.h>
 #include <stdio.h>
@@ -30,13 +32,33 @@
 
 #define LISTEN_BACKLOG 4
 
+#define FRAME_COMPRESSED 0x80000000U
+// largest frame: both header words and a worst case compressed block
+#define FRAME_MAX_SIZE   (8 + LZ4_BLOCK_BOUND(COMPRESS_BLOCK_SIZE))
+
 TcpStream::TcpStream(size_t bufSize) :
-    SocketStream(bufSize)
+    SocketStream(bufSize),
+    m_compress(false),
+    m_frameOut(NULL),
+    m_frameIn(NULL),
+    m_inBuf(NULL),
+    m_inPos(0),
+    m_inLen(0),
+    m_bytesWritten(0),
+    m_wireBytesWritten(0)
 {
 }
 
 TcpStream::TcpStream(int sock, size_t bufSize) :
-    SocketStream(sock, bufSize)
+    SocketStream(sock, bufSize),
+    m_compress(false),
+    m_frameOut(NULL),
+    m_frameIn(NULL),
+    m_inBuf(NULL),
+    m_inPos(0),
+    m_inLen(0),
+    m_bytesWritten(0),
+    m_wireBytesWritten(0)
 {
     // disable Nagle algorithm to improve bandwidth of small
     // packets which are quite common in our implementation.
@@ -49,6 +71,13 @@ TcpStream::TcpStream(int sock, size_t bufSize) :
     setsockopt( sock, IPPROTO_TCP, TCP_NODELAY, (const char*)&flag, sizeof(flag) );
 }
 
+TcpStream::~TcpStream()
+{
+    free(m_frameOut);
+    free(m_frameIn);
+    free(m_inBuf);
+}
+
 int TcpStream::listen(char addrstr[MAX_ADDRSTR_LEN])
 {
     m_sock = socket_loopback_server(0, SOCK_STREAM);
@@ -104,3 +133,198 @@ int TcpStream::connect(const char* hostname, unsigned short port)
     if (!valid()) return -1;
     return 0;
 }
+
+bool TcpStream::enableCompression()
+{
+    if (!m_frameOut) {
+        m_frameOut = (unsigned char *)malloc(FRAME_MAX_SIZE);
+        m_frameIn = (unsigned char *)malloc(FRAME_MAX_SIZE);
+        m_inBuf = (unsigned char *)malloc(COMPRESS_BLOCK_SIZE);
+        if (!m_frameOut || !m_frameIn || !m_inBuf) {
+            ERR("TcpStream: failed to allocate compression buffers\n");
+            return false;
+        }
+    }
+    m_compress = true;
+    return true;
+}
+
+static inline void put32(unsigned char *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static inline uint32_t get32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//
+// writeFrame - send up to COMPRESS_BLOCK_SIZE bytes as a single frame
+//
+int TcpStream::writeFrame(const unsigned char *buf, size_t len)
+{
+    size_t frameLen = 0;
+    if (len >= COMPRESS_MIN_SIZE) {
+        int zlen = lz4BlockCompress(buf, len, m_frameOut + 8, len - 1);
+        if (zlen > 0) {
+            put32(m_frameOut, zlen | FRAME_COMPRESSED);
+            put32(m_frameOut + 4, len);
+            frameLen = 8 + zlen;
+        }
+    }
+    if (frameLen == 0) {
+        put32(m_frameOut, len);
+        memcpy(m_frameOut + 4, buf, len);
+        frameLen = 4 + len;
+    }
+
+    m_wireBytesWritten += frameLen;
+    return SocketStream::writeFully(m_frameOut, frameLen);
+}
+
+int TcpStream::writeFully(const void *buf, size_t len)
+{
+    if (!m_compress) {
+        m_bytesWritten += len;
+        m_wireBytesWritten += len;
+        return SocketStream::writeFully(buf, len);
+    }
+
+    m_bytesWritten += len;
+    const unsigned char *p = (const unsigned char *)buf;
+    while (len > 0) {
+        size_t n = len < COMPRESS_BLOCK_SIZE ? len : COMPRESS_BLOCK_SIZE;
+        int stat = writeFrame(p, n);
+        if (stat < 0) {
+            return stat;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+int TcpStream::writeV(const IOStreamSegment *segs, int count)
+{
+    if (!m_compress) {
+        for (int i = 0; i < count; i++) {
+            m_bytesWritten += segs[i].len;
+            m_wireBytesWritten += segs[i].len;
+        }
+        return SocketStream::writeV(segs, count);
+    }
+
+    // each segment is compressed in place, without gathering them first
+    for (int i = 0; i < count; i++) {
+        int stat = writeFully(segs[i].base, segs[i].len);
+        if (stat < 0) {
+            return stat;
+        }
+    }
+    return 0;
+}
+#endif
+
+//
+// readFrame - receive the next frame into m_inBuf
+//
+bool TcpStream::readFrame()
+{
+    unsigned char hdr[4];
+    if (!SocketStream::readFully(hdr, sizeof(hdr))) {
+        return false;
+    }
+    uint32_t size = get32(hdr);
+
+    if (!(size & FRAME_COMPRESSED)) {
+        if (size == 0 || size > COMPRESS_BLOCK_SIZE) {
+            ERR("TcpStream: bad frame size %u\n", size);
+            return false;
+        }
+        if (!SocketStream::readFully(m_inBuf, size)) {
+            return false;
+        }
+        m_inPos = 0;
+        m_inLen = size;
+        return true;
+    }
+
+    size &= ~FRAME_COMPRESSED;
+    if (!SocketStream::readFully(hdr, sizeof(hdr))) {
+        return false;
+    }
+    uint32_t rawSize = get32(hdr);
+    if (rawSize == 0 || rawSize > COMPRESS_BLOCK_SIZE ||
+        size > LZ4_BLOCK_BOUND(COMPRESS_BLOCK_SIZE)) {
+        ERR("TcpStream: bad compressed frame size %u/%u\n", size, rawSize);
+        return false;
+    }
+    if (!SocketStream::readFully(m_frameIn, size)) {
+        return false;
+    }
+    if (lz4BlockDecompress(m_frameIn, size, m_inBuf, rawSize) != (int)rawSize) {
+        ERR("TcpStream: corrupted compressed frame\n");
+        return false;
+    }
+    m_inPos = 0;
+    m_inLen = rawSize;
+    return true;
+}
+
+const unsigned char *TcpStream::read(void *buf, size_t *inout_len)
+{
+    if (!m_compress) {
+        return SocketStream::read(buf, inout_len);
+    }
+    if (!buf) {
+        return NULL;
+    }
+
+    if (m_inPos == m_inLen && !readFrame()) {
+        return NULL;
+    }
+    size_t n = m_inLen - m_inPos;
+    if (n > *inout_len) {
+        n = *inout_len;
+    }
+    memcpy(buf, m_inBuf + m_inPos, n);
+    m_inPos += n;
+    *inout_len = n;
+    return (const unsigned char *)buf;
+}
+
+const unsigned char *TcpStream::readFully(void *buf, size_t len)
+{
+    if (!m_compress) {
+        return SocketStream::readFully(buf, len);
+    }
+    if (!buf) {
+        return NULL;
+    }
+
+    size_t res = len;
+    while (res > 0) {
+        size_t n = res;
+        if (!read((unsigned char *)buf + len - res, &n)) {
+            return NULL;
+        }
+        res -= n;
+    }
+    return (const unsigned char *)buf;
+}
+
+int TcpStream::recv(void *buf, size_t len)
+{
+    if (!m_compress) {
+        return SocketStream::recv(buf, len);
+    }
+    if (!read(buf, &len)) {
+        return -1;
+    }
+    return len;
+}
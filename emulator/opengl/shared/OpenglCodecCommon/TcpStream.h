@@ -18,15 +18,55 @@
 
 #include "SocketStream.h"
 
+//
+// Once compression is enabled, the data goes through the socket in
+// frames of up to COMPRESS_BLOCK_SIZE bytes. Each frame starts with a
+// little-endian word holding the size of its payload, with the top bit
+// set when the payload is an LZ4 block, which is then preceded by another
+// word holding its decompressed size. Blocks smaller than
+// COMPRESS_MIN_SIZE, and blocks which do not shrink, are sent as they are.
+//
 class TcpStream : public SocketStream {
 public:
+    static const size_t COMPRESS_BLOCK_SIZE = 64 * 1024;
+    static const size_t COMPRESS_MIN_SIZE = 512;
+
     explicit TcpStream(size_t bufsize = 10000);
+    virtual ~TcpStream();
     virtual int listen(char addrstr[MAX_ADDRSTR_LEN]);
     virtual SocketStream *accept();
     virtual int connect(const char* addr);
     int connect(const char* hostname, unsigned short port);
+
+    virtual bool canCompress() const { return true; }
+    virtual bool enableCompression();
+
+    virtual const unsigned char *readFully(void *buf, size_t len);
+    virtual const unsigned char *read(void *buf, size_t *inout_len);
+    virtual int recv(void *buf, size_t len);
+    virtual int writeFully(const void *buf, size_t len);
+#ifndef _WIN32
+    virtual int writeV(const IOStreamSegment *segs, int count);
+#endif
+
+    // bytes written by the stream's user, and sent through the socket
+    unsigned long long bytesWritten() const { return m_bytesWritten; }
+    unsigned long long wireBytesWritten() const { return m_wireBytesWritten; }
+
 private:
     TcpStream(int sock, size_t bufSize);
+
+    int  writeFrame(const unsigned char *buf, size_t len);
+    bool readFrame();
+
+    bool           m_compress;
+    unsigned char *m_frameOut;  // frame being sent
+    unsigned char *m_frameIn;   // compressed payload being received
+    unsigned char *m_inBuf;     // decompressed data
+    size_t         m_inPos;
+    size_t         m_inLen;
+    unsigned long long m_bytesWritten;
+    unsigned long long m_wireBytesWritten;
 };
 
 #endif
@@ -17,6 +17,7 @@
 #define _TIME_UTILS_H
 
 long long GetCurrentTimeMS();
+long long GetCurrentTimeUS();
 void TimeSleepMS(int p_mili);
 
 #endif
@@ -24,7 +24,7 @@ public:
     virtual int listen(char addrstr[MAX_ADDRSTR_LEN]);
     virtual SocketStream *accept();
     virtual int connect(const char* addr);
-private:
+protected:
     UnixStream(int sock, size_t bufSize);
 };
 
@@ -0,0 +1,51 @@
+LOCAL_PATH:=$(call my-dir)
+
+# Host benchmarks comparing the decode loops of the render thread and the
+# emugen decoder backends, see decoder_bench.cpp. Each one generates its
+# own decoders with the backend it measures.
+
+decoder_bench_SRC_FILES := \
+    decoder_bench.cpp \
+    SynthGLESv1.cpp \
+    SynthGLESv2.cpp \
+    SynthRenderControl.cpp
+
+decoder_bench_C_INCLUDES := \
+    $(EMUGL_PATH)/host/libs/GLESv1_dec \
+    $(EMUGL_PATH)/host/libs/GLESv2_dec \
+    $(EMUGL_PATH)/host/libs/renderControl_dec
+
+decoder_bench_SPECS := \
+    $(EMUGL_PATH)/host/libs/GLESv1_dec/gl \
+    $(EMUGL_PATH)/host/libs/GLESv2_dec/gl2 \
+    $(EMUGL_PATH)/host/libs/renderControl_dec/renderControl
+
+### table decoder backend ################################
+$(call emugl-begin-host-executable,decoder_bench)
+$(call emugl-import,libOpenglCodecCommon)
+
+$(call emugl-gen-decoder,$(EMUGL_PATH)/host/libs/GLESv1_dec,gl,table)
+$(call emugl-gen-decoder,$(EMUGL_PATH)/host/libs/GLESv2_dec,gl2,table)
+$(call emugl-gen-decoder,$(EMUGL_PATH)/host/libs/renderControl_dec,renderControl,table)
+$(call emugl-gen-dispatcher,renderer,$(decoder_bench_SPECS))
+
+LOCAL_SRC_FILES := $(decoder_bench_SRC_FILES)
+LOCAL_C_INCLUDES += $(decoder_bench_C_INCLUDES)
+LOCAL_CFLAGS += -DDECODER_BACKEND=\"table\"
+
+$(call emugl-end-module)
+
+### switch decoder backend ###############################
+$(call emugl-begin-host-executable,decoder_bench_switch)
+$(call emugl-import,libOpenglCodecCommon)
+
+$(call emugl-gen-decoder,$(EMUGL_PATH)/host/libs/GLESv1_dec,gl,switch)
+$(call emugl-gen-decoder,$(EMUGL_PATH)/host/libs/GLESv2_dec,gl2,switch)
+$(call emugl-gen-decoder,$(EMUGL_PATH)/host/libs/renderControl_dec,renderControl,switch)
+$(call emugl-gen-dispatcher,renderer,$(decoder_bench_SPECS))
+
+LOCAL_SRC_FILES := $(decoder_bench_SRC_FILES)
+LOCAL_C_INCLUDES += $(decoder_bench_C_INCLUDES)
+LOCAL_CFLAGS += -DDECODER_BACKEND=\"switch\"
+
+$(call emugl-end-module)
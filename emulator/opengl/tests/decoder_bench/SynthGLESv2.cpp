@@ -0,0 +1,27 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#include "gl2_opcodes.h"
+#include "SynthStream.h"
+
+size_t synthGLESv2Packet(unsigned char *buf, int i)
+{
+    switch (i % 4) {
+    case 0:  return synthPacket(buf, OP_glUniform1i, 2);
+    case 1:  return synthPacket(buf, OP_glBindTexture, 2);
+    case 2:  return synthPacket(buf, OP_glDrawArrays, 3);
+    default: return synthPacket(buf, OP_glGetError, 0);
+    }
+}
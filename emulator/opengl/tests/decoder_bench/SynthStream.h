@@ -0,0 +1,46 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef _SYNTH_STREAM_H
+#define _SYNTH_STREAM_H
+
+#include <string.h>
+#include <stddef.h>
+
+//
+// Helpers building a synthetic command stream. Each API has its own
+// source file since the opcode headers of the different APIs cannot be
+// included together.
+//
+// The functions write one packet selected by 'i' into 'buf', which must
+// have room for SYNTH_MAX_PACKET bytes, and return its size.
+//
+#define SYNTH_MAX_PACKET 64
+
+size_t synthGLESv1Packet(unsigned char *buf, int i);
+size_t synthGLESv2Packet(unsigned char *buf, int i);
+size_t synthRenderControlPacket(unsigned char *buf, int i);
+
+// write a packet made of 'nargs' 32-bit arguments
+static inline size_t synthPacket(unsigned char *buf, int opcode, int nargs)
+{
+    unsigned int len = 8 + 4 * nargs;
+    memcpy(buf, &opcode, 4);
+    memcpy(buf + 4, &len, 4);
+    memset(buf + 8, 0, 4 * nargs);
+    return len;
+}
+
+#endif
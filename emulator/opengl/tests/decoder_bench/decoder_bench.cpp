@@ -0,0 +1,259 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+//
+// decoder_bench - measures how many packets per second the host decoders
+// get through when replaying a command stream, comparing the legacy loop,
+// which offers the buffer to each decoder in turn until none of them
+// makes progress, with the generated opcode-range dispatcher.
+//
+// Usage: decoder_bench [-n <iterations>] [<stream dump> ...]
+//
+// decoder_bench and decoder_bench_switch are the same program built with
+// decoders generated by the 'table' and 'switch' emugen backends, running
+// both on the same input compares the backends.
+//
+// Stream dumps are the files written by the renderer when the
+// RENDERER_DUMP_DIR environment variable is set. Without any, a
+// synthetic stream interleaving GLESv1, GLESv2 and renderControl
+// packets is used. The decoders dispatch to no-op functions, so only
+// the decoding itself is measured.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "IOStream.h"
+#include "TimeUtils.h"
+#include "renderer_dispatch.h"
+#include "SynthStream.h"
+
+// amount of data made available to the decoders at once, like the
+// render thread's reads from its stream.
+#define READ_CHUNK (64 * 1024)
+
+#ifndef DECODER_BACKEND
+#define DECODER_BACKEND "default"
+#endif
+#define SYNTH_PACKETS (256 * 1024)
+
+//
+// A stream which discards the decoder replies.
+//
+class NullStream : public IOStream {
+public:
+    NullStream() : IOStream(16 * 1024) {}
+
+    virtual void *allocBuffer(size_t minSize) {
+        if (m_data.size() < minSize) {
+            m_data.resize(minSize);
+        }
+        return &m_data[0];
+    }
+    virtual int commitBuffer(size_t size) { return 0; }
+    virtual const unsigned char *readFully(void *buf, size_t len) { return NULL; }
+    virtual const unsigned char *read(void *buf, size_t *inout_len) { return NULL; }
+    virtual int writeFully(const void *buf, size_t len) { return 0; }
+
+private:
+    std::vector<unsigned char> m_data;
+};
+
+static int noopProc()
+{
+    return 0;
+}
+
+static void *getNoopProc(const char *name, void *userData)
+{
+    return (void *)noopProc;
+}
+
+struct Decoders {
+    gl_decoder_context_t            gl;
+    gl2_decoder_context_t           gl2;
+    renderControl_decoder_context_t rc;
+    renderer_dispatch_t             dispatch;
+    NullStream                      stream;
+
+    Decoders() {
+        gl.initDispatchByName(getNoopProc, NULL);
+        gl2.initDispatchByName(getNoopProc, NULL);
+        rc.initDispatchByName(getNoopProc, NULL);
+        dispatch.m_gl = &gl;
+        dispatch.m_gl2 = &gl2;
+        dispatch.m_renderControl = &rc;
+    }
+};
+
+typedef size_t (*DecodeFunc)(Decoders *d, unsigned char *buf, size_t len);
+
+static size_t decodeProbing(Decoders *d, unsigned char *buf, size_t len)
+{
+    size_t pos = 0;
+    bool progress;
+    do {
+        progress = false;
+        size_t last = d->gl.decode(buf + pos, len - pos, &d->stream);
+        if (last > 0) {
+            pos += last;
+            progress = true;
+        }
+        last = d->gl2.decode(buf + pos, len - pos, &d->stream);
+        if (last > 0) {
+            pos += last;
+            progress = true;
+        }
+        last = d->rc.decode(buf + pos, len - pos, &d->stream);
+        if (last > 0) {
+            pos += last;
+            progress = true;
+        }
+    } while (progress);
+    return pos;
+}
+
+static size_t decodeDispatch(Decoders *d, unsigned char *buf, size_t len)
+{
+    return d->dispatch.decode(buf, len, &d->stream);
+}
+
+//
+// Decode the whole stream once, READ_CHUNK bytes at a time. Returns
+// false if the decoders got stuck on a packet they do not know.
+//
+static bool replay(Decoders *d, DecodeFunc decode, std::vector<unsigned char> &data)
+{
+    size_t pos = 0;
+    size_t end = 0;
+    while (pos < data.size()) {
+        end = end + READ_CHUNK < data.size() ? end + READ_CHUNK : data.size();
+        size_t last = decode(d, &data[pos], end - pos);
+        if (last == 0 && end == data.size()) {
+            fprintf(stderr, "Unknown opcode %d at offset %zu\n",
+                    *(int *)&data[pos], pos);
+            return false;
+        }
+        pos += last;
+    }
+    return true;
+}
+
+static size_t countPackets(std::vector<unsigned char> &data)
+{
+    size_t n = 0;
+    for (size_t pos = 0; pos + 8 <= data.size(); n++) {
+        unsigned int len = *(unsigned int *)&data[pos + 4];
+        if (len < 8) {
+            break;
+        }
+        pos += len;
+    }
+    return n;
+}
+
+static bool readFile(const char *filename, std::vector<unsigned char> &data)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) {
+        perror(filename);
+        return false;
+    }
+    unsigned char buf[64 * 1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(fp);
+    return true;
+}
+
+//
+// Short runs of packets of a random API, as a guest mixing GLESv2
+// drawing with some GLESv1 and renderControl calls would produce.
+//
+static void synthesize(std::vector<unsigned char> &data)
+{
+    unsigned char packet[SYNTH_MAX_PACKET];
+    srand(1);
+    int i = 0;
+    while (i < SYNTH_PACKETS) {
+        int api = rand() % 10;
+        int run = 1 + rand() % 4;
+        for (int j = 0; j < run; j++, i++) {
+            size_t len;
+            if (api < 6) {
+                len = synthGLESv2Packet(packet, rand());
+            } else if (api < 8) {
+                len = synthGLESv1Packet(packet, rand());
+            } else {
+                len = synthRenderControlPacket(packet, rand());
+            }
+            data.insert(data.end(), packet, packet + len);
+        }
+    }
+}
+
+static double measure(const char *name, DecodeFunc decode,
+                      std::vector<unsigned char> &data, size_t packets,
+                      int iterations)
+{
+    Decoders d;
+    long long t0 = GetCurrentTimeMS();
+    for (int i = 0; i < iterations; i++) {
+        if (!replay(&d, decode, data)) {
+            return 0.0;
+        }
+    }
+    long long dt = GetCurrentTimeMS() - t0;
+    if (dt <= 0) {
+        dt = 1;
+    }
+    double rate = (double)packets * iterations * 1000.0 / dt;
+    printf("%-10s %8lld ms  %8.2f Mpackets/s\n", name, dt, rate / 1e6);
+    return rate;
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = 50;
+    int first = 1;
+    if (argc > 2 && !strcmp(argv[1], "-n")) {
+        iterations = atoi(argv[2]);
+        first = 3;
+    }
+
+    std::vector<unsigned char> data;
+    if (first < argc) {
+        for (int i = first; i < argc; i++) {
+            if (!readFile(argv[i], data)) {
+                return 1;
+            }
+        }
+    } else {
+        synthesize(data);
+    }
+
+    size_t packets = countPackets(data);
+    printf("%s decoders: %zu packets, %zu bytes, %d iterations\n",
+           DECODER_BACKEND, packets, data.size(), iterations);
+
+    double probing = measure("probing", decodeProbing, data, packets, iterations);
+    double dispatch = measure("dispatch", decodeDispatch, data, packets, iterations);
+    if (probing > 0.0 && dispatch > 0.0) {
+        printf("speedup: %.2fx\n", dispatch / probing);
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+LOCAL_PATH:=$(call my-dir)
+
+# Host tests of the FrameBuffer, see framebuffer_tests.cpp
+$(call emugl-begin-host-executable,framebuffer_tests)
+$(call emugl-import,libOpenglRender)
+
+LOCAL_SRC_FILES := framebuffer_tests.cpp
+
+# use Translator's egl/gles headers
+LOCAL_C_INCLUDES += $(EMUGL_PATH)/host/libs/Translator/include
+
+ifeq ($(HOST_OS),linux)
+LOCAL_LDLIBS += -lX11
+endif
+
+$(call emugl-end-module)
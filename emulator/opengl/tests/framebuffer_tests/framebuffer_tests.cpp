@@ -0,0 +1,250 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+//
+// framebuffer_tests - checks what a headless FrameBuffer delivers to its
+// post callbacks. Prints one line per test and exits non-zero if any of
+// them fails.
+//
+// Usage: framebuffer_tests
+//
+#include "libOpenglRender/render_api.h"
+#include "FrameBuffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <X11/Xlib.h>
+#endif
+
+#define FB_WIDTH  64
+#define FB_HEIGHT 64
+
+struct PostResult {
+    int frames;
+    int numRects;
+    RenderRect rects[DAMAGE_REGION_MAX_RECTS];
+};
+
+static void onPostRegion(void* context, int width, int height, int ydir,
+                         int format, int type,
+                         int numRects, const RenderRect* rects,
+                         const unsigned char* pixels)
+{
+    PostResult *result = (PostResult *)context;
+    result->frames++;
+    result->numRects = numRects < DAMAGE_REGION_MAX_RECTS ? numRects : DAMAGE_REGION_MAX_RECTS;
+    memcpy(result->rects, rects, result->numRects * sizeof(RenderRect));
+}
+
+static int damageArea(const PostResult &result)
+{
+    int area = 0;
+    for (int i = 0; i < result.numRects; i++) {
+        area += result.rects[i].width * result.rects[i].height;
+    }
+    return area;
+}
+
+static bool damageCovers(const PostResult &result, int x, int y, int w, int h)
+{
+    for (int i = 0; i < result.numRects; i++) {
+        const RenderRect &r = result.rects[i];
+        if (r.x <= x && r.y <= y &&
+            r.x + r.width >= x + w && r.y + r.height >= y + h) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void fill(FrameBuffer *fb, HandleType cb, int x, int y, int w, int h,
+                 unsigned char value)
+{
+    unsigned char *pixels = (unsigned char *)malloc(w * h * 4);
+    memset(pixels, value, w * h * 4);
+    fb->updateColorBuffer(cb, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    free(pixels);
+}
+
+//
+// Two color buffers swapped by the guest: once both were read back, each
+// post reads what changed in the posted buffer and in the other one.
+//
+static bool testSwappedPostDamage(FrameBuffer *fb)
+{
+    PostResult result;
+    memset(&result, 0, sizeof(result));
+    fb->setPostRegionCallback(onPostRegion, &result);
+
+    HandleType a = fb->createColorBuffer(FB_WIDTH, FB_HEIGHT, GL_RGBA);
+    HandleType b = fb->createColorBuffer(FB_WIDTH, FB_HEIGHT, GL_RGBA);
+    if (!a || !b) {
+        printf("    failed to create the color buffers\n");
+        return false;
+    }
+    fill(fb, a, 0, 0, FB_WIDTH, FB_HEIGHT, 0x10);
+    fill(fb, b, 0, 0, FB_WIDTH, FB_HEIGHT, 0x20);
+
+    bool ok = true;
+    fb->post(a);
+    fb->post(b);
+    if (result.frames != 2 || damageArea(result) != FB_WIDTH * FB_HEIGHT) {
+        printf("    first post of a color buffer is not read whole\n");
+        ok = false;
+    }
+
+    // b was uploaded whole after a was read back
+    fill(fb, a, 4, 4, 8, 8, 0x30);
+    fb->post(a);
+    if (damageArea(result) != FB_WIDTH * FB_HEIGHT) {
+        printf("    post after a whole upload of the other buffer is partial\n");
+        ok = false;
+    }
+
+    fill(fb, b, 20, 20, 8, 8, 0x40);
+    fb->post(b);
+    if (!damageCovers(result, 20, 20, 8, 8) || !damageCovers(result, 4, 4, 8, 8) ||
+        damageArea(result) != 2 * 8 * 8) {
+        printf("    swapped post reads %d pixels, expected %d\n",
+               damageArea(result), 2 * 8 * 8);
+        ok = false;
+    }
+
+    fill(fb, a, 40, 40, 4, 4, 0x50);
+    fb->post(a);
+    if (!damageCovers(result, 40, 40, 4, 4) || !damageCovers(result, 20, 20, 8, 8) ||
+        damageArea(result) != 4 * 4 + 8 * 8) {
+        printf("    swapped post reads %d pixels, expected %d\n",
+               damageArea(result), 4 * 4 + 8 * 8);
+        ok = false;
+    }
+
+    fb->post(b);
+    if (!damageCovers(result, 40, 40, 4, 4) || damageArea(result) != 4 * 4) {
+        printf("    unchanged buffer reads %d pixels, expected %d\n",
+               damageArea(result), 4 * 4);
+        ok = false;
+    }
+
+    fb->setPostRegionCallback(NULL, NULL);
+    fb->closeColorBuffer(a);
+    fb->closeColorBuffer(b);
+    return ok;
+}
+
+struct PostImage {
+    int frames;
+    unsigned char pixel[4];    // at the center of the frame
+};
+
+static void onPost(void* context, int width, int height, int ydir,
+                   int format, int type, unsigned char* pixels)
+{
+    PostImage *image = (PostImage *)context;
+    image->frames++;
+    memcpy(image->pixel, pixels + ((height / 2) * width + width / 2) * 4, 4);
+}
+
+//
+// A COMPOSE_BLEND_NONE layer is drawn opaque whatever its plane alpha.
+//
+static bool testComposeBlendNone(FrameBuffer *fb)
+{
+    PostImage image;
+    memset(&image, 0, sizeof(image));
+    fb->setPostCallback(onPost, &image);
+
+    HandleType cb = fb->createColorBuffer(FB_WIDTH, FB_HEIGHT, GL_RGBA);
+    if (!cb) {
+        printf("    failed to create the color buffer\n");
+        return false;
+    }
+    fill(fb, cb, 0, 0, FB_WIDTH, FB_HEIGHT, 0xc0);
+
+    rcComposeLayer layer;
+    memset(&layer, 0, sizeof(layer));
+    layer.colorBuffer = cb;
+    layer.srcRight = layer.dstRight = FB_WIDTH;
+    layer.srcBottom = layer.dstBottom = FB_HEIGHT;
+    layer.blendMode = COMPOSE_BLEND_NONE;
+    layer.alpha = 0.5f;
+
+    bool ok = true;
+    if (!fb->compose(&layer, 1) || image.frames != 1) {
+        printf("    compose did not post a frame\n");
+        ok = false;
+    }
+    else if (abs(image.pixel[0] - 0xc0) > 1 || abs(image.pixel[1] - 0xc0) > 1 ||
+             abs(image.pixel[2] - 0xc0) > 1) {
+        printf("    layer drawn as %02x%02x%02x, expected %02x%02x%02x\n",
+               image.pixel[0], image.pixel[1], image.pixel[2],
+               0xc0, 0xc0, 0xc0);
+        ok = false;
+    }
+
+    fb->setPostCallback(NULL, NULL);
+    fb->closeColorBuffer(cb);
+    return ok;
+}
+
+struct Test {
+    const char *name;
+    bool (*run)(FrameBuffer *fb);
+};
+
+static const Test s_tests[] = {
+    { "swapped post damage", testSwappedPostDamage },
+    { "compose blend none", testComposeBlendNone },
+};
+static const int s_numTests = sizeof(s_tests) / sizeof(s_tests[0]);
+
+int main(int argc, char *argv[])
+{
+#ifdef __linux__
+    XInitThreads();
+#endif
+
+    // frames are posted and read back from the calling thread
+#ifndef _WIN32
+    setenv("RENDERER_SYNC_POST", "1", 1);
+    unsetenv("RENDERER_ASYNC_READBACK");
+#endif
+
+    if (!initLibrary()) {
+        fprintf(stderr, "Failed to load the GLES translator libraries\n");
+        return -1;
+    }
+
+    if (!FrameBuffer::initialize(FB_WIDTH, FB_HEIGHT, true)) {
+        fprintf(stderr, "Failed to initialize Framebuffer\n");
+        return -1;
+    }
+    FrameBuffer *fb = FrameBuffer::getFB();
+
+    int failed = 0;
+    for (int i = 0; i < s_numTests; i++) {
+        bool ok = s_tests[i].run(fb);
+        printf("%s: %s\n", s_tests[i].name, ok ? "PASS" : "FAIL");
+        if (!ok) {
+            failed++;
+        }
+    }
+
+    FrameBuffer::finalize();
+    return failed ? 1 : 0;
+}
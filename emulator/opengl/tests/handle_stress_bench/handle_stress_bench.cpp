@@ -0,0 +1,213 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+//
+// handle_stress_bench - runs the handle traffic of many guest clients on
+// one FrameBuffer, each client from a thread of its own as the render
+// threads do, and reports how the call rate scales with the number of
+// clients. Each client loops over:
+//
+//  - open, check and close of color buffers shared by all the clients,
+//  - creating and destroying a render context and a window surface,
+//  - every CREATE_INTERVAL loops, creating and closing a color buffer
+//    of its own, which takes the FrameBuffer lock.
+//
+// Stale handles are checked to be refused along the way.
+//
+// Usage: handle_stress_bench [-soft] [-threads <max>] [-loops <count>]
+//
+#include "libOpenglRender/render_api.h"
+#include "FrameBuffer.h"
+#include "FBConfig.h"
+#include "TimeUtils.h"
+#include "osThread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <X11/Xlib.h>
+#endif
+
+#define DEFAULT_MAX_THREADS 32
+#define DEFAULT_LOOPS       2000
+#define SHARED_BUFFERS      64
+#define CREATE_INTERVAL     16
+
+static HandleType s_shared[SHARED_BUFFERS];
+
+class Client : public osUtils::Thread
+{
+public:
+    Client(int id, int loops) :
+        m_id(id), m_loops(loops), m_calls(0), m_errors(0) {}
+
+    virtual int Main() {
+        FrameBuffer *fb = FrameBuffer::getFB();
+        int config = 0;
+        for (int i = 0; i < m_loops; i++) {
+            HandleType cb = s_shared[(m_id + i) % SHARED_BUFFERS];
+            fb->openColorBuffer(cb);
+            if (!fb->hasColorBuffer(cb)) {
+                m_errors++;
+            }
+            fb->closeColorBuffer(cb);
+            m_calls += 3;
+
+            HandleType ctx = fb->createRenderContext(config, 0, false);
+            HandleType win = fb->createWindowSurface(config, 16, 16);
+            if (!ctx || !win) {
+                m_errors++;
+            }
+            fb->DestroyWindowSurface(win);
+            fb->DestroyRenderContext(ctx);
+            if (fb->bindContext(ctx, win, win)) {
+                m_errors++;
+            }
+            m_calls += 5;
+
+            if (i % CREATE_INTERVAL == 0) {
+                HandleType own = fb->createColorBuffer(16, 16, GL_RGBA);
+                if (!own) {
+                    m_errors++;
+                }
+                fb->closeColorBuffer(own);
+                if (fb->hasColorBuffer(own)) {
+                    m_errors++;
+                }
+                m_calls += 3;
+            }
+        }
+        return 0;
+    }
+
+    unsigned int calls() const { return m_calls; }
+    unsigned int errors() const { return m_errors; }
+
+private:
+    int m_id;
+    int m_loops;
+    unsigned int m_calls;
+    unsigned int m_errors;
+};
+
+static bool run(int numThreads, int loops, double *callsPerSec)
+{
+    Client **clients = new Client*[numThreads];
+    for (int i = 0; i < numThreads; i++) {
+        clients[i] = new Client(i, loops);
+    }
+
+    long long t0 = GetCurrentTimeUS();
+    for (int i = 0; i < numThreads; i++) {
+        clients[i]->start();
+    }
+    unsigned int calls = 0;
+    unsigned int errors = 0;
+    for (int i = 0; i < numThreads; i++) {
+        int status;
+        clients[i]->wait(&status);
+        calls += clients[i]->calls();
+        errors += clients[i]->errors();
+        delete clients[i];
+    }
+    double secs = (GetCurrentTimeUS() - t0) / 1000000.0;
+    delete [] clients;
+
+    if (errors) {
+        fprintf(stderr, "%d threads: %u calls failed or accepted a stale handle\n",
+                numThreads, errors);
+        return false;
+    }
+    *callsPerSec = calls / secs;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int maxThreads = DEFAULT_MAX_THREADS;
+    int loops = DEFAULT_LOOPS;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-soft")) {
+#ifndef _WIN32
+            setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+#endif
+        }
+        else if (!strcmp(argv[i], "-threads") && i + 1 < argc) {
+            maxThreads = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-loops") && i + 1 < argc) {
+            loops = atoi(argv[++i]);
+        }
+        else {
+            fprintf(stderr, "Usage: %s [-soft] [-threads <max>] [-loops <count>]\n",
+                    argv[0]);
+            return -1;
+        }
+    }
+    if (maxThreads <= 0) {
+        maxThreads = DEFAULT_MAX_THREADS;
+    }
+    if (loops <= 0) {
+        loops = DEFAULT_LOOPS;
+    }
+
+#ifdef __linux__
+    XInitThreads();
+#endif
+
+    if (!initLibrary()) {
+        fprintf(stderr, "Failed to load the GLES translator libraries\n");
+        return -1;
+    }
+    if (!FrameBuffer::initialize(64, 64)) {
+        fprintf(stderr, "Failed to initialize Framebuffer\n");
+        return -1;
+    }
+    FrameBuffer *fb = FrameBuffer::getFB();
+    if (FBConfig::getNumConfigs() == 0) {
+        fprintf(stderr, "No usable config\n");
+        return -1;
+    }
+
+    for (int i = 0; i < SHARED_BUFFERS; i++) {
+        s_shared[i] = fb->createColorBuffer(16, 16, GL_RGBA);
+        if (!s_shared[i]) {
+            fprintf(stderr, "Failed to create a color buffer\n");
+            return -1;
+        }
+    }
+
+    printf("%d loops per thread\n", loops);
+    double single = 0.0;
+    for (int n = 1; n <= maxThreads; n *= 2) {
+        double rate;
+        if (!run(n, loops, &rate)) {
+            return -1;
+        }
+        if (n == 1) {
+            single = rate;
+        }
+        printf("    %3d threads: %10.0f calls/s, %5.2fx one thread\n",
+               n, rate, rate / single);
+    }
+
+    for (int i = 0; i < SHARED_BUFFERS; i++) {
+        fb->closeColorBuffer(s_shared[i]);
+    }
+    FrameBuffer::finalize();
+    return 0;
+}
@@ -0,0 +1,16 @@
+LOCAL_PATH:=$(call my-dir)
+
+# Host benchmark of the color buffer readback, see readback_bench.cpp
+$(call emugl-begin-host-executable,readback_bench)
+$(call emugl-import,libOpenglRender)
+
+LOCAL_SRC_FILES := readback_bench.cpp
+
+# use Translator's egl/gles headers
+LOCAL_C_INCLUDES += $(EMUGL_PATH)/host/libs/Translator/include
+
+ifeq ($(HOST_OS),linux)
+LOCAL_LDLIBS += -lX11
+endif
+
+$(call emugl-end-module)
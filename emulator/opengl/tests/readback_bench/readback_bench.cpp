@@ -0,0 +1,146 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+//
+// readback_bench - measures the color buffer readback behind
+// rcReadColorBuffer at common screen resolutions: whole buffers in
+// RGBA8888 and RGB565, and a quarter of the buffer. The numbers include
+// the format conversion done by GL but not the transfer to the guest.
+//
+// Usage: readback_bench [-soft] [-frames <count>]
+//
+#include "libOpenglRender/render_api.h"
+#include "FrameBuffer.h"
+#include "TimeUtils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <X11/Xlib.h>
+#endif
+
+#define DEFAULT_FRAMES 100
+
+struct Resolution {
+    int width;
+    int height;
+};
+
+static const Resolution s_resolutions[] = {
+    { 320, 480 },
+    { 480, 800 },
+    { 720, 1280 },
+    { 1080, 1920 },
+};
+static const int s_numResolutions = sizeof(s_resolutions) / sizeof(s_resolutions[0]);
+
+static void bench(FrameBuffer *fb, HandleType cb, const char *name,
+                  int x, int y, int width, int height,
+                  GLenum format, GLenum type, int bpp, int frames,
+                  unsigned char *pixels)
+{
+    // the first read may allocate the framebuffer object
+    if (!fb->readColorBuffer(cb, x, y, width, height, format, type, pixels)) {
+        printf("    %-14s failed\n", name);
+        return;
+    }
+
+    long long t0 = GetCurrentTimeUS();
+    for (int i = 0; i < frames; i++) {
+        fb->readColorBuffer(cb, x, y, width, height, format, type, pixels);
+    }
+    double secs = (GetCurrentTimeUS() - t0) / 1000000.0;
+
+    double mb = (double)width * height * bpp * frames / (1024.0 * 1024.0);
+    printf("    %-14s %8.3f ms/read %9.1f MB/s %8.1f reads/s\n", name,
+           secs * 1000.0 / frames, mb / secs, frames / secs);
+}
+
+int main(int argc, char *argv[])
+{
+    int frames = DEFAULT_FRAMES;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-soft")) {
+#ifndef _WIN32
+            setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+#endif
+        }
+        else if (!strcmp(argv[i], "-frames") && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        }
+        else {
+            fprintf(stderr, "Usage: %s [-soft] [-frames <count>]\n", argv[0]);
+            return -1;
+        }
+    }
+    if (frames <= 0) {
+        frames = DEFAULT_FRAMES;
+    }
+
+#ifdef __linux__
+    XInitThreads();
+#endif
+
+    if (!initLibrary()) {
+        fprintf(stderr, "Failed to load the GLES translator libraries\n");
+        return -1;
+    }
+
+    const Resolution &largest = s_resolutions[s_numResolutions - 1];
+    if (!FrameBuffer::initialize(largest.width, largest.height)) {
+        fprintf(stderr, "Failed to initialize Framebuffer\n");
+        return -1;
+    }
+    FrameBuffer *fb = FrameBuffer::getFB();
+
+    unsigned char *pixels = (unsigned char *)malloc(largest.width * largest.height * 4);
+    if (!pixels) {
+        fprintf(stderr, "Out of memory\n");
+        return -1;
+    }
+
+    for (int r = 0; r < s_numResolutions; r++) {
+        int w = s_resolutions[r].width;
+        int h = s_resolutions[r].height;
+
+        HandleType cb = fb->createColorBuffer(w, h, GL_RGBA);
+        if (!cb) {
+            fprintf(stderr, "Failed to create a %dx%d color buffer\n", w, h);
+            return -1;
+        }
+
+        // something other than the initial zeros
+        for (int i = 0; i < w * h * 4; i++) {
+            pixels[i] = (unsigned char)(i * 7);
+        }
+        fb->updateColorBuffer(cb, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+        printf("%dx%d:\n", w, h);
+        bench(fb, cb, "RGBA8888", 0, 0, w, h,
+              GL_RGBA, GL_UNSIGNED_BYTE, 4, frames, pixels);
+        bench(fb, cb, "RGB565", 0, 0, w, h,
+              GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 2, frames, pixels);
+        bench(fb, cb, "RGBA8888 1/4", w / 4, h / 4, w / 2, h / 2,
+              GL_RGBA, GL_UNSIGNED_BYTE, 4, frames, pixels);
+
+        fb->closeColorBuffer(cb);
+    }
+
+    free(pixels);
+    FrameBuffer::finalize();
+    return 0;
+}
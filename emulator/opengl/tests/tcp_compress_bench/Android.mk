@@ -0,0 +1,13 @@
+LOCAL_PATH:=$(call my-dir)
+
+# Host benchmark of the TcpStream compression, see tcp_compress_bench.cpp
+$(call emugl-begin-host-executable,tcp_compress_bench)
+$(call emugl-import,libOpenglCodecCommon libOpenglOsUtils)
+
+LOCAL_SRC_FILES := tcp_compress_bench.cpp
+
+ifeq ($(HOST_OS),windows)
+LOCAL_LDLIBS += -lws2_32
+endif
+
+$(call emugl-end-module)
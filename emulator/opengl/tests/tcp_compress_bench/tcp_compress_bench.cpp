@@ -0,0 +1,217 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+//
+// tcp_compress_bench - measures what the TcpStream compression gains on
+// streams captured with RENDERER_DUMP_DIR. For each capture it reports:
+//
+//  - the compression ratio, as sent through the socket,
+//  - the speed of the LZ4 block compressor and decompressor alone,
+//  - the time and CPU time taken to send the capture through a loopback
+//    TcpStream connection, with and without compression.
+//
+// Usage: tcp_compress_bench [-c <write size>] <stream dump> ...
+//
+#include "TcpStream.h"
+#include "Lz4Block.h"
+#include "TimeUtils.h"
+#include "osThread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_WRITE_SIZE (16 * 1024)
+#define CODEC_ITERATIONS   10
+
+static const double MB = 1024.0 * 1024.0;
+
+//
+// Sink - reads everything a connection sends until it is closed
+//
+class Sink : public osUtils::Thread
+{
+public:
+    Sink(SocketStream *stream) : m_stream(stream), m_bytes(0) {}
+    ~Sink() { delete m_stream; }
+
+    virtual int Main() {
+        static unsigned char buf[256 * 1024];
+        while (1) {
+            size_t len = sizeof(buf);
+            if (!m_stream->read(buf, &len)) {
+                break;
+            }
+            m_bytes += len;
+        }
+        return 0;
+    }
+
+    size_t bytes() const { return m_bytes; }
+
+private:
+    SocketStream *m_stream;
+    size_t m_bytes;
+};
+
+static unsigned char *loadFile(const char *name, size_t *size)
+{
+    FILE *fp = fopen(name, "rb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s\n", name);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    unsigned char *data = len > 0 ? (unsigned char *)malloc(len) : NULL;
+    if (!data || fread(data, 1, len, fp) != (size_t)len) {
+        fprintf(stderr, "Failed to read %s\n", name);
+        free(data);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+    *size = len;
+    return data;
+}
+
+//
+// benchCodec - compress and decompress the data in blocks of the size
+// TcpStream uses, reporting the speed of each side.
+//
+static void benchCodec(const unsigned char *data, size_t size)
+{
+    const size_t block = TcpStream::COMPRESS_BLOCK_SIZE;
+    unsigned char *z = (unsigned char *)malloc(LZ4_BLOCK_BOUND(block));
+    unsigned char *out = (unsigned char *)malloc(block);
+
+    long long compressUS = 0;
+    long long decompressUS = 0;
+    for (int it = 0; it < CODEC_ITERATIONS; it++) {
+        for (size_t pos = 0; pos < size; pos += block) {
+            size_t n = size - pos < block ? size - pos : block;
+            long long t0 = GetCurrentTimeUS();
+            int zn = lz4BlockCompress(data + pos, n, z, LZ4_BLOCK_BOUND(block));
+            long long t1 = GetCurrentTimeUS();
+            if (lz4BlockDecompress(z, zn, out, n) != (int)n) {
+                fprintf(stderr, "Decompression failed\n");
+                exit(1);
+            }
+            compressUS += t1 - t0;
+            decompressUS += GetCurrentTimeUS() - t1;
+        }
+    }
+
+    double total = (double)size * CODEC_ITERATIONS / MB;
+    printf("    codec:      compress %8.1f MB/s, decompress %8.1f MB/s\n",
+           total / (compressUS / 1000000.0 + 1e-9),
+           total / (decompressUS / 1000000.0 + 1e-9));
+    free(z);
+    free(out);
+}
+
+//
+// benchStream - send the data through a loopback connection
+//
+static bool benchStream(const unsigned char *data, size_t size,
+                        size_t writeSize, bool compress)
+{
+    TcpStream server;
+    char addr[SocketStream::MAX_ADDRSTR_LEN];
+    if (server.listen(addr) < 0) {
+        fprintf(stderr, "Failed to listen\n");
+        return false;
+    }
+    TcpStream *client = new TcpStream();
+    if (client->connect(addr) < 0) {
+        fprintf(stderr, "Failed to connect to %s\n", addr);
+        delete client;
+        return false;
+    }
+    SocketStream *peer = server.accept();
+    if (!peer) {
+        fprintf(stderr, "Failed to accept\n");
+        delete client;
+        return false;
+    }
+    if (compress) {
+        client->enableCompression();
+        peer->enableCompression();
+    }
+
+    Sink sink(peer);
+    sink.start();
+
+    long long t0 = GetCurrentTimeUS();
+    clock_t c0 = clock();
+    for (size_t pos = 0; pos < size; pos += writeSize) {
+        size_t n = size - pos < writeSize ? size - pos : writeSize;
+        if (client->writeFully(data + pos, n) < 0) {
+            fprintf(stderr, "Write failed\n");
+            break;
+        }
+    }
+    unsigned long long wire = client->wireBytesWritten();
+    delete client;
+
+    int status;
+    sink.wait(&status);
+    double secs = (GetCurrentTimeUS() - t0) / 1000000.0;
+    double cpu = (double)(clock() - c0) / CLOCKS_PER_SEC;
+
+    if (sink.bytes() != size) {
+        fprintf(stderr, "Received %zu bytes out of %zu\n", sink.bytes(), size);
+        return false;
+    }
+    printf("    %-11s %7.3f MB on the wire (%5.1f%%), %8.1f MB/s, %6.2f ms CPU/MB\n",
+           compress ? "compressed:" : "plain:", wire / MB,
+           100.0 * wire / size, size / MB / secs, cpu * 1000.0 / (size / MB));
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t writeSize = DEFAULT_WRITE_SIZE;
+    int first = 1;
+
+    if (argc > 2 && !strcmp(argv[1], "-c")) {
+        writeSize = atoi(argv[2]);
+        first = 3;
+    }
+    if (first >= argc || writeSize == 0) {
+        fprintf(stderr, "Usage: %s [-c <write size>] <stream dump> ...\n", argv[0]);
+        return -1;
+    }
+
+    for (int i = first; i < argc; i++) {
+        size_t size;
+        unsigned char *data = loadFile(argv[i], &size);
+        if (!data) {
+            return -1;
+        }
+        printf("%s: %.3f MB, written %zu bytes at a time\n",
+               argv[i], size / MB, writeSize);
+        benchCodec(data, size);
+        if (!benchStream(data, size, writeSize, false) ||
+            !benchStream(data, size, writeSize, true)) {
+            free(data);
+            return -1;
+        }
+        free(data);
+    }
+    return 0;
+}
@@ -377,6 +377,10 @@ void *RenderingThread::thread()
                 }
             }
         }
+
+        // the decoders do not flush their replies, send them all
+        // before waiting for more commands
+        m_stream->flush();
     }
     // shutdown
     if (m_currentContext != NULL) {
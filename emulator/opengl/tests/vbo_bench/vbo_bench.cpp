@@ -0,0 +1,241 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+//
+// vbo_bench - draws an indexed grid of GRID_SIZE x GRID_SIZE quads
+// through the GLES 1.1 translator, from client arrays and from buffer
+// objects, and reports the wall and CPU time of a draw. The client
+// column is the vertex and index data handed to the host driver with
+// each draw: client arrays are copied by the driver on every draw,
+// buffer objects are read from the GPU. GL_FIXED positions are converted
+// once and then drawn like float ones, from client arrays too once the
+// translator has seen them twice. The rewritten case changes a vertex
+// before each draw, so its client arrays are converted every time.
+//
+// Usage: vbo_bench [-soft] [-draws <count>]
+//
+#include "libOpenglRender/render_api.h"
+#include "FrameBuffer.h"
+#include "ThreadInfo.h"
+#include "GLDispatch.h"
+#include "TimeUtils.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <X11/Xlib.h>
+#endif
+
+#define DEFAULT_DRAWS 200
+#define GRID_SIZE     128
+#define SURFACE_SIZE  256
+
+#define NUM_VERTICES  ((GRID_SIZE + 1) * (GRID_SIZE + 1))
+#define NUM_INDICES   (GRID_SIZE * GRID_SIZE * 6)
+
+struct Vertex {
+    GLfloat pos[3];
+    GLfloat tex[2];
+    GLubyte color[4];
+};
+
+// same layout, with the positions in 16.16 fixed point
+struct FixedVertex {
+    GLfixed pos[3];
+    GLfloat tex[2];
+    GLubyte color[4];
+};
+
+static Vertex s_vertices[NUM_VERTICES];
+static FixedVertex s_fixedVertices[NUM_VERTICES];
+static GLushort s_indices[NUM_INDICES];
+
+static void buildGrid()
+{
+    int v = 0;
+    for (int y = 0; y <= GRID_SIZE; y++) {
+        for (int x = 0; x <= GRID_SIZE; x++, v++) {
+            GLfloat fx = (GLfloat)x / GRID_SIZE * 2.0f - 1.0f;
+            GLfloat fy = (GLfloat)y / GRID_SIZE * 2.0f - 1.0f;
+            s_vertices[v].pos[0] = fx;
+            s_vertices[v].pos[1] = fy;
+            s_vertices[v].pos[2] = 0.0f;
+            s_vertices[v].tex[0] = (GLfloat)x / GRID_SIZE;
+            s_vertices[v].tex[1] = (GLfloat)y / GRID_SIZE;
+            s_vertices[v].color[0] = (GLubyte)(x * 2);
+            s_vertices[v].color[1] = (GLubyte)(y * 2);
+            s_vertices[v].color[2] = 0x80;
+            s_vertices[v].color[3] = 0xff;
+
+            s_fixedVertices[v].pos[0] = (GLfixed)(fx * 65536.0f);
+            s_fixedVertices[v].pos[1] = (GLfixed)(fy * 65536.0f);
+            s_fixedVertices[v].pos[2] = 0;
+            memcpy(s_fixedVertices[v].tex, s_vertices[v].tex, sizeof(s_vertices[v].tex));
+            memcpy(s_fixedVertices[v].color, s_vertices[v].color, sizeof(s_vertices[v].color));
+        }
+    }
+
+    int i = 0;
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            GLushort v0 = y * (GRID_SIZE + 1) + x;
+            GLushort v1 = v0 + GRID_SIZE + 1;
+            s_indices[i++] = v0;
+            s_indices[i++] = v0 + 1;
+            s_indices[i++] = v1;
+            s_indices[i++] = v1;
+            s_indices[i++] = v0 + 1;
+            s_indices[i++] = v1 + 1;
+        }
+    }
+}
+
+// sets the arrays from 'base', a client pointer or a buffer offset
+static void setArrays(const char *base, GLenum posType, GLsizei stride)
+{
+    s_gl.glVertexPointer(3, posType, stride, base + offsetof(Vertex, pos));
+    s_gl.glTexCoordPointer(2, GL_FLOAT, stride, base + offsetof(Vertex, tex));
+    s_gl.glColorPointer(4, GL_UNSIGNED_BYTE, stride, base + offsetof(Vertex, color));
+}
+
+static void bench(const char *name, const GLvoid *indices, int draws,
+                  unsigned int clientBytes, bool rewrite = false)
+{
+    // the first draws convert the GL_FIXED arrays
+    for (int i = 0; i < 2; i++) {
+        s_gl.glDrawElements(GL_TRIANGLES, NUM_INDICES, GL_UNSIGNED_SHORT, indices);
+    }
+    s_gl.glFinish();
+
+    clock_t c0 = clock();
+    long long t0 = GetCurrentTimeUS();
+    for (int i = 0; i < draws; i++) {
+        if (rewrite) {
+            s_fixedVertices[i % NUM_VERTICES].pos[2] ^= 1;
+        }
+        s_gl.glDrawElements(GL_TRIANGLES, NUM_INDICES, GL_UNSIGNED_SHORT, indices);
+    }
+    s_gl.glFinish();
+    double secs = (GetCurrentTimeUS() - t0) / 1000000.0;
+    double cpuSecs = (double)(clock() - c0) / CLOCKS_PER_SEC;
+
+    printf("    %-16s %8.1f us/draw %8.1f CPU us/draw %8u client bytes/draw\n",
+           name, secs * 1000000.0 / draws, cpuSecs * 1000000.0 / draws,
+           clientBytes);
+}
+
+int main(int argc, char *argv[])
+{
+    int draws = DEFAULT_DRAWS;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-soft")) {
+#ifndef _WIN32
+            setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+#endif
+        }
+        else if (!strcmp(argv[i], "-draws") && i + 1 < argc) {
+            draws = atoi(argv[++i]);
+        }
+        else {
+            fprintf(stderr, "Usage: %s [-soft] [-draws <count>]\n", argv[0]);
+            return -1;
+        }
+    }
+    if (draws <= 0) {
+        draws = DEFAULT_DRAWS;
+    }
+
+#ifdef __linux__
+    XInitThreads();
+#endif
+
+    if (!initLibrary()) {
+        fprintf(stderr, "Failed to load the GLES translator libraries\n");
+        return -1;
+    }
+    if (!FrameBuffer::initialize(SURFACE_SIZE, SURFACE_SIZE)) {
+        fprintf(stderr, "Failed to initialize Framebuffer\n");
+        return -1;
+    }
+    FrameBuffer *fb = FrameBuffer::getFB();
+
+    // bindContext keeps the bound objects in the thread info, as it
+    // does for the render threads
+    RenderThreadInfo tinfo;
+    HandleType ctx = fb->createRenderContext(0, 0, false);
+    HandleType win = fb->createWindowSurface(0, SURFACE_SIZE, SURFACE_SIZE);
+    HandleType cb = fb->createColorBuffer(SURFACE_SIZE, SURFACE_SIZE, GL_RGBA);
+    if (!ctx || !win || !cb ||
+        !fb->setWindowSurfaceColorBuffer(win, cb) ||
+        !fb->bindContext(ctx, win, win)) {
+        fprintf(stderr, "Failed to bind a GLES 1.1 context\n");
+        return -1;
+    }
+
+    buildGrid();
+    s_gl.glViewport(0, 0, SURFACE_SIZE, SURFACE_SIZE);
+    s_gl.glEnableClientState(GL_VERTEX_ARRAY);
+    s_gl.glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    s_gl.glEnableClientState(GL_COLOR_ARRAY);
+
+    GLuint buffers[3];
+    s_gl.glGenBuffers(3, buffers);
+    s_gl.glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    s_gl.glBufferData(GL_ARRAY_BUFFER, sizeof(s_vertices), s_vertices, GL_STATIC_DRAW);
+    s_gl.glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+    s_gl.glBufferData(GL_ARRAY_BUFFER, sizeof(s_fixedVertices), s_fixedVertices, GL_STATIC_DRAW);
+    s_gl.glBindBuffer(GL_ARRAY_BUFFER, 0);
+    s_gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[2]);
+    s_gl.glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(s_indices), s_indices, GL_STATIC_DRAW);
+    s_gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    printf("%d vertices of %d bytes, %d indices, %d draws\n",
+           NUM_VERTICES, (int)sizeof(Vertex), NUM_INDICES, draws);
+
+    setArrays((const char *)s_vertices, GL_FLOAT, sizeof(Vertex));
+    bench("client float", s_indices, draws,
+          sizeof(s_vertices) + sizeof(s_indices));
+
+    setArrays((const char *)s_fixedVertices, GL_FIXED, sizeof(FixedVertex));
+    bench("client fixed", s_indices, draws,
+          sizeof(s_fixedVertices) + sizeof(s_indices));
+    bench("client rewritten", s_indices, draws,
+          sizeof(s_fixedVertices) + sizeof(s_indices), true);
+
+    s_gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[2]);
+
+    s_gl.glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    setArrays(NULL, GL_FLOAT, sizeof(Vertex));
+    bench("VBO float", NULL, draws, 0);
+
+    s_gl.glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+    setArrays(NULL, GL_FIXED, sizeof(FixedVertex));
+    bench("VBO fixed", NULL, draws, 0);
+
+    s_gl.glBindBuffer(GL_ARRAY_BUFFER, 0);
+    s_gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    s_gl.glDeleteBuffers(3, buffers);
+
+    fb->bindContext(0, 0, 0);
+    fb->DestroyWindowSurface(win);
+    fb->DestroyRenderContext(ctx);
+    fb->closeColorBuffer(cb);
+    FrameBuffer::finalize();
+    return 0;
+}
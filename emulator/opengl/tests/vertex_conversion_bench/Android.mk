@@ -0,0 +1,10 @@
+LOCAL_PATH:=$(call my-dir)
+
+# Host benchmark of the translator's vertex conversion kernels, see
+# vertex_conversion_bench.cpp
+$(call emugl-begin-host-executable,vertex_conversion_bench)
+$(call emugl-import,libGLcommon libOpenglCodecCommon)
+
+LOCAL_SRC_FILES := vertex_conversion_bench.cpp
+
+$(call emugl-end-module)
@@ -0,0 +1,209 @@
+/*
+* Copyright (C) 2011 The Android Open Source Project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+//
+// vertex_conversion_bench - runs each of the GL_FIXED and GL_BYTE vertex
+// conversion kernels this CPU has on the array shapes of GLES 1.1 apps:
+// packed and interleaved arrays of 2 to 4 components, converted directly
+// or through indices. The output of each kernel is checked against the
+// plain loops, and the time is given per million vertices along with
+// the speedup over the loops.
+//
+// Usage: vertex_conversion_bench [-vertices <count>] [-loops <count>]
+//
+#include <GLcommon/VertexConversion.h>
+#include "TimeUtils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_VERTICES    4096
+#define DEFAULT_LOOPS       500
+#define MAX_CONVERSIONS     8
+
+// stride of the interleaved arrays: position, normal, texcoord, color
+#define INTERLEAVED_STRIDE  48
+
+enum CaseKind {
+    FIXED_DIRECT,
+    FIXED_INDIRECT,
+    BYTE_DIRECT,
+    BYTE_INDIRECT
+};
+
+struct Case {
+    const char *name;
+    CaseKind kind;
+    int attribSize;
+    bool interleaved;
+};
+
+static const Case s_cases[] = {
+    { "fixed direct 2",         FIXED_DIRECT,   2, false },
+    { "fixed direct 3",         FIXED_DIRECT,   3, false },
+    { "fixed direct 4",         FIXED_DIRECT,   4, false },
+    { "fixed direct 2 inter",   FIXED_DIRECT,   2, true },
+    { "fixed direct 3 inter",   FIXED_DIRECT,   3, true },
+    { "fixed direct 4 inter",   FIXED_DIRECT,   4, true },
+    { "fixed indirect 2",       FIXED_INDIRECT, 2, false },
+    { "fixed indirect 3",       FIXED_INDIRECT, 3, false },
+    { "fixed indirect 4",       FIXED_INDIRECT, 4, false },
+    { "byte direct 2",          BYTE_DIRECT,    2, false },
+    { "byte direct 3",          BYTE_DIRECT,    3, false },
+    { "byte direct 4",          BYTE_DIRECT,    4, false },
+    { "byte direct 3 inter",    BYTE_DIRECT,    3, true },
+    { "byte indirect 2",        BYTE_INDIRECT,  2, false },
+    { "byte indirect 3",        BYTE_INDIRECT,  3, false },
+};
+static const int s_numCases = sizeof(s_cases) / sizeof(s_cases[0]);
+
+static void run(const VertexConversion &conv, const Case &c,
+                const char *in, unsigned int stride, void *out,
+                int vertices, const GLushort *indices)
+{
+    unsigned int outStride = c.attribSize *
+        (c.kind == FIXED_DIRECT || c.kind == FIXED_INDIRECT ?
+         sizeof(GLfloat) : sizeof(GLshort));
+    switch (c.kind) {
+    case FIXED_DIRECT:
+        conv.fixedDirect(in, stride, out, vertices, c.attribSize);
+        break;
+    case FIXED_INDIRECT:
+        conv.fixedIndirect(in, stride, out, vertices, GL_UNSIGNED_SHORT,
+                           indices, outStride, c.attribSize);
+        break;
+    case BYTE_DIRECT:
+        conv.byteDirect(in, stride, out, vertices, c.attribSize);
+        break;
+    case BYTE_INDIRECT:
+        conv.byteIndirect(in, stride, out, vertices, GL_UNSIGNED_SHORT,
+                          indices, outStride, c.attribSize);
+        break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int vertices = DEFAULT_VERTICES;
+    int loops = DEFAULT_LOOPS;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-vertices") && i + 1 < argc) {
+            vertices = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-loops") && i + 1 < argc) {
+            loops = atoi(argv[++i]);
+        }
+        else {
+            fprintf(stderr, "Usage: %s [-vertices <count>] [-loops <count>]\n",
+                    argv[0]);
+            return -1;
+        }
+    }
+    // the indices are GLushort
+    if (vertices <= 0 || vertices > 65536) {
+        vertices = DEFAULT_VERTICES;
+    }
+    if (loops <= 0) {
+        loops = DEFAULT_LOOPS;
+    }
+
+    const VertexConversion *convs[MAX_CONVERSIONS];
+    int numConvs = getVertexConversions(convs, MAX_CONVERSIONS);
+    printf("kernels:");
+    for (int k = 0; k < numConvs; k++) {
+        printf(" %s", convs[k]->name);
+    }
+    printf(", %d vertices, %d loops\n", vertices, loops);
+
+    // the largest input is an interleaved array, the largest output 4
+    // floats a vertex
+    size_t inSize = (size_t)vertices * INTERLEAVED_STRIDE;
+    size_t outSize = (size_t)vertices * 4 * sizeof(GLfloat);
+    char *in = (char *)malloc(inSize);
+    char *ref = (char *)malloc(outSize);
+    char *out = (char *)malloc(outSize);
+    GLushort *indices = (GLushort *)malloc(vertices * sizeof(GLushort));
+    if (!in || !ref || !out || !indices) {
+        fprintf(stderr, "Out of memory\n");
+        return -1;
+    }
+    srand(1);
+    for (size_t i = 0; i < inSize; i++) {
+        in[i] = (char)rand();
+    }
+    // each vertex once, in the order of a mesh strip: mostly forward
+    // with jumps back
+    for (int i = 0; i < vertices; i++) {
+        indices[i] = (GLushort)((i * 7) % vertices);
+    }
+    if (vertices % 7 == 0) {
+        for (int i = 0; i < vertices; i++) {
+            indices[i] = (GLushort)i;
+        }
+    }
+
+    printf("%-22s", "");
+    for (int k = 0; k < numConvs; k++) {
+        printf(" %16s", convs[k]->name);
+    }
+    printf("    (ms per million vertices, speedup)\n");
+
+    int failures = 0;
+    for (int t = 0; t < s_numCases; t++) {
+        const Case &c = s_cases[t];
+        unsigned int compSize = (c.kind == FIXED_DIRECT || c.kind == FIXED_INDIRECT) ?
+                                sizeof(GLfixed) : sizeof(GLbyte);
+        unsigned int stride = c.interleaved ? INTERLEAVED_STRIDE : c.attribSize * compSize;
+
+        memset(ref, 0, outSize);
+        run(*convs[0], c, in, stride, ref, vertices, indices);
+
+        printf("%-22s", c.name);
+        double loopsTime = 0.0;
+        for (int k = 0; k < numConvs; k++) {
+            memset(out, 0, outSize);
+            run(*convs[k], c, in, stride, out, vertices, indices);
+            if (memcmp(out, ref, outSize)) {
+                printf(" %16s", "MISMATCH");
+                failures++;
+                continue;
+            }
+
+            long long t0 = GetCurrentTimeUS();
+            for (int i = 0; i < loops; i++) {
+                run(*convs[k], c, in, stride, out, vertices, indices);
+            }
+            double us = (double)(GetCurrentTimeUS() - t0);
+            double msPerMillion = us / 1000.0 / loops * (1000000.0 / vertices);
+            if (k == 0) {
+                loopsTime = msPerMillion;
+            }
+            printf(" %9.3f %5.1fx", msPerMillion,
+                   msPerMillion > 0.0 ? loopsTime / msPerMillion : 0.0);
+        }
+        printf("\n");
+    }
+
+    free(in);
+    free(ref);
+    free(out);
+    free(indices);
+    if (failures) {
+        fprintf(stderr, "%d kernels disagree with the plain loops\n", failures);
+        return -1;
+    }
+    return 0;
+}